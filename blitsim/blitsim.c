@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <hardware/intbits.h>
+#include <clib/exec_protos.h>
+#include <clib/graphics_protos.h>
+#include <clib/dos_protos.h>
+#include "blitsim.h"
+
+struct Custom custom;
+struct BlitSimStats blitsim_stats;
+
+// interrupt vectors set with SetIntVector()
+static struct Interrupt *int_vectors[16];
+
+/* Memory is accessed big endian, just like on the Amiga */
+static UWORD read_word(UBYTE *p)
+{
+    blitsim_stats.reads++;
+    return (p[0] << 8) | p[1];
+}
+
+static void write_word(UBYTE *p, UWORD value)
+{
+    blitsim_stats.writes++;
+    p[0] = value >> 8;
+    p[1] = value & 0xff;
+}
+
+// the blitter ignores bit 0 of its pointers
+static UBYTE *even(APTR p)
+{
+    return (UBYTE *) ((uintptr_t) p & ~(uintptr_t) 1);
+}
+
+static UWORD minterm(UBYTE lf, UWORD a, UWORD b, UWORD c)
+{
+    UWORD d = 0;
+    if (lf & 0x80) d |= a & b & c;
+    if (lf & 0x40) d |= a & b & ~c;
+    if (lf & 0x20) d |= a & ~b & c;
+    if (lf & 0x10) d |= a & ~b & ~c;
+    if (lf & 0x08) d |= ~a & b & c;
+    if (lf & 0x04) d |= ~a & b & ~c;
+    if (lf & 0x02) d |= ~a & ~b & c;
+    if (lf & 0x01) d |= ~a & ~b & ~c;
+    return d;
+}
+
+/*
+ * Fill from right to left (bit 0 to bit 15), every set bit toggles the
+ * fill carry. Inclusive fill keeps the edge bits, exclusive fill replaces
+ * each bit with the carry after toggling, so the left edges disappear.
+ */
+static UWORD fill(UWORD d, UWORD bltcon1, int *carry)
+{
+    UWORD result = 0;
+    for (int i = 0; i < 16; i++) {
+        UWORD bit = d & (1 << i);
+        if (bit) *carry = !*carry;
+        if (bltcon1 & BLTCON1_IFE) {
+            if (bit || *carry) result |= 1 << i;
+        } else if (*carry) {
+            result |= 1 << i;
+        }
+    }
+    return result;
+}
+
+/*
+ * Shifts the current word with the previous word of the channel:
+ * ascending blits shift right, descending blits shift left
+ */
+static UWORD shift(UWORD curr, UWORD prev, int amount, BOOL desc)
+{
+    if (desc) return (UWORD) ((((ULONG) curr << 16 | prev) << amount) >> 16);
+    return (UWORD) (((ULONG) prev << 16 | curr) >> amount);
+}
+
+static void area_blit(void)
+{
+    UWORD con0 = custom.bltcon0, con1 = custom.bltcon1;
+    BOOL desc = (con1 & BLTCON1_DESC) != 0;
+    BOOL do_fill = (con1 & (BLTCON1_IFE | BLTCON1_EFE)) != 0;
+    int ash = con0 >> 12, bsh = con1 >> 12;
+    int height = custom.bltsize >> 6, width = custom.bltsize & 0x3f;
+    int step = desc ? -2 : 2;
+    UBYTE *apt = even(custom.bltapt), *bpt = even(custom.bltbpt);
+    UBYTE *cpt = even(custom.bltcpt), *dpt = even(custom.bltdpt);
+    // the data registers hold the values of disabled channels
+    UWORD a = custom.bltadat, b = custom.bltbdat, c = custom.bltcdat;
+    UWORD a_prev = 0, b_prev = 0;
+    BOOL zero = TRUE;
+
+    if (height == 0) height = 1024;
+    if (width == 0) width = 64;
+
+    for (int y = 0; y < height; y++) {
+        int carry = (con1 & BLTCON1_FCI) != 0;
+        for (int x = 0; x < width; x++) {
+            if (con0 & BLTCON0_USEA) { a = read_word(apt); apt += step; }
+            if (con0 & BLTCON0_USEB) { b = read_word(bpt); bpt += step; }
+            if (con0 & BLTCON0_USEC) { c = read_word(cpt); cpt += step; }
+
+            UWORD masked_a = a;
+            if (x == 0) masked_a &= custom.bltafwm;
+            if (x == width - 1) masked_a &= custom.bltalwm;
+
+            UWORD d = minterm(con0 & 0xff, shift(masked_a, a_prev, ash, desc),
+                              shift(b, b_prev, bsh, desc), c);
+            a_prev = masked_a;
+            b_prev = b;
+            if (do_fill) d = fill(d, con1, &carry);
+            if (d) zero = FALSE;
+            if (con0 & BLTCON0_USED) {
+                write_word(dpt, d);
+                dpt += step;
+            }
+            blitsim_stats.words++;
+        }
+        if (con0 & BLTCON0_USEA) apt += desc ? -custom.bltamod : custom.bltamod;
+        if (con0 & BLTCON0_USEB) bpt += desc ? -custom.bltbmod : custom.bltbmod;
+        if (con0 & BLTCON0_USEC) cpt += desc ? -custom.bltcmod : custom.bltcmod;
+        if (con0 & BLTCON0_USED) dpt += desc ? -custom.bltdmod : custom.bltdmod;
+    }
+    custom.bltapt = apt;
+    custom.bltbpt = bpt;
+    custom.bltcpt = cpt;
+    custom.bltdpt = dpt;
+    custom.bltddat = 0;
+    if (zero) custom.dmaconr |= DMACONR_BZERO;
+    else custom.dmaconr &= ~DMACONR_BZERO;
+}
+
+/*
+ * Line mode: bltsize height is the number of pixels, channel C reads the
+ * destination, D writes it. The first pixel goes to bltdpt, all others to
+ * the position in bltcpt. The low word of bltapt is the error accumulator,
+ * bltamod and bltbmod are added to it depending on its sign.
+ */
+static void line_blit(void)
+{
+    UWORD con0 = custom.bltcon0, con1 = custom.bltcon1;
+    int ash = con0 >> 12, bsh = con1 >> 12;
+    int length = custom.bltsize >> 6;
+    WORD acc = (WORD) (uintptr_t) custom.bltapt;
+    BOOL sign = (con1 & BLTCON1_SIGN) != 0;
+    BOOL sud = (con1 & 0x10) != 0, sul = (con1 & 0x08) != 0, aul = (con1 & 0x04) != 0;
+    BOOL single = (con1 & BLTCON1_SING) != 0;
+    BOOL dot_in_row = FALSE;
+    UBYTE *cpt = even(custom.bltcpt), *dpt = even(custom.bltdpt);
+    BOOL zero = TRUE;
+
+    if (length == 0) length = 1024;
+
+    for (int i = 0; i < length; i++) {
+        UWORD a = (UWORD) (custom.bltadat >> ash);
+        UWORD b = ((((ULONG) custom.bltbdat << 16) | custom.bltbdat) >> bsh) & 1 ? 0xffff : 0;
+        if (single && dot_in_row) a = 0;
+        UWORD c = read_word(cpt);
+        UWORD d = minterm(con0 & 0xff, a, b, c);
+        if (d) zero = FALSE;
+        write_word(dpt, d);
+        if (a) dot_in_row = TRUE;
+        blitsim_stats.words++;
+
+        // step along the major axis, and along the minor axis if the
+        // accumulator is not negative
+        BOOL minor = !sign;
+        acc += sign ? custom.bltbmod : custom.bltamod;
+        sign = acc < 0;
+
+        BOOL step_x = sud || minor, step_y = !sud || minor;
+        BOOL left = sud ? aul : sul, up = sud ? sul : aul;
+        if (step_x) {
+            if (left) {
+                if (--ash < 0) { ash = 15; cpt -= 2; }
+            } else if (++ash > 15) {
+                ash = 0;
+                cpt += 2;
+            }
+        }
+        if (step_y) {
+            cpt += up ? -custom.bltcmod : custom.bltcmod;
+            dot_in_row = FALSE;
+        }
+        bsh = (bsh - 1) & 15;
+        dpt = cpt;
+    }
+    custom.bltapt = (APTR) (uintptr_t) (UWORD) acc;
+    custom.bltcpt = cpt;
+    custom.bltdpt = dpt;
+    custom.bltcon0 = (con0 & 0x0fff) | (ash << 12);
+    custom.bltcon1 = (con1 & ~(0xf000 | BLTCON1_SIGN)) | (bsh << 12) | (sign ? BLTCON1_SIGN : 0);
+    if (zero) custom.dmaconr |= DMACONR_BZERO;
+    else custom.dmaconr &= ~DMACONR_BZERO;
+}
+
+/**
+ * Performs the blit that is described by the current register values.
+ */
+void blitsim_blit(void)
+{
+    blitsim_stats.blits++;
+    if (custom.bltcon1 & BLTCON1_LINE) {
+        blitsim_stats.line_blits++;
+        line_blit();
+    } else {
+        area_blit();
+    }
+}
+
+/**
+ * Performs the pending blit, if bltsize was written since the last one.
+ * A bltsize value of 0 (1024 lines, 64 words) can therefore not be used.
+ */
+void blitsim_sync(void)
+{
+    if (custom.bltsize) {
+        blitsim_blit();
+        custom.bltsize = 0;
+    }
+}
+
+/**
+ * Runs the blitter until it is idle: performs the pending blit and calls
+ * the blitter interrupt vector, which can start the next blit.
+ */
+void blitsim_complete_blits(void)
+{
+    while (custom.bltsize) {
+        blitsim_sync();
+        struct Interrupt *vector = int_vectors[INTB_BLIT];
+        if (vector) ((void (*)(APTR)) vector->is_Code)(vector->is_Data);
+    }
+}
+
+/**
+ * Clears all registers and counters.
+ */
+void blitsim_reset(void)
+{
+    memset(&custom, 0, sizeof(struct Custom));
+    memset(&blitsim_stats, 0, sizeof(struct BlitSimStats));
+}
+
+/*
+ * Host versions of the system functions that blitter code uses
+ */
+void WaitBlit(void) { blitsim_sync(); }
+void OwnBlitter(void) {}
+void DisownBlitter(void) { blitsim_sync(); }
+
+APTR AllocMem(ULONG size, ULONG flags)
+{
+    return (flags & MEMF_CLEAR) ? calloc(1, size) : malloc(size);
+}
+
+void FreeMem(APTR memory, ULONG size) { free(memory); }
+void CopyMem(APTR source, APTR dest, ULONG size) { memmove(dest, source, size); }
+void Disable(void) {}
+void Enable(void) {}
+void Forbid(void) {}
+void Permit(void) {}
+
+struct Interrupt *SetIntVector(LONG int_number, struct Interrupt *interrupt)
+{
+    struct Interrupt *old = int_vectors[int_number];
+    int_vectors[int_number] = interrupt;
+    return old;
+}
+
+void AddIntServer(LONG int_number, struct Interrupt *interrupt) {}
+void RemIntServer(LONG int_number, struct Interrupt *interrupt) {}
+
+BPTR Open(CONST_STRPTR name, LONG mode)
+{
+    FILE *fp = fopen(name, mode == MODE_OLDFILE ? "rb" : mode == MODE_NEWFILE ? "wb" : "r+b");
+    return (BPTR) fp;
+}
+
+LONG Close(BPTR file) { return fclose((FILE *) file) == 0; }
+
+LONG Read(BPTR file, APTR buffer, LONG length)
+{
+    size_t n = fread(buffer, 1, length, (FILE *) file);
+    return ferror((FILE *) file) ? -1 : (LONG) n;
+}
+
+LONG Write(BPTR file, APTR buffer, LONG length)
+{
+    size_t n = fwrite(buffer, 1, length, (FILE *) file);
+    return ferror((FILE *) file) ? -1 : (LONG) n;
+}
+
+// returns the previous position like dos.library
+LONG Seek(BPTR file, LONG position, LONG mode)
+{
+    FILE *fp = (FILE *) file;
+    LONG old = ftell(fp);
+    int whence = mode == OFFSET_BEGINNING ? SEEK_SET : mode == OFFSET_END ? SEEK_END : SEEK_CUR;
+    return fseek(fp, position, whence) ? -1 : old;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef __BLITSIM_H__
+#define __BLITSIM_H__
+
+#include <exec/types.h>
+#include <hardware/custom.h>
+
+/*
+ * Bit exact host model of the Amiga blitter (OCS).
+ *
+ * Blitter code is compiled on the host against the headers in
+ * blitsim/include instead of the NDK, so it writes its register values
+ * into the global custom structure. Writing bltsize marks a blit as
+ * pending, it is performed by the next WaitBlit() or blitsim_sync(), which
+ * is where blitter code waits anyway. The blit then reads and writes host
+ * memory through the pointer registers, so the output bitmaps can be
+ * compared byte for byte against reference data.
+ *
+ * Modelled: channels A-D with their data registers, A and B shifts, first
+ * and last word masks, all 256 minterms, ascending and descending mode,
+ * inclusive and exclusive fill with fill carry input, line mode with
+ * octants, texture and single bit mode, the BZERO flag in dmaconr and
+ * the final pointer register values.
+ * Interrupt driven blitter code can be run with blitsim_complete_blits(),
+ * which performs the pending blit and calls the INTB_BLIT vector that was
+ * set with SetIntVector() until no blit is pending.
+ * Not modelled: timing, bus contention and the line mode quirks of
+ * lines with dmax = 0.
+ */
+#define BLTCON0_USEA (0x0800)
+#define BLTCON0_USEB (0x0400)
+#define BLTCON0_USEC (0x0200)
+#define BLTCON0_USED (0x0100)
+#define BLTCON1_LINE (0x0001)
+#define BLTCON1_DESC (0x0002)
+#define BLTCON1_FCI  (0x0004)
+#define BLTCON1_IFE  (0x0008)
+#define BLTCON1_EFE  (0x0010)
+#define BLTCON1_SING (0x0002)  // line mode
+#define BLTCON1_SIGN (0x0040)  // line mode
+#define DMACONR_BZERO (0x2000)
+
+// counters for benchmarking blit paths
+struct BlitSimStats {
+    ULONG blits;
+    ULONG line_blits;
+    ULONG words;   // words processed, in line mode: pixels
+    ULONG reads;   // words read by channels A, B and C
+    ULONG writes;  // words written by channel D
+};
+
+extern struct Custom custom;
+extern struct BlitSimStats blitsim_stats;
+
+extern void blitsim_reset(void);
+extern void blitsim_sync(void);
+extern void blitsim_blit(void);
+extern void blitsim_complete_blits(void);
+
+#endif /* __BLITSIM_H__ */
@@ -0,0 +1,15 @@
+#pragma once
+#ifndef __BLITSIM_CLIB_DOS_PROTOS_H__
+#define __BLITSIM_CLIB_DOS_PROTOS_H__
+
+#include <exec/types.h>
+#include <dos/dos.h>
+
+// unbuffered file access on top of stdio
+extern BPTR Open(CONST_STRPTR name, LONG mode);
+extern LONG Close(BPTR file);
+extern LONG Read(BPTR file, APTR buffer, LONG length);
+extern LONG Write(BPTR file, APTR buffer, LONG length);
+extern LONG Seek(BPTR file, LONG position, LONG mode);
+
+#endif /* __BLITSIM_CLIB_DOS_PROTOS_H__ */
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef __BLITSIM_CLIB_EXEC_PROTOS_H__
+#define __BLITSIM_CLIB_EXEC_PROTOS_H__
+
+#include <exec/types.h>
+#include <exec/memory.h>
+#include <exec/interrupts.h>
+
+extern APTR AllocMem(ULONG size, ULONG flags);
+extern void FreeMem(APTR memory, ULONG size);
+extern void CopyMem(APTR source, APTR dest, ULONG size);
+extern void Disable(void);
+extern void Enable(void);
+extern void Forbid(void);
+extern void Permit(void);
+// SetIntVector() records the vector for blitsim_complete_blits(),
+// interrupt servers are never called
+extern struct Interrupt *SetIntVector(LONG int_number, struct Interrupt *interrupt);
+extern void AddIntServer(LONG int_number, struct Interrupt *interrupt);
+extern void RemIntServer(LONG int_number, struct Interrupt *interrupt);
+
+#endif /* __BLITSIM_CLIB_EXEC_PROTOS_H__ */
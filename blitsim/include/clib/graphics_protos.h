@@ -0,0 +1,12 @@
+#pragma once
+#ifndef __BLITSIM_CLIB_GRAPHICS_PROTOS_H__
+#define __BLITSIM_CLIB_GRAPHICS_PROTOS_H__
+
+#include <exec/types.h>
+
+// performs the pending blit
+extern void WaitBlit(void);
+extern void OwnBlitter(void);
+extern void DisownBlitter(void);
+
+#endif /* __BLITSIM_CLIB_GRAPHICS_PROTOS_H__ */
@@ -0,0 +1,24 @@
+#pragma once
+#ifndef __BLITSIM_DOS_DOS_H__
+#define __BLITSIM_DOS_DOS_H__
+
+#include <stdint.h>
+#include <exec/types.h>
+
+/*
+ * Host replacement for the NDK's dos/dos.h. A file handle holds a host
+ * FILE pointer, so BPTR is as wide as a host pointer.
+ */
+typedef intptr_t BPTR;
+
+#define MODE_OLDFILE (1005)
+#define MODE_NEWFILE (1006)
+#define MODE_READWRITE (1004)
+
+#define OFFSET_BEGINNING (-1)
+#define OFFSET_CURRENT   (0)
+#define OFFSET_END       (1)
+
+#define SIGBREAKF_CTRL_C (1L << 12)
+
+#endif /* __BLITSIM_DOS_DOS_H__ */
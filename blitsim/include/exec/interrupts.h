@@ -0,0 +1,13 @@
+#pragma once
+#ifndef __BLITSIM_EXEC_INTERRUPTS_H__
+#define __BLITSIM_EXEC_INTERRUPTS_H__
+
+#include <exec/nodes.h>
+
+struct Interrupt {
+    struct Node is_Node;
+    APTR is_Data;
+    void (*is_Code)(void);
+};
+
+#endif /* __BLITSIM_EXEC_INTERRUPTS_H__ */
@@ -0,0 +1,13 @@
+#pragma once
+#ifndef __BLITSIM_EXEC_MEMORY_H__
+#define __BLITSIM_EXEC_MEMORY_H__
+
+#include <exec/types.h>
+
+#define MEMF_ANY    (0L)
+#define MEMF_PUBLIC (1L << 0)
+#define MEMF_CHIP   (1L << 1)
+#define MEMF_FAST   (1L << 2)
+#define MEMF_CLEAR  (1L << 16)
+
+#endif /* __BLITSIM_EXEC_MEMORY_H__ */
@@ -0,0 +1,16 @@
+#pragma once
+#ifndef __BLITSIM_EXEC_NODES_H__
+#define __BLITSIM_EXEC_NODES_H__
+
+#include <exec/types.h>
+
+struct Node {
+    struct Node *ln_Succ, *ln_Pred;
+    UBYTE ln_Type;
+    BYTE ln_Pri;
+    char *ln_Name;
+};
+
+#define NT_INTERRUPT (2)
+
+#endif /* __BLITSIM_EXEC_NODES_H__ */
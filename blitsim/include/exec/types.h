@@ -0,0 +1,33 @@
+#pragma once
+#ifndef __BLITSIM_EXEC_TYPES_H__
+#define __BLITSIM_EXEC_TYPES_H__
+
+/*
+ * Host replacement for the NDK's exec/types.h, the sizes match the Amiga.
+ * vbcc specific keywords are removed.
+ */
+#include <stdint.h>
+
+typedef void *APTR;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int16_t WORD;
+typedef uint16_t UWORD;
+typedef int8_t BYTE;
+typedef uint8_t UBYTE;
+typedef int16_t BOOL;
+typedef char *STRPTR;
+typedef const char *CONST_STRPTR;
+
+#ifndef TRUE
+#define TRUE  (1)
+#define FALSE (0)
+#endif
+#ifndef NULL
+#define NULL ((void *) 0)
+#endif
+
+#define __chip
+#define __reg(x)
+
+#endif /* __BLITSIM_EXEC_TYPES_H__ */
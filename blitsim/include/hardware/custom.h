@@ -0,0 +1,48 @@
+#pragma once
+#ifndef __BLITSIM_HARDWARE_CUSTOM_H__
+#define __BLITSIM_HARDWARE_CUSTOM_H__
+
+#include <exec/types.h>
+
+/*
+ * Host replacement for the custom chip register file. The field names
+ * match the NDK, the layout does not. Writing bltsize does not start the
+ * blit, it is performed by the next WaitBlit() or blitsim_sync() call.
+ */
+struct AudChannel {
+    UWORD *ac_ptr;
+    UWORD ac_len;
+    UWORD ac_per;
+    UWORD ac_vol;
+    UWORD ac_dat;
+};
+
+struct Custom {
+    UWORD bltddat;
+    UWORD dmaconr;
+    UWORD vposr;
+    UWORD vhposr;
+    UWORD intenar;
+    UWORD intreqr;
+    UWORD clxcon, clxdat;
+
+    UWORD bltcon0, bltcon1;
+    UWORD bltafwm, bltalwm;
+    APTR bltcpt, bltbpt, bltapt, bltdpt;
+    UWORD bltsize;
+    WORD bltcmod, bltbmod, bltamod, bltdmod;
+    UWORD bltcdat, bltbdat, bltadat;
+
+    APTR cop1lc, cop2lc;
+    UWORD copjmp1, copjmp2;
+    UWORD diwstrt, diwstop, ddfstrt, ddfstop;
+    UWORD dmacon, intena, intreq;
+    struct AudChannel aud[4];
+    APTR bplpt[8];
+    UWORD bplcon0, bplcon1, bplcon2, bplcon3;
+    WORD bpl1mod, bpl2mod;
+    APTR sprpt[8];
+    UWORD color[32];
+};
+
+#endif /* __BLITSIM_HARDWARE_CUSTOM_H__ */
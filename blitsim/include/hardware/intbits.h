@@ -0,0 +1,25 @@
+#pragma once
+#ifndef __BLITSIM_HARDWARE_INTBITS_H__
+#define __BLITSIM_HARDWARE_INTBITS_H__
+
+#define INTB_SETCLR (15)
+#define INTB_INTEN  (14)
+#define INTB_BLIT   (6)
+#define INTB_VERTB  (5)
+#define INTB_COPER  (4)
+#define INTB_AUD0   (7)
+#define INTB_AUD1   (8)
+#define INTB_AUD2   (9)
+#define INTB_AUD3   (10)
+
+#define INTF_SETCLR (1 << INTB_SETCLR)
+#define INTF_INTEN  (1 << INTB_INTEN)
+#define INTF_BLIT   (1 << INTB_BLIT)
+#define INTF_VERTB  (1 << INTB_VERTB)
+#define INTF_COPER  (1 << INTB_COPER)
+#define INTF_AUD0   (1 << INTB_AUD0)
+#define INTF_AUD1   (1 << INTB_AUD1)
+#define INTF_AUD2   (1 << INTB_AUD2)
+#define INTF_AUD3   (1 << INTB_AUD3)
+
+#endif /* __BLITSIM_HARDWARE_INTBITS_H__ */
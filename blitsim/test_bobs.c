@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blitsim.h"
+#include "tilesheet.h"
+#include "bobs.h"
+#include "test_util.h"
+
+/*
+ * Regression test for the bob blits of episode-005: every blit path draws
+ * the bobs of rodland_bobs.ts into the grid background, the result is
+ * compared byte for byte with a reference that is drawn pixel by pixel.
+ * All tests run on non-interleaved and interleaved bitmaps.
+ */
+#define BOBS_FILE "../episode-005/rodland_bobs.ts"
+#define BACKGROUND_FILE "../episode-005/grid_320x256x4.ts"
+
+#define NUM_MANAGER_BOBS (10)
+#define NUM_MANAGER_FRAMES (40)
+#define NUM_COLLISION_TESTS (4000)
+
+static int failures;
+
+// the byte that contains pixel x, the mask is plane bmdepth
+static UBYTE *pixel_byte(struct Ratr0TileSheet *sheet, int plane, int x, int y)
+{
+    struct Ratr0TileSheetHeader *h = &sheet->header;
+    int row_bytes = h->width / 8;
+    if (h->flags & TSFLAGS_NON_INTERLEAVED) {
+        return sheet->imgdata + (plane * h->height + y) * row_bytes + x / 8;
+    }
+    // interleaved: the mask rows follow the image, use the first copy
+    if (plane == h->bmdepth) {
+        return sheet->imgdata + (h->height + y) * h->bmdepth * row_bytes + x / 8;
+    }
+    return sheet->imgdata + (y * h->bmdepth + plane) * row_bytes + x / 8;
+}
+
+static int get_bit(struct Ratr0TileSheet *sheet, int plane, int x, int y)
+{
+    return (*pixel_byte(sheet, plane, x, y) >> (7 - (x & 7))) & 1;
+}
+
+static void set_bit(struct Ratr0TileSheet *sheet, int plane, int x, int y, int value)
+{
+    UBYTE *p = pixel_byte(sheet, plane, x, y);
+    UBYTE bit = 0x80 >> (x & 7);
+    *p = value ? *p | bit : *p & ~bit;
+}
+
+/*
+ * Draws a bob pixel by pixel: the pixels of the object whose mask bit is
+ * set replace the background, clipped at the clip rectangle.
+ */
+static void draw_reference(struct Ratr0TileSheet *dst, struct Ratr0TileSheet *bobs,
+                           int tilex, int tiley, int dstx, int dsty,
+                           struct Ratr0ClipRect *clip)
+{
+    struct Ratr0TileSheetHeader *h = &bobs->header;
+    for (int r = 0; r < h->tile_height; r++) {
+        for (int i = 0; i < h->tile_width - SHIFT_PADDING; i++) {
+            int sx = tilex * h->tile_width + i, sy = tiley * h->tile_height + r;
+            int x = dstx + i, y = dsty + r;
+            if (x < clip->x0 || x >= clip->x1 || y < clip->y0 || y >= clip->y1) continue;
+            if (!get_bit(bobs, h->bmdepth, sx, sy)) continue;
+            for (int p = 0; p < h->bmdepth; p++) set_bit(dst, p, x, y, get_bit(bobs, p, sx, sy));
+        }
+    }
+}
+
+enum BlitPath { PATH_OBJECT, PATH_PRESHIFTED, PATH_CLIPPED };
+
+static int check_blit(const char *name, enum BlitPath path,
+                      struct Ratr0TileSheet *bobs, struct Ratr0PreshiftCache *cache,
+                      struct Ratr0TileSheet *bg, struct Ratr0TileSheet *expected,
+                      UBYTE *original, int tilex, int dstx, int dsty,
+                      struct Ratr0ClipRect *clip)
+{
+    ULONG size = bg->header.imgdata_size;
+    memcpy(bg->imgdata, original, size);
+    memcpy(expected->imgdata, original, size);
+    if (path == PATH_OBJECT) ratr0_blit_object(bobs, bg, tilex, 0, dstx, dsty);
+    else if (path == PATH_PRESHIFTED) ratr0_blit_preshifted_object(cache, bg, tilex, 0, dstx, dsty);
+    else ratr0_blit_object_clipped(bobs, bg, tilex, 0, dstx, dsty, clip);
+    draw_reference(expected, bobs, tilex, 0, dstx, dsty, clip);
+    if (test_compare(name, bg->imgdata, expected->imgdata, size)) {
+        printf("  tile %d at %d, %d\n", tilex, dstx, dsty);
+        return 1;
+    }
+    return 0;
+}
+
+static void test_blit_paths(struct Ratr0TileSheet *bobs, struct Ratr0TileSheet *bg,
+                            struct Ratr0TileSheet *expected, UBYTE *original,
+                            const char *layout)
+{
+    struct Ratr0ClipRect screen = { 0, 0, bg->header.width, bg->header.height };
+    struct Ratr0ClipRect clip = { 37, 21, 283, 230 };
+    struct Ratr0PreshiftCache cache;
+    char name[64];
+    int w = bobs->header.tile_width - SHIFT_PADDING;
+
+    if (!ratr0_preshift_tilesheet(&cache, bobs)) {
+        puts("FAIL could not build the pre-shift cache");
+        failures++;
+        return;
+    }
+    for (int path = PATH_OBJECT; path <= PATH_PRESHIFTED; path++) {
+        snprintf(name, sizeof(name), "%s %s", path == PATH_OBJECT ? "blit_object" : "preshifted", layout);
+        blitsim_reset();
+        for (int tilex = 0; tilex < bobs->header.num_tiles_h; tilex++) {
+            // all shifts at the left and right border
+            for (int x = 0; x < 48; x++) {
+                failures += check_blit(name, path, bobs, &cache, bg, expected, original,
+                                       tilex, x, 3 + x % 7, &screen);
+                failures += check_blit(name, path, bobs, &cache, bg, expected, original,
+                                       tilex, bg->header.width - w - x, 200 + x % 11, &screen);
+            }
+        }
+        test_print_stats(name);
+    }
+
+    snprintf(name, sizeof(name), "clipped %s", layout);
+    blitsim_reset();
+    for (int tilex = 0; tilex < bobs->header.num_tiles_h; tilex++) {
+        for (int x = 0; x < 48; x++) {
+            // across the edges of the clip rectangle
+            failures += check_blit(name, PATH_CLIPPED, bobs, &cache, bg, expected, original,
+                                   tilex, clip.x0 - w + x, clip.y0 - 20 + x, &clip);
+            failures += check_blit(name, PATH_CLIPPED, bobs, &cache, bg, expected, original,
+                                   tilex, clip.x1 - x, clip.y1 - x, &clip);
+            // across the edges of the screen
+            failures += check_blit(name, PATH_CLIPPED, bobs, &cache, bg, expected, original,
+                                   tilex, x - w, x - 31, &screen);
+        }
+        // clip rectangles that are narrower than the bob, so both clip edges
+        // can cut the same blit, at every clip alignment and bob shift
+        for (int x0 = 64; x0 < 80; x0++) {
+            for (int clip_w = 1; clip_w < w; clip_w += 3) {
+                struct Ratr0ClipRect narrow = { x0, 40, x0 + clip_w, 100 };
+                for (int x = 0; x < w + clip_w; x++) {
+                    failures += check_blit(name, PATH_CLIPPED, bobs, &cache, bg, expected,
+                                           original, tilex, x0 - w + x, 50, &narrow);
+                }
+            }
+        }
+        // bobs at the right screen edge clipped on the left
+        for (int x = 1; x < 16; x++) {
+            struct Ratr0ClipRect right = { bg->header.width - w + x, 0,
+                                           bg->header.width, bg->header.height };
+            failures += check_blit(name, PATH_CLIPPED, bobs, &cache, bg, expected, original,
+                                   tilex, bg->header.width - w, 60, &right);
+        }
+    }
+    test_print_stats(name);
+    ratr0_free_preshift_cache(&cache);
+}
+
+/*
+ * Bob manager: moving bobs with background save and restore on 2 buffers.
+ * After every frame, the drawn buffer has to show the background with all
+ * bobs at their current position.
+ */
+static void test_bob_manager(struct Ratr0TileSheet *bobs, struct Ratr0TileSheet *bg,
+                             struct Ratr0TileSheet *expected, UBYTE *original,
+                             struct Ratr0ClipRect *clip, const char *layout)
+{
+    struct Ratr0TileSheet buffers[2];
+    struct Ratr0Bob mgr_bobs[NUM_MANAGER_BOBS];
+    struct Ratr0PreshiftCache cache;
+    static struct Ratr0BobManager mgr;
+    char name[64];
+    ULONG size = bg->header.imgdata_size;
+
+    memcpy(bg->imgdata, original, size);
+    if (!ratr0_clone_tilesheet(&buffers[0], bg) || !ratr0_clone_tilesheet(&buffers[1], bg) ||
+        !ratr0_preshift_tilesheet(&cache, bobs)) {
+        puts("FAIL could not allocate the bob manager buffers");
+        failures++;
+        return;
+    }
+    for (int i = 0; i < NUM_MANAGER_BOBS; i++) {
+        mgr_bobs[i].sheet = bobs;
+        mgr_bobs[i].cache = (i & 1) ? &cache : NULL;
+        mgr_bobs[i].tilex = i % 4;
+        mgr_bobs[i].tiley = 0;
+        mgr_bobs[i].x = 8 + i * 25;
+        mgr_bobs[i].y = 10 + i * 19;
+        mgr_bobs[i].visible = TRUE;
+    }
+    if (!ratr0_init_bob_manager(&mgr, &buffers[0], &buffers[1], mgr_bobs, NUM_MANAGER_BOBS)) {
+        puts("FAIL could not initialize the bob manager");
+        failures++;
+        return;
+    }
+    mgr.clip = *clip;
+    snprintf(name, sizeof(name), "bob manager %s, clip %d-%d", layout, clip->x0, clip->x1);
+    blitsim_reset();
+    for (int frame = 0; frame < NUM_MANAGER_FRAMES; frame++) {
+        ratr0_render_bobs(&mgr);
+        memcpy(expected->imgdata, original, size);
+        for (int i = 0; i < NUM_MANAGER_BOBS; i++) {
+            draw_reference(expected, bobs, mgr_bobs[i].tilex, 0, mgr_bobs[i].x, mgr_bobs[i].y,
+                           clip);
+        }
+        if (test_compare(name, mgr.buffers[mgr.back]->imgdata, expected->imgdata, size)) {
+            printf("  frame %d\n", frame);
+            failures++;
+            break;
+        }
+        ratr0_swap_bob_buffers(&mgr);
+        for (int i = 0; i < NUM_MANAGER_BOBS; i++) {
+            mgr_bobs[i].x += (i & 2) ? -1 : 1;
+            mgr_bobs[i].y += (frame & 1);
+        }
+    }
+    test_print_stats(name);
+    ratr0_free_bob_manager(&mgr);
+    ratr0_free_preshift_cache(&cache);
+    ratr0_free_tilesheet_data(&buffers[0]);
+    ratr0_free_tilesheet_data(&buffers[1]);
+}
+
+static BOOL masks_overlap(struct Ratr0Bob *a, struct Ratr0Bob *b)
+{
+    struct Ratr0TileSheetHeader *h = &a->sheet->header;
+    int w = h->tile_width - SHIFT_PADDING;
+    for (int y = 0; y < h->tile_height; y++) {
+        for (int x = 0; x < w; x++) {
+            int bx = a->x + x - b->x, by = a->y + y - b->y;
+            if (bx < 0 || bx >= w || by < 0 || by >= h->tile_height) continue;
+            if (get_bit(a->sheet, h->bmdepth, a->tilex * h->tile_width + x, y) &&
+                get_bit(b->sheet, h->bmdepth, b->tilex * h->tile_width + bx, by)) return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void test_collision(struct Ratr0TileSheet *bobs, const char *layout)
+{
+    struct Ratr0Bob a = { bobs, NULL }, b = { bobs, NULL };
+    char name[64];
+    int collisions = 0;
+
+    snprintf(name, sizeof(name), "collision %s", layout);
+    blitsim_reset();
+    srand(1);
+    for (int i = 0; i < NUM_COLLISION_TESTS; i++) {
+        a.tilex = rand() % 4;
+        b.tilex = rand() % 4;
+        a.x = 100 + rand() % 16;
+        a.y = 100;
+        b.x = a.x - 32 + rand() % 64;
+        b.y = a.y - 34 + rand() % 68;
+        BOOL expected = masks_overlap(&a, &b);
+        if (ratr0_bob_collision(&a, &b) != expected) {
+            printf("FAIL %s: tiles %d, %d at %d, %d and %d, %d\n", name,
+                   a.tilex, b.tilex, a.x, a.y, b.x, b.y);
+            failures++;
+            break;
+        }
+        collisions += expected;
+    }
+    test_print_stats(name);
+    printf("  %d of %d pairs collide\n", collisions, NUM_COLLISION_TESTS);
+}
+
+static void run_tests(struct Ratr0TileSheet *bobs, struct Ratr0TileSheet *bg, const char *layout)
+{
+    struct Ratr0TileSheet expected;
+    UBYTE *original = malloc(bg->header.imgdata_size);
+    if (!original || !ratr0_clone_tilesheet(&expected, bg)) {
+        puts("FAIL out of memory");
+        failures++;
+        return;
+    }
+    memcpy(original, bg->imgdata, bg->header.imgdata_size);
+    test_blit_paths(bobs, bg, &expected, original, layout);
+    // a clip rectangle that is not word aligned and one that is narrower
+    // than the bobs
+    struct Ratr0ClipRect clips[] = { { 13, 7, 291, 240 }, { 50, 0, 70, bg->header.height } };
+    for (int i = 0; i < 2; i++) test_bob_manager(bobs, bg, &expected, original, &clips[i], layout);
+    test_collision(bobs, layout);
+    memcpy(bg->imgdata, original, bg->header.imgdata_size);
+    ratr0_free_tilesheet_data(&expected);
+    free(original);
+}
+
+int main(int argc, char **argv)
+{
+    struct Ratr0TileSheet bobs, bg;
+    if (!test_load_tilesheet(BOBS_FILE, &bobs) || !test_load_tilesheet(BACKGROUND_FILE, &bg)) {
+        return 1;
+    }
+    run_tests(&bobs, &bg, "non-interleaved");
+    if (!ratr0_interleave_tilesheet(&bobs) || !ratr0_interleave_tilesheet(&bg)) {
+        puts("FAIL could not interleave the tile sheets");
+        return 1;
+    }
+    run_tests(&bobs, &bg, "interleaved");
+    ratr0_free_tilesheet_data(&bobs);
+    ratr0_free_tilesheet_data(&bg);
+    printf("test_bobs: %d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hardware/custom.h>
+#include "collision.h"
+
+/*
+ * Regression test and benchmark for the collision system of episode-004:
+ * random objects are moved around and the colliding pairs are compared
+ * with a test of all pairs. The average number of box tests shows what
+ * the broadphase saves.
+ */
+#define NUM_OBJECTS (60)
+#define NUM_FRAMES (200)
+#define OBJECT_SIZE (16)
+#define AREA_WIDTH (320)
+#define AREA_HEIGHT (256)
+
+extern struct Custom custom;
+
+static int failures;
+
+static BOOL boxes_overlap(struct Ratr0CollisionObject *a, struct Ratr0CollisionObject *b)
+{
+    return a->x < b->x + (WORD) b->width && b->x < a->x + (WORD) a->width &&
+        a->y < b->y + (WORD) b->height && b->y < a->y + (WORD) a->height;
+}
+
+// compares the pairs with all pairs of overlapping boxes, returns 1 on a mismatch
+static int check_pairs(const char *name, struct Ratr0CollisionSystem *sys,
+                       UWORD num_pairs, int frame)
+{
+    static UBYTE found[NUM_OBJECTS][NUM_OBJECTS];
+    memset(found, 0, sizeof(found));
+    for (int i = 0; i < num_pairs; i++) found[sys->pairs[i].a][sys->pairs[i].b]++;
+    for (int a = 0; a < NUM_OBJECTS; a++) {
+        for (int b = a + 1; b < NUM_OBJECTS; b++) {
+            BOOL expected = boxes_overlap(&sys->objects[a], &sys->objects[b]);
+            if (found[a][b] != expected) {
+                printf("FAIL %s: frame %d, objects %d and %d reported %d times, expected %d\n",
+                       name, frame, a, b, found[a][b], expected);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void test_broadphase(void)
+{
+    static struct Ratr0CollisionObject objects[NUM_OBJECTS];
+    static struct Ratr0CollisionSystem sys;
+    WORD dx[NUM_OBJECTS], dy[NUM_OBJECTS];
+    ULONG box_tests = 0, pairs = 0;
+
+    srand(1);
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        objects[i].x = rand() % (AREA_WIDTH - OBJECT_SIZE);
+        objects[i].y = rand() % (AREA_HEIGHT - OBJECT_SIZE);
+        objects[i].width = objects[i].height = OBJECT_SIZE;
+        objects[i].mask = NULL;
+        objects[i].sprite_pairs = 0;
+        objects[i].flags = COLL_ACTIVE;
+        dx[i] = rand() % 5 - 2;
+        dy[i] = rand() % 5 - 2;
+    }
+    if (!ratr0_init_collision_system(&sys, objects, NUM_OBJECTS, 0, 0,
+                                     AREA_WIDTH, AREA_HEIGHT, 0)) {
+        failures++;
+        return;
+    }
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        UWORD num_pairs = ratr0_detect_collisions(&sys, FALSE);
+        if (sys.dropped) {
+            printf("FAIL broadphase: frame %d dropped %d entries or pairs\n", frame, sys.dropped);
+            failures++;
+            return;
+        }
+        if (check_pairs("broadphase", &sys, num_pairs, frame)) {
+            failures++;
+            return;
+        }
+        box_tests += sys.box_tests;
+        pairs += num_pairs;
+        for (int i = 0; i < NUM_OBJECTS; i++) {
+            objects[i].x += dx[i];
+            objects[i].y += dy[i];
+            if (objects[i].x < 0 || objects[i].x > AREA_WIDTH - OBJECT_SIZE) dx[i] = -dx[i];
+            if (objects[i].y < 0 || objects[i].y > AREA_HEIGHT - OBJECT_SIZE) dy[i] = -dy[i];
+        }
+    }
+    printf("broadphase: %d objects, %lu box tests per frame instead of %d, %lu pairs per frame\n",
+           NUM_OBJECTS, box_tests / NUM_FRAMES, NUM_OBJECTS * (NUM_OBJECTS - 1) / 2,
+           pairs / NUM_FRAMES);
+}
+
+/*
+ * 2 sprites on different pairs: CLXDAT of the displayed frame only decides
+ * if the boxes are at the positions of that frame.
+ */
+static void test_clxdat(void)
+{
+    static struct Ratr0CollisionObject objects[2];
+    static struct Ratr0CollisionSystem sys;
+
+    for (int i = 0; i < 2; i++) {
+        objects[i].x = 100 + i * 8;
+        objects[i].y = 100;
+        objects[i].width = objects[i].height = OBJECT_SIZE;
+        objects[i].mask = NULL;
+        objects[i].sprite_pairs = 1 << i;
+        objects[i].flags = COLL_ACTIVE;
+    }
+    custom.clxdat = 0;
+    ratr0_init_collision_system(&sys, objects, 2, 0, 0, AREA_WIDTH, AREA_HEIGHT, 0);
+
+    // the displayed frame had no collision and the boxes are from that frame
+    if (ratr0_detect_collisions(&sys, TRUE) != 0) {
+        puts("FAIL clxdat: a collision was reported that the hardware did not see");
+        failures++;
+    }
+    // the objects have moved into each other since the displayed frame
+    if (ratr0_detect_collisions(&sys, FALSE) != 1) {
+        puts("FAIL clxdat: a collision at the new positions was not reported");
+        failures++;
+    }
+    // the hardware reports the collision of sprite pairs 0 and 1
+    custom.clxdat = 0x0200;
+    if (ratr0_detect_collisions(&sys, TRUE) != 1) {
+        puts("FAIL clxdat: the collision of the displayed frame was not reported");
+        failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    test_broadphase();
+    test_clxdat();
+    printf("test_collision: %d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blitsim.h"
+#include "tilesheet.h"
+#include "blit_draw.h"
+#include "test_util.h"
+
+/*
+ * Regression test for line mode and fill mode: ratr0_draw_line() and
+ * ratr0_area_fill() of episode-006 and copy_mem() of episode-005 draw into
+ * a bitmap filled with random data, the result is compared byte for byte
+ * with a reference drawn pixel by pixel.
+ */
+#define WIDTH (320)
+#define HEIGHT (256)
+#define DEPTH (2)
+#define ROW_BYTES (WIDTH / 8)
+#define PLANE_SIZE (ROW_BYTES * HEIGHT)
+#define BITMAP_SIZE (PLANE_SIZE * DEPTH)
+
+#define NUM_FILL_TESTS (2000)
+
+extern void copy_mem(char *src, char *dest, int num_words, int desc);
+
+static int failures;
+static UBYTE original[BITMAP_SIZE], expected[BITMAP_SIZE];
+static struct Ratr0TileSheet bitmap;
+
+static int get_pixel(UBYTE *data, int plane, int x, int y)
+{
+    return (data[plane * PLANE_SIZE + y * ROW_BYTES + x / 8] >> (7 - (x & 7))) & 1;
+}
+
+static void set_pixel(UBYTE *data, int plane, int x, int y, int value)
+{
+    UBYTE *p = &data[plane * PLANE_SIZE + y * ROW_BYTES + x / 8];
+    UBYTE bit = 0x80 >> (x & 7);
+    *p = value ? *p | bit : *p & ~bit;
+}
+
+static void init_bitmaps(void)
+{
+    for (int i = 0; i < BITMAP_SIZE; i++) original[i] = rand();
+    memcpy(bitmap.imgdata, original, BITMAP_SIZE);
+    memcpy(expected, original, BITMAP_SIZE);
+}
+
+/*
+ * Reference line: pixel i steps the major axis i times and the minor axis
+ * i * dmin / dmax times, rounded to nearest with halves rounded up. The
+ * texture starts at bit BSH of the pattern and continues with the next
+ * lower bit for every pixel. In single bit mode only the first pixel of
+ * every row is drawn. Note that with LF_XOR, pixels with a 0 texture bit
+ * are cleared.
+ */
+static void draw_reference_line(UBYTE *data, struct DrawLineParams *p)
+{
+    int dx = abs(p->x2 - p->x1), dy = abs(p->y2 - p->y1);
+    int sx = p->x2 < p->x1 ? -1 : 1, sy = p->y2 < p->y1 ? -1 : 1;
+    int x_major = dx > dy;
+    int dmax = x_major ? dx : dy, dmin = x_major ? dy : dx;
+    int bsh = (p->x1 + p->pattern_offset) & 15;
+    int prev_y = -1;
+
+    for (int i = 0; i <= dmax; i++) {
+        int minor = (2 * i * dmin + dmax) / (2 * dmax);
+        int x = p->x1 + sx * (x_major ? i : minor);
+        int y = p->y1 + sy * (x_major ? minor : i);
+        int texture = (p->line_pattern >> ((bsh - i) & 15)) & 1;
+        BOOL skip = (p->single && y == prev_y) || (p->omit_first_pixel && i == 0);
+        prev_y = y;
+        if (skip) continue;
+        // minterm with A = 1, B = texture, C = destination
+        int c = get_pixel(data, p->plane, x, y);
+        set_pixel(data, p->plane, x, y, (p->lf_byte >> (4 + texture * 2 + c)) & 1);
+    }
+}
+
+static void check_line(const char *name, struct DrawLineParams *p)
+{
+    init_bitmaps();
+    ratr0_draw_line(&bitmap, p);
+    blitsim_sync();
+    draw_reference_line(expected, p);
+    if (test_compare(name, bitmap.imgdata, expected, BITMAP_SIZE)) {
+        printf("  %d, %d - %d, %d pattern $%04x offset %d single %d omit %d\n",
+               p->x1, p->y1, p->x2, p->y2, p->line_pattern, p->pattern_offset,
+               p->single, p->omit_first_pixel);
+        failures++;
+    }
+}
+
+/*
+ * Lines from the center in all 8 octants and along the axes, with every
+ * start position within a word.
+ */
+static void test_lines(const char *name, UBYTE lf_byte, UWORD pattern, BOOL single, BOOL omit)
+{
+    struct DrawLineParams p = { 0, 0, 0, 0, 1, pattern, 0, lf_byte, single, omit };
+    blitsim_reset();
+    for (int dy = -40; dy <= 40; dy += 5) {
+        for (int dx = -40; dx <= 40; dx += 3) {
+            if (dx == 0 && dy == 0) continue;
+            p.x1 = 140 + ((dx + dy) & 15);
+            p.y1 = 128;
+            p.x2 = p.x1 + dx;
+            p.y2 = p.y1 + dy;
+            p.pattern_offset = (dx * 7 + dy) & 15;
+            check_line(name, &p);
+        }
+    }
+    test_print_stats(name);
+}
+
+/*
+ * Reference fill: every row of the word aligned area is scanned from right
+ * to left, every set pixel toggles the fill carry, which starts with the
+ * fill carry input. Inclusive fill keeps the edge pixels, exclusive fill
+ * sets the pixels to the carry.
+ */
+static void fill_reference(UBYTE *data, struct AreaFillParams *p)
+{
+    int left = p->x1 & ~15, right = (p->x2 | 15) + 1;
+    for (int y = p->y1; y <= p->y2; y++) {
+        int carry = p->fill_carry_input;
+        for (int x = right - 1; x >= left; x--) {
+            int edge = get_pixel(data, 0, x, y);
+            carry ^= edge;
+            set_pixel(data, 0, x, y, p->exclusive ? carry : edge | carry);
+        }
+    }
+}
+
+static int check_fill(const char *name, struct AreaFillParams *p)
+{
+    memcpy(expected, bitmap.imgdata, BITMAP_SIZE);
+    ratr0_area_fill(&bitmap, p);
+    blitsim_sync();
+    fill_reference(expected, p);
+    if (test_compare(name, bitmap.imgdata, expected, BITMAP_SIZE)) {
+        printf("  %d, %d - %d, %d exclusive %d carry %d\n", p->x1, p->y1, p->x2, p->y2,
+               p->exclusive, p->fill_carry_input);
+        return 1;
+    }
+    return 0;
+}
+
+// a single row with edges at x = 3 and x = 8, results written out by hand
+static void test_fill_row(void)
+{
+    static const struct {
+        UBYTE exclusive, carry;
+        UBYTE result[2];
+    } cases[] = {
+        { FALSE, 0, { 0x1f, 0x80 } },  // pixels 3-8
+        { TRUE, 0, { 0x0f, 0x80 } },   // pixels 4-8
+        { FALSE, 1, { 0xf0, 0xff } },  // 0-3 and 8-15
+        { TRUE, 1, { 0xf0, 0x7f } }    // 0-3 and 9-15
+    };
+    for (int i = 0; i < 4; i++) {
+        struct AreaFillParams p = { 0, 10, 15, 10, cases[i].exclusive, cases[i].carry };
+        memset(bitmap.imgdata, 0, BITMAP_SIZE);
+        memset(expected, 0, BITMAP_SIZE);
+        bitmap.imgdata[10 * ROW_BYTES] = 0x10;
+        bitmap.imgdata[10 * ROW_BYTES + 1] = 0x80;
+        ratr0_area_fill(&bitmap, &p);
+        blitsim_sync();
+        memcpy(&expected[10 * ROW_BYTES], cases[i].result, 2);
+        failures += test_compare("fill row", bitmap.imgdata, expected, BITMAP_SIZE);
+    }
+}
+
+// random edges in random, not word aligned areas
+static void test_fills(void)
+{
+    blitsim_reset();
+    test_fill_row();
+    srand(2);
+    for (int i = 0; i < NUM_FILL_TESTS; i++) {
+        struct AreaFillParams p;
+        p.x1 = rand() % 200;
+        p.x2 = p.x1 + rand() % 100;
+        p.y1 = rand() % 200;
+        p.y2 = p.y1 + rand() % 50;
+        p.exclusive = i & 1;
+        p.fill_carry_input = (i >> 1) & 1;
+        // sparse edges, most rows get a few spans
+        for (int j = 0; j < PLANE_SIZE; j++) bitmap.imgdata[j] = (rand() % 8) ? 0 : 1 << (rand() % 8);
+        if (check_fill("area_fill", &p)) {
+            failures++;
+            break;
+        }
+    }
+    test_print_stats("area_fill");
+}
+
+/*
+ * Filled triangles the way example_03 draws them: outlines with XOR in
+ * single bit mode without the first pixels, then an inclusive fill.
+ */
+static void test_polygons(void)
+{
+    struct DrawLineParams line = { 0, 0, 0, 0, 0, 0xffff, 0, LF_XOR, TRUE, TRUE };
+    blitsim_reset();
+    srand(3);
+    for (int i = 0; i < 200; i++) {
+        UWORD x[3], y[3];
+        for (int j = 0; j < 3; j++) {
+            x[j] = 20 + rand() % 280;
+            y[j] = 20 + rand() % 200;
+        }
+        memset(bitmap.imgdata, 0, BITMAP_SIZE);
+        memset(expected, 0, BITMAP_SIZE);
+        for (int j = 0; j < 3; j++) {
+            line.x1 = x[j];
+            line.y1 = y[j];
+            line.x2 = x[(j + 1) % 3];
+            line.y2 = y[(j + 1) % 3];
+            if (line.x1 == line.x2 && line.y1 == line.y2) continue;
+            ratr0_draw_line(&bitmap, &line);
+            draw_reference_line(expected, &line);
+        }
+        blitsim_sync();
+        if (test_compare("polygon outline", bitmap.imgdata, expected, BITMAP_SIZE)) {
+            failures++;
+            break;
+        }
+        struct AreaFillParams fill = { 0, 0, WIDTH - 1, HEIGHT - 1, FALSE, 0 };
+        if (check_fill("polygon fill", &fill)) {
+            failures++;
+            break;
+        }
+    }
+    test_print_stats("polygons");
+}
+
+/*
+ * copy_mem() in the direction that is safe for overlapping areas has to
+ * behave like memmove()
+ */
+static void test_copy_mem(void)
+{
+    // the blitter ignores bit 0 of its pointers
+    static char src[] __attribute__((aligned(2))) = "ABCDEFGHIJK";
+    static char dst[] __attribute__((aligned(2))) = "01234567890";
+    static char buffer[16] __attribute__((aligned(2)));
+    char reference[16];
+
+    blitsim_reset();
+    copy_mem(src, dst, 3, 0);
+    blitsim_sync();
+    if (strcmp(dst, "ABCDEF67890")) {
+        printf("FAIL copy_mem: '%s', expected 'ABCDEF67890'\n", dst);
+        failures++;
+    }
+    for (int words = 1; words <= 5; words++) {
+        for (int offset = 2; offset <= 6; offset += 2) {
+            // dst > src: descending, the pointers address the last word
+            strcpy(buffer, "ABCDEFGHIJKLMNO");
+            strcpy(reference, buffer);
+            memmove(reference + offset, reference, words * 2);
+            copy_mem(buffer + words * 2 - 2, buffer + offset + words * 2 - 2, words, 1);
+            blitsim_sync();
+            failures += test_compare("copy_mem descending", (UBYTE *) buffer,
+                                     (UBYTE *) reference, 16);
+
+            // dst < src: ascending
+            strcpy(buffer, "ABCDEFGHIJKLMNO");
+            strcpy(reference, buffer);
+            memmove(reference, reference + offset, words * 2);
+            copy_mem(buffer + offset, buffer, words, 0);
+            blitsim_sync();
+            failures += test_compare("copy_mem ascending", (UBYTE *) buffer,
+                                     (UBYTE *) reference, 16);
+        }
+    }
+    test_print_stats("copy_mem");
+}
+
+int main(int argc, char **argv)
+{
+    bitmap.header.width = WIDTH;
+    bitmap.header.height = HEIGHT;
+    bitmap.header.bmdepth = DEPTH;
+    bitmap.imgdata = malloc(BITMAP_SIZE);
+    if (!bitmap.imgdata) return 1;
+    srand(1);
+
+    test_lines("line cookie cut", LF_COOKIE_CUT, 0xffff, FALSE, FALSE);
+    test_lines("line xor", LF_XOR, 0xffff, FALSE, FALSE);
+    test_lines("line texture", LF_COOKIE_CUT, 0xf0a5, FALSE, FALSE);
+    test_lines("line xor texture", LF_XOR, 0x3c96, FALSE, FALSE);
+    test_lines("line single", LF_XOR, 0xffff, TRUE, FALSE);
+    test_lines("line single texture", LF_COOKIE_CUT, 0xc3e1, TRUE, TRUE);
+    test_lines("line omit first", LF_XOR, 0xffff, FALSE, TRUE);
+    test_fills();
+    test_polygons();
+    test_copy_mem();
+
+    free(bitmap.imgdata);
+    printf("test_draw: %d failures\n", failures);
+    return failures ? 1 : 0;
+}
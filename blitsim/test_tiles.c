@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blitsim.h"
+#include "tilesheet.h"
+#include "blit_queue.h"
+#include "dirty_tiles.h"
+#include "test_util.h"
+
+/*
+ * Regression test for the tile blits of episode-008: a screen is filled
+ * with the tiles of rocknroll_tiles.ts through the direct, queued and
+ * batched blit paths and compared byte for byte with a reference that
+ * copies the tiles with the CPU. The dirty tile renderer is tested the
+ * same way, its rectangles are checked against the marked tiles.
+ */
+#define TILES_FILE "../episode-008/graphics/rocknroll_tiles.ts"
+#define MAP_FILE "../episode-008/graphics/rocknroll_map.ts"
+#define MAP_LZ_FILE "../episode-008/graphics/rocknroll_map_lz.ts"
+
+// interleaved 320x256x5 screen
+#define SCREEN_WIDTH (320)
+#define SCREEN_HEIGHT (256)
+#define SCREEN_DEPTH (5)
+#define SCREEN_ROW_BYTES (SCREEN_WIDTH / 8)
+#define SCREEN_SIZE (SCREEN_ROW_BYTES * SCREEN_HEIGHT * SCREEN_DEPTH)
+#define SCREEN_DMOD (SCREEN_ROW_BYTES - 2)
+
+// the queue has room for 64 blits, let the blitter catch up before that
+#define BLITS_PER_SYNC (32)
+
+static int failures;
+static UBYTE screen[SCREEN_SIZE], expected[SCREEN_SIZE];
+
+enum TilePath { PATH_DIRECT, PATH_BY_INDEX, PATH_QUEUED, PATH_BATCH, PATH_BATCH_BY_INDEX };
+static const char *PATH_NAMES[] = {
+    "blit_tile", "blit_tile_by_index", "queue_blit_tile", "batch_blit_tile",
+    "batch_blit_tile_by_index"
+};
+
+static int num_tiles(struct Ratr0TileSheet *tiles)
+{
+    return tiles->header.num_tiles_h * tiles->header.num_tiles_v;
+}
+
+// tile number for a screen position, covers all tiles
+static int tile_at(struct Ratr0TileSheet *tiles, int x, int y)
+{
+    return (x + y * 7) % num_tiles(tiles);
+}
+
+static UBYTE *screen_tile(UBYTE *base, struct Ratr0TileSheet *tiles, int x, int y)
+{
+    return base + y * tiles->header.tile_height * SCREEN_ROW_BYTES * SCREEN_DEPTH + x * 2;
+}
+
+static void draw_reference_tile(struct Ratr0TileSheet *tiles, int x, int y, int tile)
+{
+    struct Ratr0TileSheetHeader *h = &tiles->header;
+    int tile_row_bytes = h->num_tiles_h * 2 * h->tile_width * h->bmdepth;
+    UBYTE *src = tiles->imgdata + (tile / h->num_tiles_h) * tile_row_bytes +
+        (tile % h->num_tiles_h) * 2;
+    UBYTE *dst = screen_tile(expected, tiles, x, y);
+    // one word per line of every plane
+    for (int l = 0; l < h->tile_height * h->bmdepth; l++) {
+        memcpy(dst + l * SCREEN_ROW_BYTES, src + l * h->num_tiles_h * 2, 2);
+    }
+}
+
+static void draw_reference(struct Ratr0TileSheet *tiles)
+{
+    struct Ratr0TileSheetHeader *h = &tiles->header;
+    int screen_tiles_h = SCREEN_WIDTH / h->tile_width;
+    int screen_tiles_v = SCREEN_HEIGHT / h->tile_height;
+
+    for (int y = 0; y < screen_tiles_v; y++) {
+        for (int x = 0; x < screen_tiles_h; x++) {
+            draw_reference_tile(tiles, x, y, tile_at(tiles, x, y));
+        }
+    }
+}
+
+static void draw_tiles(struct Ratr0TileSheet *tiles, enum TilePath path)
+{
+    struct Ratr0TileSheetHeader *h = &tiles->header;
+    int screen_tiles_h = SCREEN_WIDTH / h->tile_width;
+    int screen_tiles_v = SCREEN_HEIGHT / h->tile_height;
+    int num_blits = 0;
+
+    if (path >= PATH_QUEUED) ratr0_blit_queue_install();
+    if (path >= PATH_BATCH) ratr0_begin_tile_batch(SCREEN_DMOD, tiles);
+    for (int y = 0; y < screen_tiles_v; y++) {
+        for (int x = 0; x < screen_tiles_h; x++) {
+            int tile = tile_at(tiles, x, y);
+            int tx = tile % h->num_tiles_h, ty = tile / h->num_tiles_h;
+            UBYTE *dst = screen_tile(screen, tiles, x, y);
+            switch (path) {
+            case PATH_DIRECT:
+                ratr0_blit_tile(dst, SCREEN_DMOD, tiles, tx, ty);
+                break;
+            case PATH_BY_INDEX:
+                ratr0_blit_tile_by_index(dst, SCREEN_DMOD, tiles, tile + 1);
+                break;
+            case PATH_QUEUED:
+                ratr0_queue_blit_tile(dst, SCREEN_DMOD, tiles, tx, ty);
+                break;
+            case PATH_BATCH:
+                ratr0_batch_blit_tile(dst, tiles, tx, ty);
+                break;
+            case PATH_BATCH_BY_INDEX:
+                ratr0_batch_blit_tile_by_index(dst, tiles, tile + 1);
+                break;
+            }
+            // there is no interrupt on the host, run the queued blits
+            if (path >= PATH_QUEUED && ++num_blits % BLITS_PER_SYNC == 0) blitsim_complete_blits();
+        }
+    }
+    if (path >= PATH_QUEUED) {
+        blitsim_complete_blits();
+        ratr0_blit_queue_uninstall();
+    } else {
+        blitsim_sync();
+    }
+}
+
+static void test_tile_paths(struct Ratr0TileSheet *tiles)
+{
+    memset(expected, 0, SCREEN_SIZE);
+    draw_reference(tiles);
+    for (int path = PATH_DIRECT; path <= PATH_BATCH_BY_INDEX; path++) {
+        memset(screen, 0, SCREEN_SIZE);
+        blitsim_reset();
+        draw_tiles(tiles, path);
+        failures += test_compare(PATH_NAMES[path], screen, expected, SCREEN_SIZE);
+        test_print_stats(PATH_NAMES[path]);
+    }
+}
+
+// the compressed map has to unpack to the same image
+static void test_compressed_map(void)
+{
+    struct Ratr0TileSheet map, map_lz;
+    if (!test_load_tilesheet(MAP_FILE, &map) || !test_load_tilesheet(MAP_LZ_FILE, &map_lz)) {
+        failures++;
+        return;
+    }
+    if (map.header.imgdata_size != map_lz.header.imgdata_size) {
+        printf("FAIL compressed map: size %lu, expected %lu\n",
+               (unsigned long) map_lz.header.imgdata_size, (unsigned long) map.header.imgdata_size);
+        failures++;
+    } else {
+        failures += test_compare("compressed map", map_lz.imgdata, map.imgdata,
+                                 map.header.imgdata_size);
+    }
+    ratr0_free_tilesheet_data(&map);
+    ratr0_free_tilesheet_data(&map_lz);
+}
+
+/*
+ * Dirty tiles
+ */
+#define DIRTY_MAP_WIDTH (SCREEN_WIDTH / 16)
+#define DIRTY_MAP_HEIGHT (SCREEN_HEIGHT / 16)
+#define DIRTY_ROUNDS (200)
+
+// the tiles that were marked since the last coalesce
+static UBYTE marked[MAX_DIRTY_ROWS][MAX_DIRTY_COLUMNS];
+
+static void mark_tiles(struct Ratr0DirtyMap *map, int x, int y, int width, int height)
+{
+    ratr0_mark_dirty_tiles(map, x, y, width, height);
+    for (int ty = y; ty < y + height; ty++) {
+        for (int tx = x; tx < x + width; tx++) {
+            if (tx >= 0 && ty >= 0 && tx < map->width && ty < map->height) marked[ty][tx] = 1;
+        }
+    }
+}
+
+/*
+ * Coalesces the map and checks the rectangles: they have to be inside of
+ * the map and cover all marked tiles. Unless the rectangles ran out, they
+ * cover exactly the marked tiles without overlapping. The map has to be
+ * clean afterwards.
+ */
+static int check_coalesce(const char *name, struct Ratr0DirtyMap *map)
+{
+    static UBYTE covered[MAX_DIRTY_ROWS][MAX_DIRTY_COLUMNS];
+    UWORD num_rects = ratr0_coalesce_dirty_tiles(map);
+    BOOL exact = num_rects < MAX_DIRTY_RECTS;
+    int result = 0;
+
+    memset(covered, 0, sizeof(covered));
+    for (int i = 0; i < num_rects && !result; i++) {
+        struct Ratr0DirtyRect *r = &map->rects[i];
+        if (r->width == 0 || r->height == 0 ||
+            r->x + r->width > map->width || r->y + r->height > map->height) {
+            printf("FAIL %s: rectangle %d is %d, %d, %dx%d\n", name, i, r->x, r->y,
+                   r->width, r->height);
+            result = 1;
+        }
+        for (int y = r->y; y < r->y + r->height && !result; y++) {
+            for (int x = r->x; x < r->x + r->width; x++) covered[y][x]++;
+        }
+    }
+    for (int y = 0; y < map->height && !result; y++) {
+        for (int x = 0; x < map->width && !result; x++) {
+            if (marked[y][x] && !covered[y][x]) {
+                printf("FAIL %s: dirty tile %d, %d is not covered\n", name, x, y);
+                result = 1;
+            } else if (exact && covered[y][x] != marked[y][x]) {
+                printf("FAIL %s: tile %d, %d is covered %d times, dirty: %d\n", name, x, y,
+                       covered[y][x], marked[y][x]);
+                result = 1;
+            }
+        }
+    }
+    if (!result && ratr0_coalesce_dirty_tiles(map)) {
+        printf("FAIL %s: the map is not clean after coalescing\n", name);
+        result = 1;
+    }
+    memset(marked, 0, sizeof(marked));
+    return result;
+}
+
+static void test_coalesce(void)
+{
+    static struct Ratr0DirtyMap map;
+    ratr0_init_dirty_map(&map, DIRTY_MAP_WIDTH, DIRTY_MAP_HEIGHT);
+
+    // equal spans in consecutive rows merge, across a word boundary
+    mark_tiles(&map, 14, 3, 4, 5);
+    failures += check_coalesce("coalesce block", &map);
+    ratr0_mark_dirty_tiles(&map, 14, 3, 4, 5);
+    if (ratr0_coalesce_dirty_tiles(&map) != 1) {
+        printf("FAIL coalesce block: %d rectangles, expected 1\n", map.num_rects);
+        failures++;
+    }
+    // different widths or a gap start new rectangles
+    mark_tiles(&map, 2, 0, 3, 2);
+    mark_tiles(&map, 2, 2, 4, 1);
+    mark_tiles(&map, 2, 4, 4, 1);
+    mark_tiles(&map, 7, 4, 2, 1);
+    failures += check_coalesce("coalesce spans", &map);
+    // bob areas in pixels, partially outside
+    ratr0_mark_dirty_area(&map, -5, 250, 40, 30);
+    mark_tiles(&map, 0, 15, 3, 1);
+    ratr0_mark_dirty_area(&map, 311, -3, 12, 5);
+    mark_tiles(&map, 19, 0, 1, 1);
+    failures += check_coalesce("coalesce areas", &map);
+    // more spans than rectangles: every other tile
+    for (int y = 0; y < map.height; y++) {
+        for (int x = y & 1; x < map.width; x += 2) mark_tiles(&map, x, y, 1, 1);
+    }
+    failures += check_coalesce("coalesce overflow", &map);
+
+    srand(3);
+    for (int i = 0; i < DIRTY_ROUNDS; i++) {
+        for (int n = rand() % 12; n > 0; n--) {
+            mark_tiles(&map, rand() % 24 - 2, rand() % 20 - 2, rand() % 6, rand() % 6);
+        }
+        failures += check_coalesce("coalesce random", &map);
+    }
+}
+
+// level byte for a tile of a test level, 0 is not a tile
+static UBYTE level_tile(struct Ratr0TileSheet *tiles, int x, int y)
+{
+    return (x * 3 + y * 5) % num_tiles(tiles) + 1;
+}
+
+// only the dirty tiles are redrawn from the level
+static void test_redraw_dirty(struct Ratr0TileSheet *tiles)
+{
+    static struct Ratr0DirtyMap map;
+    struct Ratr0Level level;
+    int level_x = 5, level_y = 7;
+
+    level.header.width = 32;
+    level.header.height = 40;
+    level.lvldata = malloc(level.header.width * level.header.height);
+    for (int y = 0; y < level.header.height; y++) {
+        for (int x = 0; x < level.header.width; x++) {
+            level.lvldata[y * level.header.width + x] = level_tile(tiles, x, y);
+        }
+    }
+    ratr0_init_dirty_map(&map, DIRTY_MAP_WIDTH, DIRTY_MAP_HEIGHT);
+    memset(screen, 0x5a, SCREEN_SIZE);
+    memset(expected, 0x5a, SCREEN_SIZE);
+    blitsim_reset();
+    ratr0_blit_queue_install();
+    srand(4);
+    for (int i = 0; i < DIRTY_ROUNDS; i++) {
+        // stay below the size of the blit queue
+        for (int n = rand() % 4; n > 0; n--) {
+            mark_tiles(&map, rand() % 22 - 1, rand() % 18 - 1, rand() % 4, rand() % 4);
+        }
+        for (int y = 0; y < map.height; y++) {
+            for (int x = 0; x < map.width; x++) {
+                if (marked[y][x]) {
+                    draw_reference_tile(tiles, x, y, level_tile(tiles, level_x + x, level_y + y) - 1);
+                }
+            }
+        }
+        memset(marked, 0, sizeof(marked));
+        ratr0_coalesce_dirty_tiles(&map);
+        ratr0_redraw_dirty_tiles(&map, screen, SCREEN_ROW_BYTES, &level, level_x, level_y, tiles);
+        blitsim_complete_blits();
+        if (test_compare("redraw dirty tiles", screen, expected, SCREEN_SIZE)) {
+            printf("  round %d\n", i);
+            failures++;
+            break;
+        }
+    }
+    ratr0_blit_queue_uninstall();
+    test_print_stats("redraw dirty tiles");
+    free(level.lvldata);
+}
+
+/*
+ * Copies the dirty rectangles from a background that is higher than a
+ * blit can be, so tall rectangles are split. With 4 planes a tile row is
+ * 64 lines and the blits are exactly 1024 lines high.
+ */
+#define COPY_ROWS (40)
+
+static void test_copy_dirty(int bmdepth)
+{
+    static struct Ratr0DirtyMap map;
+    int tile_row_bytes = SCREEN_ROW_BYTES * bmdepth * 16;
+    ULONG size = tile_row_bytes * COPY_ROWS;
+    UBYTE *src = malloc(size), *dst = malloc(size), *ref = malloc(size);
+    char name[64];
+
+    snprintf(name, sizeof(name), "copy dirty rects, %d planes", bmdepth);
+    for (ULONG i = 0; i < size; i++) src[i] = rand();
+    memset(dst, 0, size);
+    memset(ref, 0, size);
+    ratr0_init_dirty_map(&map, DIRTY_MAP_WIDTH, COPY_ROWS);
+    blitsim_reset();
+    ratr0_blit_queue_install();
+    srand(5);
+    for (int i = 0; i < DIRTY_ROUNDS / 4; i++) {
+        // a full height column and random blocks
+        mark_tiles(&map, i % DIRTY_MAP_WIDTH, 0, 1 + i % 3, COPY_ROWS);
+        for (int n = rand() % 4; n > 0; n--) {
+            mark_tiles(&map, rand() % DIRTY_MAP_WIDTH, rand() % COPY_ROWS, rand() % 5, rand() % 20);
+        }
+        for (int y = 0; y < COPY_ROWS; y++) {
+            for (int x = 0; x < DIRTY_MAP_WIDTH; x++) {
+                if (!marked[y][x]) continue;
+                for (int l = 0; l < bmdepth * 16; l++) {
+                    ULONG offset = y * tile_row_bytes + l * SCREEN_ROW_BYTES + x * 2;
+                    memcpy(ref + offset, src + offset, 2);
+                }
+            }
+        }
+        memset(marked, 0, sizeof(marked));
+        ratr0_coalesce_dirty_tiles(&map);
+        ratr0_copy_dirty_rects(&map, src, dst, SCREEN_ROW_BYTES, bmdepth);
+        blitsim_complete_blits();
+        if (test_compare(name, dst, ref, size)) {
+            printf("  round %d\n", i);
+            failures++;
+            break;
+        }
+    }
+    ratr0_blit_queue_uninstall();
+    test_print_stats(name);
+    free(src);
+    free(dst);
+    free(ref);
+}
+
+int main(int argc, char **argv)
+{
+    struct Ratr0TileSheet tiles;
+    if (!test_load_tilesheet(TILES_FILE, &tiles)) return 1;
+    test_tile_paths(&tiles);
+    test_coalesce();
+    test_redraw_dirty(&tiles);
+    test_copy_dirty(5);
+    test_copy_dirty(4);
+    ratr0_free_tilesheet_data(&tiles);
+    test_compressed_map();
+    printf("test_tiles: %d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "blitsim.h"
+#include "test_util.h"
+
+#define HEADER_BYTES (32)  // size of the header in the asset files
+
+static UWORD get_word(const UBYTE *p) { return (p[0] << 8) | p[1]; }
+static ULONG get_long(const UBYTE *p) { return ((ULONG) get_word(p) << 16) | get_word(p + 2); }
+
+/*
+ * The asset headers are big endian and packed for the 68000, the loader
+ * reads them into the structure directly. So the file is converted into
+ * a temporary copy with a host header first, the image data is left as it
+ * is. The checksum is a sum of native words, it is cleared.
+ */
+static BOOL convert_tilesheet(const char *filename, const char *host_filename)
+{
+    UBYTE buffer[HEADER_BYTES];
+    struct Ratr0TileSheetHeader header;
+    FILE *in = fopen(filename, "rb"), *out = NULL;
+    BOOL result = FALSE;
+
+    if (!in) {
+        printf("could not open '%s'\n", filename);
+        return FALSE;
+    }
+    if (fread(buffer, 1, HEADER_BYTES, in) == HEADER_BYTES &&
+        (out = fopen(host_filename, "wb"))) {
+        memcpy(header.id, buffer, FILE_ID_LEN);
+        header.version = buffer[8];
+        header.flags = buffer[9];
+        header.reserved1 = buffer[10];
+        header.bmdepth = buffer[11];
+        header.width = get_word(buffer + 12);
+        header.height = get_word(buffer + 14);
+        header.tile_width = get_word(buffer + 16);
+        header.tile_height = get_word(buffer + 18);
+        header.num_tiles_h = get_word(buffer + 20);
+        header.num_tiles_v = get_word(buffer + 22);
+        header.palette_size = get_word(buffer + 24);
+        header.imgdata_size = get_long(buffer + 26);
+        header.checksum = 0;
+        fwrite(&header, sizeof(header), 1, out);
+
+        // palette, then the size of compressed data, then the image data
+        for (int i = 0; i < header.palette_size; i++) {
+            UBYTE color[2];
+            if (fread(color, 1, 2, in) != 2) break;
+            UWORD value = get_word(color);
+            fwrite(&value, 2, 1, out);
+        }
+        UBYTE data[4096];
+        size_t n;
+#ifdef TSFLAGS_COMPRESSED
+        if ((header.flags & TSFLAGS_COMPRESSED) && fread(data, 1, 4, in) == 4) {
+            ULONG packed_size = get_long(data);
+            fwrite(&packed_size, 4, 1, out);
+        }
+#endif
+        while ((n = fread(data, 1, sizeof(data), in)) > 0) fwrite(data, 1, n, out);
+        result = TRUE;
+    }
+    if (out) fclose(out);
+    fclose(in);
+    return result;
+}
+
+BOOL test_load_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
+{
+    char host_filename[64];
+    snprintf(host_filename, sizeof(host_filename), "/tmp/blitsim_%d.ts", (int) getpid());
+    BOOL result = convert_tilesheet(filename, host_filename) &&
+        ratr0_read_tilesheet(host_filename, sheet);
+    remove(host_filename);
+    if (!result) printf("could not load '%s'\n", filename);
+    return result;
+}
+
+int test_compare(const char *name, const UBYTE *result, const UBYTE *expected, ULONG size)
+{
+    for (ULONG i = 0; i < size; i++) {
+        if (result[i] != expected[i]) {
+            printf("FAIL %s: byte %lu is $%02x, expected $%02x\n", name,
+                   (unsigned long) i, result[i], expected[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void test_print_stats(const char *name)
+{
+    printf("%-28s %7lu blits %9lu words %9lu reads %9lu writes\n", name,
+           (unsigned long) blitsim_stats.blits, (unsigned long) blitsim_stats.words,
+           (unsigned long) blitsim_stats.reads, (unsigned long) blitsim_stats.writes);
+}
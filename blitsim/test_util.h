@@ -0,0 +1,19 @@
+#pragma once
+#ifndef __TEST_UTIL_H__
+#define __TEST_UTIL_H__
+
+#include <exec/types.h>
+#include "tilesheet.h"
+
+/*
+ * Helpers for the blitter regression tests. They are compiled with the
+ * tilesheet.h of the episode that is tested.
+ */
+
+// loads a tile sheet asset of the repository with ratr0_read_tilesheet()
+extern BOOL test_load_tilesheet(const char *filename, struct Ratr0TileSheet *sheet);
+// compares 2 bitmaps byte for byte, returns the number of failed checks (0 or 1)
+extern int test_compare(const char *name, const UBYTE *result, const UBYTE *expected, ULONG size);
+extern void test_print_stats(const char *name);
+
+#endif /* __TEST_UTIL_H__ */
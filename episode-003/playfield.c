@@ -7,6 +7,7 @@
 #include <ahpc_registers.h>
 
 #include "tilesheet.h"
+#include "raster_split.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -38,73 +39,20 @@ extern struct Custom custom;
 // bplcon0: use bitplane 1-5 = BPU 101, composite color enable
 #define BPLCON0_VALUE (0x5200)
 
-// copper instruction macros
-#define COP_MOVE(addr, data) addr, data
-#define COP_WAIT_END  0xffff, 0xfffe
-
-// copper list indexes
-#define COPLIST_IDX_DIWSTOP_VALUE (9)
-#define COPLIST_IDX_BPL1MOD_VALUE (13)
-#define COPLIST_IDX_BPL2MOD_VALUE (15)
-#define COPLIST_IDX_COLOR00_VALUE (17)
-#define COPLIST_IDX_BPL1PTH_VALUE (COPLIST_IDX_COLOR00_VALUE + 64)
-#define COPLIST_IDX_BPL1PTH_SECOND_VALUE (COPLIST_IDX_BPL1PTH_VALUE + 20 + 4)
-
-static UWORD __chip coplist[] = {
-    COP_MOVE(FMODE,   0), // set fetch mode = 0
-    COP_MOVE(DDFSTRT, DDFSTRT_VALUE),
-    COP_MOVE(DDFSTOP, DDFSTOP_VALUE),
-    COP_MOVE(DIWSTRT, DIWSTRT_VALUE),
-    COP_MOVE(DIWSTOP, DIWSTOP_VALUE_PAL),
-    COP_MOVE(BPLCON0, BPLCON0_VALUE),
-    COP_MOVE(BPL1MOD, 0),
-    COP_MOVE(BPL2MOD, 0),
-
-    // set up the display colors
-    COP_MOVE(COLOR00, 0x000), COP_MOVE(COLOR01, 0x000),
-    COP_MOVE(COLOR02, 0x000), COP_MOVE(COLOR03, 0x000),
-    COP_MOVE(COLOR04, 0x000), COP_MOVE(COLOR05, 0x000),
-    COP_MOVE(COLOR06, 0x000), COP_MOVE(COLOR07, 0x000),
-    COP_MOVE(COLOR08, 0x000), COP_MOVE(COLOR09, 0x000),
-    COP_MOVE(COLOR10, 0x000), COP_MOVE(COLOR11, 0x000),
-    COP_MOVE(COLOR12, 0x000), COP_MOVE(COLOR13, 0x000),
-    COP_MOVE(COLOR14, 0x000), COP_MOVE(COLOR15, 0x000),
-    COP_MOVE(COLOR16, 0x000), COP_MOVE(COLOR17, 0x000),
-    COP_MOVE(COLOR18, 0x000), COP_MOVE(COLOR19, 0x000),
-    COP_MOVE(COLOR20, 0x000), COP_MOVE(COLOR21, 0x000),
-    COP_MOVE(COLOR22, 0x000), COP_MOVE(COLOR23, 0x000),
-    COP_MOVE(COLOR24, 0x000), COP_MOVE(COLOR25, 0x000),
-    COP_MOVE(COLOR26, 0x000), COP_MOVE(COLOR27, 0x000),
-    COP_MOVE(COLOR28, 0x000), COP_MOVE(COLOR29, 0x000),
-    COP_MOVE(COLOR30, 0x000), COP_MOVE(COLOR31, 0x000),
-
-    COP_MOVE(BPL1PTH, 0),
-    COP_MOVE(BPL1PTL, 0),
-    COP_MOVE(BPL2PTH, 0),
-    COP_MOVE(BPL2PTL, 0),
-    COP_MOVE(BPL3PTH, 0),
-    COP_MOVE(BPL3PTL, 0),
-    COP_MOVE(BPL4PTH, 0),
-    COP_MOVE(BPL4PTL, 0),
-    COP_MOVE(BPL5PTH, 0),
-    COP_MOVE(BPL5PTL, 0),
+// copper list: display setup and up to 2 zones
+#define COPLIST_WORDS (256)
+static UWORD __chip coplist[COPLIST_WORDS];
+
 #ifdef SPLIT_SCREEN
-    0xaa05, 0xfffe,  // wait to the half of the screen (aa = 170)
-    COP_MOVE(BPLCON0, BPLCON0_VALUE),
-    COP_MOVE(BPL1PTH, 0),
-    COP_MOVE(BPL1PTL, 0),
-    COP_MOVE(BPL2PTH, 0),
-    COP_MOVE(BPL2PTL, 0),
-    COP_MOVE(BPL3PTH, 0),
-    COP_MOVE(BPL3PTL, 0),
-    COP_MOVE(BPL4PTH, 0),
-    COP_MOVE(BPL4PTL, 0),
-    COP_MOVE(BPL5PTH, 0),
-    COP_MOVE(BPL5PTL, 0),
+#define NUM_ZONES (2)
+// the second zone shows the top of the image again from line 0xaa (170)
+#define SPLIT_LINE (0xaa)
+#else
+#define NUM_ZONES (1)
 #endif
-    COP_WAIT_END,
-    COP_WAIT_END
-};
+
+static struct Ratr0SplitZone zones[NUM_ZONES];
+static struct Ratr0SplitZoneSlots zone_slots[NUM_ZONES];
 
 static BOOL init_display(void)
 {
@@ -136,49 +84,49 @@ int main(int argc, char **argv)
     SetTaskPri(FindTask(NULL), TASK_PRIORITY);
     BOOL is_pal = init_display();
     if (ratr0_read_tilesheet(IMG_FILE_NAME, &image)) {
-        if (is_pal) {
-            coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
-        } else {
-            coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_NTSC;
-        }
         int img_row_bytes = image.header.width / 8;
-        UBYTE num_colors = 1 << image.header.bmdepth;
 
-        // 1. adjust the bitplane modulos if interleaved
-#ifdef INTERLEAVED
-        int bplmod = (image.header.bmdepth - 1) * img_row_bytes;
-        coplist[COPLIST_IDX_BPL1MOD_VALUE] = bplmod;
-        coplist[COPLIST_IDX_BPL2MOD_VALUE] = bplmod;
-#endif
-        // 2. copy the palette to the copper list
-        for (int i = 0; i < num_colors; i++) {
-            coplist[COPLIST_IDX_COLOR00_VALUE + (i << 1)] = image.palette[i];
-        }
-        // 3. prepare bitplanes and point the copper list entries
-        // to the bitplanes
-        int coplist_idx = COPLIST_IDX_BPL1PTH_VALUE;
-        int coplist_split_idx = COPLIST_IDX_BPL1PTH_SECOND_VALUE;
-        int plane_size = image.header.height * img_row_bytes;
-        ULONG addr;
-        for (int i = 0; i < image.header.bmdepth; i++) {
+        // 1. every zone shows the image, the bitplanes of an interleaved
+        // image are one row apart and the modulos skip the other planes
+        for (int i = 0; i < NUM_ZONES; i++) {
+            struct Ratr0SplitZone *zone = &zones[i];
+            zone->bplcon0 = BPLCON0_VALUE;
+            zone->bplcon1 = 0;
+            zone->num_planes = image.header.bmdepth;
+            zone->first_plane = image.imgdata;
 #ifdef INTERLEAVED
-            addr = (ULONG) &(image.imgdata[i * img_row_bytes]);
+            zone->bpl1mod = zone->bpl2mod = (image.header.bmdepth - 1) * img_row_bytes;
+            zone->plane_offset = img_row_bytes;
 #else
-            addr = (ULONG) &(image.imgdata[i * plane_size]);
+            zone->bpl1mod = zone->bpl2mod = 0;
+            zone->plane_offset = image.header.height * img_row_bytes;
 #endif
-            coplist[coplist_idx] = (addr >> 16) & 0xffff;
-            coplist[coplist_idx + 2] = addr & 0xffff;
-            coplist_idx += 4; // next bitplane
-
+            // 2. the palette only needs to be set once
+            zone->num_colors = i == 0 ? 1 << image.header.bmdepth : 0;
+            zone->palette = image.palette;
+        }
+        zones[0].start_line = 0;
 #ifdef SPLIT_SCREEN
-            // and for the second half
-            coplist[coplist_split_idx] = (addr >> 16) & 0xffff;
-            coplist[coplist_split_idx + 2] = addr & 0xffff;
-            coplist_split_idx += 4; // next bitplane
+        zones[1].start_line = SPLIT_LINE;
 #endif
+
+        // 3. build the copper list
+        struct Ratr0CopperBuilder builder;
+        ratr0_copper_begin(&builder, coplist, COPLIST_WORDS);
+        ratr0_copper_move(&builder, FMODE, 0);  // set fetch mode = 0
+        ratr0_copper_move(&builder, DDFSTRT, DDFSTRT_VALUE);
+        ratr0_copper_move(&builder, DDFSTOP, DDFSTOP_VALUE);
+        ratr0_copper_move(&builder, DIWSTRT, DIWSTRT_VALUE);
+        ratr0_copper_move(&builder, DIWSTOP, is_pal ? DIWSTOP_VALUE_PAL : DIWSTOP_VALUE_NTSC);
+        if (!ratr0_emit_split_zones(&builder, zones, NUM_ZONES, zone_slots) ||
+            !ratr0_copper_end(&builder)) {
+            puts("Could not build copper list");
+            ratr0_free_tilesheet_data(&image);
+            reset_display();
+            return 1;
         }
 
-        // 3. disable sprite DMA and initialize the copper list
+        // 4. disable sprite DMA and initialize the copper list
         custom.dmacon  = 0x0020;
         custom.cop1lc = (ULONG) coplist;
         waitmouse();
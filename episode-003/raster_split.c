@@ -0,0 +1,46 @@
+#include <ahpc_registers.h>
+#include "raster_split.h"
+
+// wait for the end of the previous line, the copper needs the horizontal
+// blank to set up the bitplane registers of the zone
+#define ZONE_WAIT_HPOS (0xde)
+
+/**
+ * Emits the copper instructions for a list of zones.
+ *
+ * @param builder the builder, the global display setup (DIW, DDF, ...) is
+ *        expected to be emitted already
+ * @param zones zones, sorted by start line
+ * @param num_zones number of zones, at most MAX_SPLIT_ZONES
+ * @param slots receives the update slots for every zone
+ * @return FALSE if the zones are not sorted, there are too many zones or
+ *         planes, or the copper list is full
+ */
+BOOL ratr0_emit_split_zones(struct Ratr0CopperBuilder *builder,
+                            struct Ratr0SplitZone *zones, UWORD num_zones,
+                            struct Ratr0SplitZoneSlots *slots)
+{
+    if (num_zones > MAX_SPLIT_ZONES) return FALSE;
+    for (int i = 0; i < num_zones; i++) {
+        if (zones[i].num_planes > COPPER_MAX_BITPLANES) return FALSE;
+        if (i > 0 && zones[i].start_line <= zones[i - 1].start_line) return FALSE;
+    }
+
+    for (int i = 0; i < num_zones; i++) {
+        struct Ratr0SplitZone *zone = &zones[i];
+        struct Ratr0SplitZoneSlots *zone_slots = &slots[i];
+        if (zone->start_line > 0) {
+            ratr0_copper_wait(builder, zone->start_line - 1, ZONE_WAIT_HPOS);
+        }
+        ratr0_copper_bitplanes(builder, &zone_slots->bitplanes, zone->num_planes);
+        ratr0_set_copper_bitplanes(&zone_slots->bitplanes, zone->first_plane,
+                                   zone->plane_offset);
+        zone_slots->bplcon0 = ratr0_copper_move(builder, BPLCON0, zone->bplcon0);
+        zone_slots->bplcon1 = ratr0_copper_move(builder, BPLCON1, zone->bplcon1);
+        zone_slots->bpl1mod = ratr0_copper_move(builder, BPL1MOD, zone->bpl1mod);
+        zone_slots->bpl2mod = ratr0_copper_move(builder, BPL2MOD, zone->bpl2mod);
+        zone_slots->colors = zone->num_colors ?
+            ratr0_copper_colors(builder, 0, zone->num_colors, zone->palette) : NULL;
+    }
+    return !builder->overflow;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef __RASTER_SPLIT_H__
+#define __RASTER_SPLIT_H__
+
+#include "copper_builder.h"
+
+/*
+ * Raster split engine.
+ *
+ * The display is divided into horizontal zones, each with its own
+ * bitplanes, modulos, BPLCON0/BPLCON1 and palette. For every zone, a WAIT
+ * for the end of the line before the zone is emitted, followed by the
+ * MOVEs of the zone. The bitplane registers are set first, so they take
+ * effect before the first line of the zone is fetched, the palette MOVEs
+ * follow and can reach into the first line of the zone on a 32 color
+ * screen. Zones starting after line 255 are handled by the copper
+ * builder's line wrap.
+ */
+#define MAX_SPLIT_ZONES (8)
+
+struct Ratr0SplitZone {
+    UWORD start_line;    // beam line, 0 sets up the zone at the top of the frame
+    UWORD bplcon0, bplcon1;
+    WORD bpl1mod, bpl2mod;
+    UWORD num_planes;
+    UBYTE *first_plane;
+    ULONG plane_offset;  // distance between planes, the row size if interleaved
+    UWORD num_colors;    // number of palette entries, 0 keeps the palette
+    UWORD *palette;
+};
+
+// where to update a zone at runtime
+struct Ratr0SplitZoneSlots {
+    UWORD *bplcon0, *bplcon1;
+    UWORD *bpl1mod, *bpl2mod;
+    struct Ratr0CopperBitplanes bitplanes;
+    UWORD *colors;  // every 2 words, NULL if the zone has no palette
+};
+
+extern BOOL ratr0_emit_split_zones(struct Ratr0CopperBuilder *builder,
+                                   struct Ratr0SplitZone *zones, UWORD num_zones,
+                                   struct Ratr0SplitZoneSlots *slots);
+
+#endif /* __RASTER_SPLIT_H__ */
@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <hardware/custom.h>
+extern struct Custom custom;
+
+#include "collision.h"
+
+// CLXDAT bits for sprite pair collisions, indexed by the two pair numbers
+static const UWORD SPRITE_PAIR_BITS[4][4] = {
+    { 0, 0x0200, 0x0400, 0x0800 },
+    { 0x0200, 0, 0x1000, 0x2000 },
+    { 0x0400, 0x1000, 0, 0x4000 },
+    { 0x0800, 0x2000, 0x4000, 0 }
+};
+
+/**
+ * Initializes the collision system for a set of objects. The grid covers
+ * the rectangle at origin_x/origin_y with the given size, objects outside
+ * of it are put into the border cells.
+ *
+ * @param sys the collision system
+ * @param objects the objects, they are read at every detection
+ * @param num_objects number of objects, at most COLL_MAX_OBJECTS
+ * @param origin_x left edge of the grid
+ * @param origin_y top edge of the grid
+ * @param width grid width in pixels
+ * @param height grid height in pixels
+ * @param clxcon value for the CLXCON register
+ * @return FALSE if there are too many objects or the grid is too large
+ */
+BOOL ratr0_init_collision_system(struct Ratr0CollisionSystem *sys,
+                                 struct Ratr0CollisionObject *objects,
+                                 UWORD num_objects,
+                                 WORD origin_x, WORD origin_y,
+                                 UWORD width, UWORD height, UWORD clxcon)
+{
+    UWORD cell_size = 1 << COLL_CELL_SHIFT;
+    sys->cols = (width + cell_size - 1) >> COLL_CELL_SHIFT;
+    sys->rows = (height + cell_size - 1) >> COLL_CELL_SHIFT;
+    if (num_objects > COLL_MAX_OBJECTS || sys->cols * sys->rows > COLL_MAX_CELLS) {
+        puts("ratr0_init_collision_system() error: too many objects or cells");
+        return FALSE;
+    }
+    sys->objects = objects;
+    sys->num_objects = num_objects;
+    sys->origin_x = origin_x;
+    sys->origin_y = origin_y;
+    sys->num_pairs = 0;
+    custom.clxcon = clxcon;
+    sys->clxdat = custom.clxdat;  // reading clears the register
+    return TRUE;
+}
+
+static UWORD cell_col(struct Ratr0CollisionSystem *sys, WORD x)
+{
+    WORD col = (x - sys->origin_x) >> COLL_CELL_SHIFT;
+    return col < 0 ? 0 : col >= sys->cols ? sys->cols - 1 : col;
+}
+
+static UWORD cell_row(struct Ratr0CollisionSystem *sys, WORD y)
+{
+    WORD row = (y - sys->origin_y) >> COLL_CELL_SHIFT;
+    return row < 0 ? 0 : row >= sys->rows ? sys->rows - 1 : row;
+}
+
+/**
+ * Returns the CLXDAT bits that are set if the hardware detects a
+ * collision between the objects, 0 if the hardware can't tell.
+ * Sprites of the same pair are not compared by the hardware.
+ */
+static UWORD clx_bits(struct Ratr0CollisionObject *a, struct Ratr0CollisionObject *b)
+{
+    UWORD bits = 0;
+    if (a->sprite_pairs && b->sprite_pairs) {
+        if (a->sprite_pairs & b->sprite_pairs) return 0;
+        for (int i = 0; i < 4; i++) {
+            if (!(a->sprite_pairs & (1 << i))) continue;
+            for (int j = 0; j < 4; j++) {
+                if (b->sprite_pairs & (1 << j)) bits |= SPRITE_PAIR_BITS[i][j];
+            }
+        }
+    } else if (a->sprite_pairs && (b->flags & COLL_PLAYFIELD)) {
+        // even and odd bitplanes against the sprite pairs
+        bits = (a->sprite_pairs << 1) | (a->sprite_pairs << 5);
+    } else if (b->sprite_pairs && (a->flags & COLL_PLAYFIELD)) {
+        bits = (b->sprite_pairs << 1) | (b->sprite_pairs << 5);
+    }
+    return bits;
+}
+
+// 16 mask bits starting at bit, a missing mask is solid
+static UWORD mask_bits(const UWORD *row, UWORD num_words, UWORD bit)
+{
+    if (!row) return 0xffff;
+    UWORD word = bit >> 4, shift = bit & 15;
+    if (!shift) return row[word];
+    UWORD lo = word + 1 < num_words ? row[word + 1] : 0;
+    return (UWORD) ((row[word] << shift) | (lo >> (16 - shift)));
+}
+
+static BOOL masks_overlap(struct Ratr0CollisionObject *a, struct Ratr0CollisionObject *b,
+                          WORD x0, WORD y0, WORD x1, WORD y1)
+{
+    for (WORD y = y0; y < y1; y++) {
+        const UWORD *row_a = a->mask ? &a->mask[(y - a->y) * a->mask_words] : NULL;
+        const UWORD *row_b = b->mask ? &b->mask[(y - b->y) * b->mask_words] : NULL;
+        for (WORD x = x0; x < x1; x += 16) {
+            UWORD bits = mask_bits(row_a, a->mask_words, x - a->x) &
+                mask_bits(row_b, b->mask_words, x - b->x);
+            if (x1 - x < 16) bits &= 0xffff << (16 - (x1 - x));
+            if (bits) return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void test_pair(struct Ratr0CollisionSystem *sys, UWORD cell, UBYTE ia, UBYTE ib,
+                      BOOL displayed)
+{
+    struct Ratr0CollisionObject *a = &sys->objects[ia], *b = &sys->objects[ib];
+    WORD x0 = a->x > b->x ? a->x : b->x;
+    WORD y0 = a->y > b->y ? a->y : b->y;
+    // objects that share several cells are only tested in the cell of
+    // the top left corner of their intersection
+    if (cell != cell_row(sys, y0) * sys->cols + cell_col(sys, x0)) return;
+
+    UWORD bits = displayed ? clx_bits(a, b) : 0;
+    if (bits && !(sys->clxdat & bits)) {
+        sys->clx_skips++;
+        return;
+    }
+    sys->box_tests++;
+    WORD x1 = a->x + a->width < b->x + b->width ? a->x + a->width : b->x + b->width;
+    WORD y1 = a->y + a->height < b->y + b->height ? a->y + a->height : b->y + b->height;
+    if (x0 >= x1 || y0 >= y1) return;
+    if (a->mask || b->mask) {
+        sys->mask_tests++;
+        if (!masks_overlap(a, b, x0, y0, x1, y1)) return;
+    }
+    if (sys->num_pairs == COLL_MAX_PAIRS) {
+        sys->dropped++;
+        return;
+    }
+    struct Ratr0CollisionPair *pair = &sys->pairs[sys->num_pairs++];
+    if (ia < ib) {
+        pair->a = ia;
+        pair->b = ib;
+    } else {
+        pair->a = ib;
+        pair->b = ia;
+    }
+}
+
+/**
+ * Detects the collisions between the active objects, the result is in
+ * the pairs array. Call once per frame, it reads and clears CLXDAT.
+ * CLXDAT reports the frame that was displayed last, so it is only used to
+ * skip tests if the objects are at their positions of that frame.
+ * Otherwise a collision that the objects have moved into would be found
+ * one frame late.
+ *
+ * @param sys the collision system
+ * @param displayed TRUE if the objects are at the positions of the frame
+ *        that was displayed last
+ * @return the number of colliding pairs
+ */
+UWORD ratr0_detect_collisions(struct Ratr0CollisionSystem *sys, BOOL displayed)
+{
+    UWORD num_cells = sys->cols * sys->rows;
+    UBYTE used_pairs = 0, num_playfield = 0;
+    BOOL hw_covered = TRUE;
+
+    sys->clxdat = custom.clxdat;
+    sys->num_pairs = sys->num_entries = 0;
+    sys->box_tests = sys->mask_tests = sys->clx_skips = sys->dropped = 0;
+
+    // the hardware covers everything if all objects are sprites on
+    // separate pairs, plus at most one object in the matched bitplanes
+    for (int i = 0; i < sys->num_objects && hw_covered; i++) {
+        struct Ratr0CollisionObject *obj = &sys->objects[i];
+        if (!(obj->flags & COLL_ACTIVE)) continue;
+        if (obj->sprite_pairs && !(obj->sprite_pairs & used_pairs)) {
+            used_pairs |= obj->sprite_pairs;
+        } else if (!(obj->flags & COLL_PLAYFIELD) || ++num_playfield > 1) {
+            hw_covered = FALSE;
+        }
+    }
+    if (displayed && hw_covered && !(sys->clxdat & 0x7ffe)) return 0;
+
+    // broadphase: enter the boxes into the grid, an object is tested
+    // against the objects that were entered into the same cell before it
+    for (int i = 0; i < num_cells; i++) sys->cell_head[i] = -1;
+    for (int i = 0; i < sys->num_objects; i++) {
+        struct Ratr0CollisionObject *obj = &sys->objects[i];
+        if (!(obj->flags & COLL_ACTIVE)) continue;
+        UWORD col0 = cell_col(sys, obj->x), col1 = cell_col(sys, obj->x + obj->width - 1);
+        UWORD row0 = cell_row(sys, obj->y), row1 = cell_row(sys, obj->y + obj->height - 1);
+        for (UWORD row = row0; row <= row1; row++) {
+            for (UWORD col = col0; col <= col1; col++) {
+                UWORD cell = row * sys->cols + col;
+                for (WORD e = sys->cell_head[cell]; e >= 0; e = sys->entry_next[e]) {
+                    test_pair(sys, cell, sys->entry_object[e], i, displayed);
+                }
+                if (sys->num_entries == COLL_MAX_ENTRIES) {
+                    sys->dropped++;
+                    continue;
+                }
+                WORD entry = sys->num_entries++;
+                sys->entry_object[entry] = i;
+                sys->entry_next[entry] = sys->cell_head[cell];
+                sys->cell_head[cell] = entry;
+            }
+        }
+    }
+    return sys->num_pairs;
+}
+
+/**
+ * Builds a collision mask column from the data of a hardware sprite:
+ * a pixel is set if any of its 2 bits is set. The mask needs to be
+ * cleared before, the columns of attached sprites can be combined.
+ *
+ * @param mask the mask, height rows of mask_words words
+ * @param mask_words number of words per mask row
+ * @param column word column of the mask to write
+ * @param sprite_data sprite data starting with the control words
+ * @param height number of sprite lines
+ */
+void ratr0_make_sprite_mask(UWORD *mask, UWORD mask_words, UWORD column,
+                            const UWORD *sprite_data, UWORD height)
+{
+    const UWORD *row = &sprite_data[2];
+    for (int i = 0; i < height; i++, row += 2) {
+        mask[i * mask_words + column] |= row[0] | row[1];
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef __COLLISION_H__
+#define __COLLISION_H__
+
+#include <exec/types.h>
+
+/*
+ * Collision detection for sprites and bobs.
+ *
+ * Detection runs in 3 phases:
+ * 1. CLXDAT early-out: objects that are displayed with hardware sprites or
+ *    drawn into bitplanes matched by CLXCON get their collisions flagged by
+ *    the hardware. A pair whose CLXDAT bits are all clear can't collide, if
+ *    the hardware covers all objects and CLXDAT is 0, nothing else is done.
+ *    CLXDAT reports the frame that was displayed last, so this phase only
+ *    runs if the objects are at their positions of that frame.
+ * 2. Broadphase: the bounding boxes are entered into a uniform grid,
+ *    only objects that share a cell are box tested.
+ * 3. Narrowphase: if both objects of an overlapping pair have a mask,
+ *    the masks are tested in the intersection of the boxes. An object
+ *    without a mask counts as a filled box.
+ *
+ * All objects need to use the same coordinate system, e.g. sprite
+ * coordinates, bobs need to be offset accordingly.
+ */
+#define COLL_MAX_OBJECTS   (64)
+#define COLL_MAX_PAIRS     (64)
+#define COLL_MAX_ENTRIES   (256)  // grid entries, an object takes one per cell it touches
+#define COLL_MAX_CELLS     (256)
+#define COLL_CELL_SHIFT    (5)    // 32x32 pixel cells
+
+// CLXCON value to include the odd sprites, needed for attached sprites
+#define CLXCON_ENSP_ALL    (0xf000)
+
+// object flags
+#define COLL_ACTIVE        (1)
+#define COLL_PLAYFIELD     (2)  // drawn into the bitplanes that CLXCON matches
+
+struct Ratr0CollisionObject {
+    WORD x, y;
+    UWORD width, height;
+    UWORD *mask;        // 1 bit per pixel, leftmost pixel in bit 15, or NULL
+    UWORD mask_words;   // words per mask row
+    UBYTE sprite_pairs; // bit n set: displayed with sprites 2n and 2n + 1
+    UBYTE flags;
+};
+
+struct Ratr0CollisionPair {
+    UBYTE a, b;  // object indexes, a < b
+};
+
+struct Ratr0CollisionSystem {
+    struct Ratr0CollisionObject *objects;
+    UWORD num_objects;
+    WORD origin_x, origin_y;
+    UWORD cols, rows;
+    WORD cell_head[COLL_MAX_CELLS];
+    WORD entry_next[COLL_MAX_ENTRIES];
+    UBYTE entry_object[COLL_MAX_ENTRIES];
+    UWORD num_entries;
+
+    struct Ratr0CollisionPair pairs[COLL_MAX_PAIRS];
+    UWORD num_pairs;
+
+    // statistics of the last detection
+    UWORD clxdat;
+    UWORD box_tests, mask_tests, clx_skips, dropped;
+};
+
+extern BOOL ratr0_init_collision_system(struct Ratr0CollisionSystem *sys,
+                                        struct Ratr0CollisionObject *objects,
+                                        UWORD num_objects,
+                                        WORD origin_x, WORD origin_y,
+                                        UWORD width, UWORD height, UWORD clxcon);
+extern UWORD ratr0_detect_collisions(struct Ratr0CollisionSystem *sys, BOOL displayed);
+extern void ratr0_make_sprite_mask(UWORD *mask, UWORD mask_words, UWORD column,
+                                   const UWORD *sprite_data, UWORD height);
+
+#endif /* __COLLISION_H__ */
@@ -214,42 +214,10 @@ static int setup_input_handler(void)
 
 static struct Ratr0SpriteSheet goby_l2r, goby_r2l;
 
-// Composite sprites for the 2 directions
-static ULONG goby_sprite1[4], goby_sprite2[4];
-
-static void set_sprite_pos(UWORD *sprite_data, UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    sprite_data[0] = ((vstart & 0xff) << 8) | ((hstart >> 1) & 0xff);
-    // vstop + high bit of vstart + low bit of hstart
-    sprite_data[1] = ((vstop & 0xff) << 8) |  // vstop 8 low bits
-        ((vstart >> 8) & 1) << 2 |  // vstart high bit
-        ((vstop >> 8) & 1) << 1 |   // vstop high bit
-        (hstart & 1) |              // hstart low bit
-        sprite_data[1] & 0x80;      // preserve attach bit
-}
-
-static void set_sprite_ptrs(ULONG *sprite, int n, int coplist_idx)
-{
-    for (int i = 0; i < n; i++) {
-        coplist[coplist_idx + i * 4] = (sprite[i] >> 16) & 0xffff;
-        coplist[coplist_idx + i * 4 + 2] = sprite[i] & 0xffff;
-    }
-}
-
-static void set_sprite_pos_att32(ULONG sprite[4], UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    set_sprite_pos((UWORD *) sprite[0], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[1], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[2], hstart + 16, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[3], hstart + 16, vstart, vstop);
-}
-
-static void init_composite_sprite(ULONG *sprite, int n, struct Ratr0SpriteSheet *sheet)
-{
-    for (int i = 0; i < n; i++) {
-        sprite[i] = ((ULONG) sheet->imgdata) + sheet->sprite_offsets[i];
-    }
-}
+// Composite sprite, one animation frame per direction
+static struct Ratr0SpriteObject goby;
+#define GOBY_FRAME_L2R (0)
+#define GOBY_FRAME_R2L (1)
 
 static void cleanup(void)
 {
@@ -287,8 +255,7 @@ int main(int argc, char **argv)
         cleanup();
         return 1;
     }
-    init_composite_sprite(goby_sprite1, 4, &goby_l2r);
-    init_composite_sprite(goby_sprite2, 4, &goby_r2l);
+    ratr0_init_sprite_object(&goby, 4, TRUE, 21, &coplist[COPLIST_IDX_SPR0_PTH_VALUE]);
 
     if (is_pal) {
         coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
@@ -329,8 +296,8 @@ int main(int argc, char **argv)
     }
 
     // Set SPRITE DATA START
-    ULONG *curr_goby = goby_sprite1;
-    set_sprite_ptrs(curr_goby, 4, COPLIST_IDX_SPR0_PTH_VALUE);
+    ratr0_add_sprite_frame(&goby, &goby_l2r, 0);
+    ratr0_add_sprite_frame(&goby, &goby_r2l, 0);
 
     // set sprite colors
     for (int i = 1; i < 16; i++) {
@@ -338,8 +305,8 @@ int main(int argc, char **argv)
     }
 
     // and set the sprite position
-    UWORD goby_x = 220, goby_y = 100, goby_height = 21;
-    set_sprite_pos_att32(curr_goby, goby_x, goby_y, goby_y + goby_height);
+    UWORD goby_x = 220, goby_y = 100;
+    ratr0_move_sprite_object(&goby, goby_x, goby_y);
     // SET SPRITE DATA END
 
     // initialize and activate the copper list
@@ -352,18 +319,12 @@ int main(int argc, char **argv)
         // change direction ?
         if (incx > 0 && goby_x > 260) {
             incx = -incx;
-            curr_goby = goby_sprite2;
-
-            // and change sprite pointer to new sprite
-            set_sprite_ptrs(curr_goby, 4, COPLIST_IDX_SPR0_PTH_VALUE);
+            ratr0_set_sprite_frame(&goby, GOBY_FRAME_R2L);
         } else if (incx < 0 && goby_x < 140) {
             incx = -incx;
-            curr_goby = goby_sprite1;
-
-            // and change sprite pointer to new sprite
-            set_sprite_ptrs(curr_goby, 4, COPLIST_IDX_SPR0_PTH_VALUE);
+            ratr0_set_sprite_frame(&goby, GOBY_FRAME_L2R);
         }
-        set_sprite_pos_att32(curr_goby, goby_x, goby_y, goby_y + goby_height);
+        ratr0_move_sprite_object(&goby, goby_x, goby_y);
         goby_x += incx;
     }
 
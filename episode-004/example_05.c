@@ -223,50 +223,8 @@ static int setup_input_handler(void)
 
 static struct Ratr0SpriteSheet goby_l2r, goby_r2l, nemo_l2r, nemo_r2l;
 
-// Composite sprites for the 2 directions
-static ULONG goby_sprite1[4], goby_sprite2[4], nemo_sprite1[2], nemo_sprite2[2];
-
-static void set_sprite_pos(UWORD *sprite_data, UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    sprite_data[0] = ((vstart & 0xff) << 8) | ((hstart >> 1) & 0xff);
-    // vstop + high bit of vstart + low bit of hstart
-    sprite_data[1] = ((vstop & 0xff) << 8) |  // vstop 8 low bits
-        ((vstart >> 8) & 1) << 2 |  // vstart high bit
-        ((vstop >> 8) & 1) << 1 |   // vstop high bit
-        (hstart & 1) |              // hstart low bit
-        sprite_data[1] & 0x80;      // preserve attach bit
-}
-
-static void set_sprite_ptrs(ULONG *sprite, int n, int coplist_idx)
-{
-    for (int i = 0; i < n; i++) {
-        coplist[coplist_idx + i * 4] = (sprite[i] >> 16) & 0xffff;
-        coplist[coplist_idx + i * 4 + 2] = sprite[i] & 0xffff;
-    }
-}
-
-// set position for a composite sprite (attached, 32 pixel wide)
-static void set_sprite_pos_att32(ULONG sprite[4], UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    set_sprite_pos((UWORD *) sprite[0], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[1], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[2], hstart + 16, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[3], hstart + 16, vstart, vstop);
-}
-
-// set position for a composite sprite (non-attached, 32 pixel wide)
-static void set_sprite_pos_32(ULONG sprite[2], UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    set_sprite_pos((UWORD *) sprite[0], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[1], hstart + 16, vstart, vstop);
-}
-
-static void init_composite_sprite(ULONG *sprite, int n, struct Ratr0SpriteSheet *sheet)
-{
-    for (int i = 0; i < n; i++) {
-        sprite[i] = ((ULONG) sheet->imgdata) + sheet->sprite_offsets[i];
-    }
-}
+// Composite sprites, one animation frame per direction
+static struct Ratr0SpriteObject goby, nemo;
 
 static void cleanup(void)
 {
@@ -316,10 +274,9 @@ int main(int argc, char **argv)
         cleanup();
         return 1;
     }
-    init_composite_sprite(goby_sprite1, 4, &goby_l2r);
-    init_composite_sprite(goby_sprite2, 4, &goby_r2l);
-    init_composite_sprite(nemo_sprite1, 2, &nemo_l2r);
-    init_composite_sprite(nemo_sprite2, 2, &nemo_r2l);
+    // nemo uses 2 sprites, goby the 4 after them
+    ratr0_init_sprite_object(&nemo, 2, FALSE, 16, &coplist[COPLIST_IDX_SPR0_PTH_VALUE]);
+    ratr0_init_sprite_object(&goby, 4, TRUE, 21, &coplist[COPLIST_IDX_SPR0_PTH_VALUE + 8]);
 
     if (is_pal) {
         coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
@@ -360,9 +317,10 @@ int main(int argc, char **argv)
     }
 
     // Set SPRITE DATA START
-    ULONG *curr_goby = goby_sprite1, *curr_nemo = nemo_sprite1;
-    set_sprite_ptrs(curr_nemo, 2, COPLIST_IDX_SPR0_PTH_VALUE);  // nemo uses 2 sprites
-    set_sprite_ptrs(curr_goby, 4, COPLIST_IDX_SPR0_PTH_VALUE + 8);
+    ratr0_add_sprite_frame(&nemo, &nemo_l2r, 0);
+    ratr0_add_sprite_frame(&nemo, &nemo_r2l, 0);
+    ratr0_add_sprite_frame(&goby, &goby_l2r, 0);
+    ratr0_add_sprite_frame(&goby, &goby_r2l, 0);
 
     // set sprite colors, goby palette covers nemo palette
     for (int i = 1; i < 16; i++) {
@@ -370,14 +328,14 @@ int main(int argc, char **argv)
     }
 
     // and set the sprite position
-    UWORD goby_x = 225, goby_y = 142, goby_height = 21;
-    UWORD nemo_x = 235, nemo_y = 133, nemo_height = 16;
+    UWORD goby_x = 225, goby_y = 142;
+    UWORD nemo_x = 235, nemo_y = 133;
     if (is_pal) {
         goby_y += 56;
         nemo_y += 56;
     }
-    set_sprite_pos_att32(curr_goby, goby_x, goby_y, goby_y + goby_height);
-    set_sprite_pos_32(curr_nemo, nemo_x, nemo_y, nemo_y + nemo_height);
+    ratr0_move_sprite_object(&goby, goby_x, goby_y);
+    ratr0_move_sprite_object(&nemo, nemo_x, nemo_y);
     // SET SPRITE DATA END
 
     // initialize and activate the copper list
@@ -18,6 +18,8 @@
 
 #include "tilesheet.h"
 #include "sprites.h"
+#include "archive.h"
+#include "collision.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -41,6 +43,8 @@ extern struct Custom custom;
 
 #define IMG_FILENAME_PAL "fishtank_320x256x3.ts"
 #define IMG_FILENAME_NTSC "fishtank_320x200x3.ts"
+// all assets are loaded from a single archive, see the Makefile
+#define ARCHIVE_FILENAME "example_06.pak"
 
 // playfield control
 // single playfield, 3 bitplanes (8 colors)
@@ -124,7 +128,6 @@ static UWORD __chip NULL_SPRITE_DATA[] = {
 };
 
 static volatile ULONG *custom_vposr = (volatile ULONG *) 0xdff004;
-static volatile UWORD *custom_clxdat = (volatile UWORD *) 0xdff00e;
 
 // Wait for this position for vertical blank
 // translated from http://eab.abime.net/showthread.php?t=51928
@@ -216,53 +219,31 @@ static int setup_input_handler(void)
 static struct Ratr0SpriteSheet goby, nemo;
 
 // Composite sprites
-static ULONG goby_sprite[4], nemo_sprite[2];
-
-static void set_sprite_pos(UWORD *sprite_data, UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    sprite_data[0] = ((vstart & 0xff) << 8) | ((hstart >> 1) & 0xff);
-    // vstop + high bit of vstart + low bit of hstart
-    sprite_data[1] = ((vstop & 0xff) << 8) |  // vstop 8 low bits
-        ((vstart >> 8) & 1) << 2 |  // vstart high bit
-        ((vstop >> 8) & 1) << 1 |   // vstop high bit
-        (hstart & 1) |              // hstart low bit
-        sprite_data[1] & 0x80;      // preserve attach bit
-}
-
-static void set_sprite_ptrs(ULONG *sprite, int n, int coplist_idx)
-{
-    for (int i = 0; i < n; i++) {
-        coplist[coplist_idx + i * 4] = (sprite[i] >> 16) & 0xffff;
-        coplist[coplist_idx + i * 4 + 2] = sprite[i] & 0xffff;
-    }
-}
+static struct Ratr0SpriteObject goby_sprite, nemo_sprite;
+
+// Collision objects, the masks are built from the sprite data
+#define COLL_NEMO (0)
+#define COLL_GOBY (1)
+static UWORD nemo_mask[16 * 2], goby_mask[21 * 2];
+static struct Ratr0CollisionSystem collisions;
+// nemo is displayed with sprites 0/1, goby with 2/3 and 4/5
+static struct Ratr0CollisionObject coll_objects[2] = {
+    { 0, 0, 32, 16, nemo_mask, 2, 0x01, COLL_ACTIVE },
+    { 0, 0, 32, 21, goby_mask, 2, 0x06, COLL_ACTIVE }
+};
 
-// set position for a composite sprite (attached, 32 pixel wide)
-static void set_sprite_pos_att32(ULONG sprite[4], UWORD hstart, UWORD vstart, UWORD vstop)
-{
-    set_sprite_pos((UWORD *) sprite[0], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[1], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[2], hstart + 16, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[3], hstart + 16, vstart, vstop);
-}
+static struct Ratr0Archive archive;
 
-// set position for a composite sprite (non-attached, 32 pixel wide)
-static void set_sprite_pos_32(ULONG sprite[2], UWORD hstart, UWORD vstart, UWORD vstop)
+// positions the archive at the named entry
+static BPTR archive_entry(const char *name)
 {
-    set_sprite_pos((UWORD *) sprite[0], hstart, vstart, vstop);
-    set_sprite_pos((UWORD *) sprite[1], hstart + 16, vstart, vstop);
-}
-
-static void init_composite_sprite(ULONG *sprite, int n, struct Ratr0SpriteSheet *sheet)
-{
-    for (int i = 0; i < n; i++) {
-        sprite[i] = ((ULONG) sheet->imgdata) + sheet->sprite_offsets[i];
-    }
+    return ratr0_seek_archive_entry(&archive, ratr0_find_archive_entry(&archive, name));
 }
 
 static void cleanup(void)
 {
     cleanup_input_handler();
+    ratr0_close_archive(&archive);
     ratr0_free_tilesheet_data(&image);
     ratr0_free_spritesheet_data(&goby);
     ratr0_free_spritesheet_data(&nemo);
@@ -280,24 +261,33 @@ int main(int argc, char **argv)
     const char *bgfile = is_pal ? IMG_FILENAME_PAL : IMG_FILENAME_NTSC;
 
     // LOAD IMAGE DATA
-    if (!ratr0_read_tilesheet(bgfile, &image)) {
+    if (!ratr0_open_archive(ARCHIVE_FILENAME, &archive)) {
+        cleanup();
+        return 1;
+    }
+    BPTR fh;
+    if (!(fh = archive_entry(bgfile)) || !ratr0_read_tilesheet_from(fh, bgfile, &image)) {
         puts("Could not read background image");
         cleanup();
         return 1;
     }
     // Read 2 sprite sheets for 2 characters, 2
-    if (!ratr0_read_spritesheet("goby32x21x4_l2r.spr", &goby)) {
+    if (!(fh = archive_entry("goby32x21x4_l2r.spr")) ||
+        !ratr0_read_spritesheet_from(fh, "goby32x21x4_l2r.spr", &goby)) {
         puts("could not read goby sprite");
         cleanup();
         return 1;
     }
-    if (!ratr0_read_spritesheet("nemo32x16x2_r2l.spr", &nemo)) {
+    if (!(fh = archive_entry("nemo32x16x2_r2l.spr")) ||
+        !ratr0_read_spritesheet_from(fh, "nemo32x16x2_r2l.spr", &nemo)) {
         puts("could not read nemo sprite");
         cleanup();
         return 1;
     }
-    init_composite_sprite(goby_sprite, 4, &goby);
-    init_composite_sprite(nemo_sprite, 2, &nemo);
+    ratr0_close_archive(&archive);
+    // nemo uses 2 sprites, goby the 4 after them
+    ratr0_init_sprite_object(&nemo_sprite, 2, FALSE, 16, &coplist[COPLIST_IDX_SPR0_PTH_VALUE]);
+    ratr0_init_sprite_object(&goby_sprite, 4, TRUE, 21, &coplist[COPLIST_IDX_SPR0_PTH_VALUE + 8]);
 
     if (is_pal) {
         coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
@@ -338,8 +328,17 @@ int main(int argc, char **argv)
     }
 
     // Set SPRITE DATA START
-    set_sprite_ptrs(nemo_sprite, 2, COPLIST_IDX_SPR0_PTH_VALUE);  // nemo uses 2 sprites
-    set_sprite_ptrs(goby_sprite, 4, COPLIST_IDX_SPR0_PTH_VALUE + 8);
+    ratr0_add_sprite_frame(&nemo_sprite, &nemo, 0);
+    ratr0_add_sprite_frame(&goby_sprite, &goby, 0);
+
+    ratr0_make_sprite_mask(nemo_mask, 2, 0, nemo_sprite.frames[0][0], 16);
+    ratr0_make_sprite_mask(nemo_mask, 2, 1, nemo_sprite.frames[0][1], 16);
+    for (int i = 0; i < 4; i++) {
+        ratr0_make_sprite_mask(goby_mask, 2, i >> 1, goby_sprite.frames[0][i], 21);
+    }
+    // sprite coordinates, the grid covers the visible area
+    ratr0_init_collision_system(&collisions, coll_objects, 2, 0x80, 0x2c,
+                                DISPLAY_WIDTH, DISPLAY_HEIGHT, CLXCON_ENSP_ALL);
 
     // set sprite colors, goby palette covers nemo palette
     for (int i = 1; i < 16; i++) {
@@ -347,14 +346,14 @@ int main(int argc, char **argv)
     }
 
     // and set the sprite position
-    UWORD goby_x = 220, goby_y = 112, goby_height = 21;
-    UWORD nemo_x = 320, nemo_y = 115, nemo_height = 16;
+    UWORD goby_x = 220, goby_y = 112;
+    UWORD nemo_x = 320, nemo_y = 115;
     if (is_pal) {
         goby_y += 56;
         nemo_y += 56;
     }
-    set_sprite_pos_att32(goby_sprite, goby_x, goby_y, goby_y + goby_height);
-    set_sprite_pos_32(nemo_sprite, nemo_x, nemo_y, nemo_y + nemo_height);
+    ratr0_move_sprite_object(&goby_sprite, goby_x, goby_y);
+    ratr0_move_sprite_object(&nemo_sprite, nemo_x, nemo_y);
     // SET SPRITE DATA END
 
     // initialize and activate the copper list
@@ -362,18 +361,22 @@ int main(int argc, char **argv)
 
     // the event loop
     int goby_incx = 1, nemo_incx = -1;
-    UWORD coll_state = *custom_clxdat; // start with a defined state by clearing the register
     while (!should_exit) {
         wait_vblank();
-        goby_x += goby_incx;
-        nemo_x += nemo_incx;
-        coll_state = *custom_clxdat;
-        if (coll_state & 0x600) {
+        // the collision objects are at the positions of the frame that
+        // was just displayed, which is the frame CLXDAT reports on
+        coll_objects[COLL_NEMO].x = nemo_x;
+        coll_objects[COLL_NEMO].y = nemo_y;
+        coll_objects[COLL_GOBY].x = goby_x;
+        coll_objects[COLL_GOBY].y = goby_y;
+        if (ratr0_detect_collisions(&collisions, TRUE)) {
             // collision !!!
             nemo_incx = goby_incx = 0;
         }
-        set_sprite_pos_att32(goby_sprite, goby_x, goby_y, goby_y + goby_height);
-        set_sprite_pos_32(nemo_sprite, nemo_x, nemo_y, nemo_y + nemo_height);
+        goby_x += goby_incx;
+        nemo_x += nemo_incx;
+        ratr0_move_sprite_object(&goby_sprite, goby_x, goby_y);
+        ratr0_move_sprite_object(&nemo_sprite, nemo_x, nemo_y);
     }
 
     cleanup();
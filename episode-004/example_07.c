@@ -1,5 +1,8 @@
 /**
  * example_07.c - sprite multiplexing demonstration
+ * A school of fish made of more virtual sprites than there are hardware
+ * sprites, distributed over the 8 sprite channels every frame. The
+ * cursor keys move the first fish up and down.
  */
 #include <stdio.h>
 #include <string.h>
@@ -16,6 +19,7 @@
 
 #include "tilesheet.h"
 #include "sprites.h"
+#include "sprite_mux.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -115,12 +119,6 @@ static UWORD __chip coplist[] = {
     COP_WAIT_END
 };
 
-// null sprite data for sprites that are supposed to be inactive
-static UWORD __chip NULL_SPRITE_DATA[] = {
-    0x0000, 0x0000,
-    0x0000, 0x0000
-};
-
 static volatile ULONG *custom_vposr = (volatile ULONG *) 0xdff004;
 
 // Wait for this position for vertical blank
@@ -308,15 +306,25 @@ UWORD __chip sprdata1[] = {
   0x0000, 0x0000
 };
 
-static void set_sprite_pos(UWORD *sprite_data, UWORD hstart, UWORD vstart, UWORD vstop)
+// the fish are 32 pixels wide, made of 2 virtual sprites
+#define NUM_FISH (16)
+#define NUM_VIRTUAL_SPRITES (NUM_FISH * 2)
+#define NEMO_HEIGHT (16)
+#define MIN_FISH_X (128)
+#define MAX_FISH_X (128 + 320 - 32)
+// room for 8 fish in a channel
+#define CHANNEL_WORDS ((2 + NEMO_HEIGHT * 2) * 8 + 2)
+
+static struct Ratr0VirtualSprite virtual_sprites[NUM_VIRTUAL_SPRITES];
+static struct Ratr0SpriteMux sprite_mux;
+static WORD fish_dx[NUM_FISH];
+
+static void set_fish_pos(int fish, UWORD x, UWORD y)
 {
-    sprite_data[0] = ((vstart & 0xff) << 8) | ((hstart >> 1) & 0xff);
-    // vstop + high bit of vstart + low bit of hstart
-    sprite_data[1] = ((vstop & 0xff) << 8) |  // vstop 8 low bits
-        ((vstart >> 8) & 1) << 2 |  // vstart high bit
-        ((vstop >> 8) & 1) << 1 |   // vstop high bit
-        (hstart & 1) |              // hstart low bit
-        sprite_data[1] & 0x80;      // preserve attach bit
+    virtual_sprites[fish * 2].x = x;
+    virtual_sprites[fish * 2].y = y;
+    virtual_sprites[fish * 2 + 1].x = x + 16;
+    virtual_sprites[fish * 2 + 1].y = y;
 }
 
 static void cleanup(void)
@@ -324,6 +332,7 @@ static void cleanup(void)
     cleanup_input_handler();
     ratr0_free_tilesheet_data(&image);
     reset_display();
+    ratr0_free_sprite_mux(&sprite_mux);
 }
 
 int main(int argc, char **argv)
@@ -375,37 +384,38 @@ int main(int argc, char **argv)
         coplist_idx += 4; // next bitplane
     }
 
-    // point sprites 0-7 to nothing
-    for (int i = 0; i < 8; i++) {
-        coplist[COPLIST_IDX_SPR0_PTH_VALUE + i * 4] = (((ULONG) NULL_SPRITE_DATA) >> 16) & 0xffff;
-        coplist[COPLIST_IDX_SPR0_PTH_VALUE + i * 4 + 2] = ((ULONG) NULL_SPRITE_DATA) & 0xffff;
+    // set sprite colors for all sprite pairs, from the nemo palette
+    for (int pair = 0; pair < 4; pair++) {
+        for (int i = 1; i < 4; i++) {
+            coplist[COPLIST_IDX_COLOR00_VALUE + ((16 + pair * 4 + i) * 2)] = nemo_palette[i];
+        }
     }
 
-    // Set SPRITE DATA START
-    // point the sprite data appropriately
-    coplist[COPLIST_IDX_SPR0_PTH_VALUE] = (((ULONG) sprdata0) >> 16) & 0xffff;
-    coplist[COPLIST_IDX_SPR0_PTH_VALUE+ 2] = ((ULONG) sprdata0) & 0xffff;
-    coplist[COPLIST_IDX_SPR0_PTH_VALUE + 4] = (((ULONG) sprdata1) >> 16) & 0xffff;
-    coplist[COPLIST_IDX_SPR0_PTH_VALUE+ 6] = ((ULONG) sprdata1) & 0xffff;
-
-    // set sprite colors, from the nemo palette
-    for (int i = 1; i < 4; i++) {
-        coplist[COPLIST_IDX_COLOR00_VALUE + ((16 + i) * 2)] = nemo_palette[i];
+    // the image rows of the two nemo images follow the control words
+    // in sprdata0 (left half) and sprdata1 (right half)
+    for (int fish = 0; fish < NUM_FISH; fish++) {
+        int image_offset = (fish & 1) ? 36 : 2;
+        for (int half = 0; half < 2; half++) {
+            struct Ratr0VirtualSprite *sprite = &virtual_sprites[fish * 2 + half];
+            sprite->imgdata = (half ? sprdata1 : sprdata0) + image_offset;
+            sprite->height = NEMO_HEIGHT;
+            sprite->visible = TRUE;
+        }
+        set_fish_pos(fish, MIN_FISH_X + (fish * 53) % (MAX_FISH_X - MIN_FISH_X),
+                     48 + (fish % 8) * 24 + (fish / 8) * 8);
+        fish_dx[fish] = (fish & 2) ? 1 : -1;
     }
-
-    // and set the sprite position
-    UWORD nemo1_x = 320, nemo1_y = 48, nemo_height = 16;
-    UWORD nemo2_x = 320;
-
-    // Position for the first use of sprite 0 and 1
-    set_sprite_pos(sprdata0, nemo1_x, nemo1_y, nemo1_y + nemo_height);
-    set_sprite_pos(sprdata1, nemo1_x + 16, nemo1_y, nemo1_y + nemo_height);
-
-    // Position for the second use of sprite 0 and 1
-    set_sprite_pos(&sprdata0[34], nemo1_x, nemo2_y, nemo2_y + nemo_height);
-    set_sprite_pos(&sprdata1[34], nemo2_x, nemo2_y, nemo2_y + nemo_height);
-
-    // SET SPRITE DATA END
+    if (!ratr0_init_sprite_mux(&sprite_mux, virtual_sprites, NUM_VIRTUAL_SPRITES,
+                               MUX_MAX_CHANNELS, CHANNEL_WORDS)) {
+        puts("Could not allocate sprite lists");
+        cleanup();
+        return 1;
+    }
+    // the sprite pointers of the copper list always point to the lists of
+    // the last build, the other buffer is built for the next frame
+    ratr0_build_sprite_mux(&sprite_mux);
+    ratr0_show_sprite_mux(&sprite_mux, &coplist[COPLIST_IDX_SPR0_PTH_VALUE]);
+    ratr0_build_sprite_mux(&sprite_mux);
 
     // initialize and activate the copper list
     custom.cop1lc = (ULONG) coplist;
@@ -413,9 +423,15 @@ int main(int argc, char **argv)
     // the event loop
     while (!should_exit) {
         wait_vblank();
-        // Position for the second use of sprite 0 and 1
-        set_sprite_pos(&sprdata0[34], nemo1_x, nemo2_y, nemo2_y + nemo_height);
-        set_sprite_pos(&sprdata1[34], nemo2_x + 16, nemo2_y, nemo2_y + nemo_height);
+        // show the lists that were built during the last frame
+        ratr0_show_sprite_mux(&sprite_mux, &coplist[COPLIST_IDX_SPR0_PTH_VALUE]);
+
+        for (int fish = 0; fish < NUM_FISH; fish++) {
+            UWORD x = virtual_sprites[fish * 2].x + fish_dx[fish];
+            if (x <= MIN_FISH_X || x >= MAX_FISH_X) fish_dx[fish] = -fish_dx[fish];
+            set_fish_pos(fish, x, fish == 0 ? nemo2_y : virtual_sprites[fish * 2].y);
+        }
+        ratr0_build_sprite_mux(&sprite_mux);
     }
 
     cleanup();
@@ -0,0 +1,148 @@
+#include <exec/memory.h>
+#include <clib/exec_protos.h>
+
+#include "sprite_mux.h"
+
+// the unused channels show this, a null pointer would let them fetch from address 0
+static UWORD __chip empty_sprite[] = { 0, 0 };
+
+/**
+ * Initializes the multiplexer and allocates the DMA lists.
+ *
+ * @param mux the multiplexer
+ * @param sprites the virtual sprites, the multiplexer reads them at every build
+ * @param num_sprites number of virtual sprites, at most MUX_MAX_SPRITES
+ * @param num_channels number of hardware sprites to use, at most MUX_MAX_CHANNELS
+ * @param channel_words size of the DMA list of a channel in words, a sprite
+ *        takes 2 words for the control words and 2 words per line
+ * @return FALSE if the parameters are out of range or there is not enough
+ *         chip memory
+ */
+BOOL ratr0_init_sprite_mux(struct Ratr0SpriteMux *mux,
+                           struct Ratr0VirtualSprite *sprites, UWORD num_sprites,
+                           UWORD num_channels, UWORD channel_words)
+{
+    mux->lists[0] = mux->lists[1] = NULL;
+    if (num_sprites > MUX_MAX_SPRITES || num_channels > MUX_MAX_CHANNELS) return FALSE;
+
+    mux->sprites = sprites;
+    mux->num_sprites = num_sprites;
+    for (int i = 0; i < num_sprites; i++) mux->order[i] = i;
+    mux->num_channels = num_channels;
+    mux->channel_words = channel_words;
+    mux->lists_size = (ULONG) num_channels * channel_words * sizeof(UWORD);
+    mux->back = 0;
+    mux->num_shown = mux->num_dropped = 0;
+
+    // cleared lists are empty lists
+    mux->lists[0] = AllocMem(mux->lists_size, MEMF_CHIP|MEMF_CLEAR);
+    mux->lists[1] = AllocMem(mux->lists_size, MEMF_CHIP|MEMF_CLEAR);
+    if (!mux->lists[0] || !mux->lists[1]) {
+        ratr0_free_sprite_mux(mux);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void ratr0_free_sprite_mux(struct Ratr0SpriteMux *mux)
+{
+    for (int i = 0; i < 2; i++) {
+        if (mux->lists[i]) FreeMem(mux->lists[i], mux->lists_size);
+        mux->lists[i] = NULL;
+    }
+}
+
+/*
+ * Insertion sort by y. The order of the last frame is the starting
+ * point, sprites move little between frames, so this is close to linear.
+ */
+static void sort_sprites(struct Ratr0SpriteMux *mux)
+{
+    UBYTE *order = mux->order;
+    struct Ratr0VirtualSprite *sprites = mux->sprites;
+    for (int i = 1; i < mux->num_sprites; i++) {
+        UBYTE idx = order[i];
+        UWORD y = sprites[idx].y;
+        int j = i - 1;
+        while (j >= 0 && sprites[order[j]].y > y) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = idx;
+    }
+}
+
+/**
+ * Assigns the visible virtual sprites to channels and writes the DMA
+ * lists of the back buffer.
+ */
+void ratr0_build_sprite_mux(struct Ratr0SpriteMux *mux)
+{
+    UWORD free_line[MUX_MAX_CHANNELS];
+    UWORD *pos[MUX_MAX_CHANNELS], *end[MUX_MAX_CHANNELS];
+    UWORD *list = mux->lists[mux->back];
+
+    for (int c = 0; c < mux->num_channels; c++) {
+        free_line[c] = 0;
+        pos[c] = list;
+        // keep 2 words for the end of the list
+        end[c] = list + mux->channel_words - 2;
+        list += mux->channel_words;
+    }
+    mux->num_shown = mux->num_dropped = 0;
+
+    sort_sprites(mux);
+    for (int i = 0; i < mux->num_sprites; i++) {
+        struct Ratr0VirtualSprite *sprite = &mux->sprites[mux->order[i]];
+        if (!sprite->visible) continue;
+
+        UWORD vstart = sprite->y, vstop = sprite->y + sprite->height, hstart = sprite->x;
+        UWORD num_words = 2 + (sprite->height << 1);
+        int c;
+        for (c = 0; c < mux->num_channels; c++) {
+            if (free_line[c] <= vstart && pos[c] + num_words <= end[c]) break;
+        }
+        if (c == mux->num_channels) {
+            mux->num_dropped++;
+            continue;
+        }
+
+        UWORD *dst = pos[c];
+        dst[0] = ((vstart & 0xff) << 8) | ((hstart >> 1) & 0xff);
+        dst[1] = ((vstop & 0xff) << 8) |
+            ((vstart >> 8) & 1) << 2 |
+            ((vstop >> 8) & 1) << 1 |
+            (hstart & 1);
+        // a row is 2 words, copy it as a long word
+        ULONG *dst_rows = (ULONG *) (dst + 2), *src_rows = (ULONG *) sprite->imgdata;
+        for (int row = 0; row < sprite->height; row++) *dst_rows++ = *src_rows++;
+
+        pos[c] += num_words;
+        free_line[c] = vstop + 1;
+        mux->num_shown++;
+    }
+    for (int c = 0; c < mux->num_channels; c++) {
+        pos[c][0] = pos[c][1] = 0;
+    }
+}
+
+/**
+ * Makes the lists of the last build visible and switches the back buffer.
+ *
+ * @param mux the multiplexer
+ * @param sprpt_slot the value word of the SPR0PTH MOVE in the copper list,
+ *        followed by the SPRxPTL and the other channels' MOVEs every 2 words,
+ *        all 8 channels are set, the unused ones to an empty sprite
+ */
+void ratr0_show_sprite_mux(struct Ratr0SpriteMux *mux, UWORD *sprpt_slot)
+{
+    ULONG addr = (ULONG) mux->lists[mux->back];
+    for (int c = 0; c < MUX_MAX_CHANNELS; c++) {
+        ULONG ptr = c < mux->num_channels ? addr : (ULONG) empty_sprite;
+        sprpt_slot[0] = (ptr >> 16) & 0xffff;
+        sprpt_slot[2] = ptr & 0xffff;
+        sprpt_slot += 4;
+        addr += mux->channel_words * sizeof(UWORD);
+    }
+    mux->back ^= 1;
+}
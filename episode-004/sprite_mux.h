@@ -0,0 +1,59 @@
+#pragma once
+#ifndef __SPRITE_MUX_H__
+#define __SPRITE_MUX_H__
+
+#include <exec/types.h>
+
+/*
+ * Sprite multiplexer.
+ *
+ * Virtual sprites are distributed over the hardware sprite channels every
+ * frame. The virtual sprites are sorted by their vertical position and
+ * each one is assigned to the first channel that is free at its top line.
+ * A channel is free again one line after the previous sprite on it ended,
+ * because the sprite DMA fetches the next control words on that line.
+ * The control words and image rows are written into a sprite DMA list
+ * per channel that ends with a pair of 0 words.
+ * Virtual sprites that don't fit into any channel are not shown in this
+ * frame.
+ *
+ * The DMA lists are double buffered: ratr0_build_sprite_mux() writes the
+ * lists the DMA is not reading, ratr0_show_sprite_mux() points the
+ * copper list's sprite pointers to them and the pointers of the unused
+ * channels to an empty sprite. It needs to be called in the
+ * vertical blank, before the copper list runs.
+ * Attached sprites are not supported.
+ */
+#define MUX_MAX_CHANNELS (8)
+#define MUX_MAX_SPRITES (64)
+
+struct Ratr0VirtualSprite {
+    UWORD *imgdata;  // height rows of 2 words, without control words
+    UWORD height;
+    UWORD x, y;      // hstart and vstart in sprite coordinates
+    BOOL visible;
+};
+
+struct Ratr0SpriteMux {
+    struct Ratr0VirtualSprite *sprites;
+    UWORD num_sprites;
+    UBYTE order[MUX_MAX_SPRITES];  // sprite indexes sorted by y
+
+    UWORD num_channels;   // channels 0 to num_channels - 1 are used
+    UWORD channel_words;  // size of a channel's DMA list in words
+    UWORD *lists[2];      // chip memory, num_channels lists each
+    ULONG lists_size;
+    int back;
+
+    // result of the last build
+    UWORD num_shown, num_dropped;
+};
+
+extern BOOL ratr0_init_sprite_mux(struct Ratr0SpriteMux *mux,
+                                  struct Ratr0VirtualSprite *sprites, UWORD num_sprites,
+                                  UWORD num_channels, UWORD channel_words);
+extern void ratr0_free_sprite_mux(struct Ratr0SpriteMux *mux);
+extern void ratr0_build_sprite_mux(struct Ratr0SpriteMux *mux);
+extern void ratr0_show_sprite_mux(struct Ratr0SpriteMux *mux, UWORD *sprpt_slot);
+
+#endif /* __SPRITE_MUX_H__ */
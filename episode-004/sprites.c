@@ -2,34 +2,219 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dos/dos.h>
 #include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
 #include <clib/graphics_protos.h>
 #include <hardware/custom.h>
 extern struct Custom custom;
 
+#include "tilesheet.h"
 #include "sprites.h"
 
+static BOOL read_fully(BPTR fh, APTR buffer, LONG size)
+{
+    return size == 0 || Read(fh, buffer, size) == size;
+}
+
+/**
+ * Reads a RATR0 sprite sheet from an open file, e.g. an archive entry.
+ * The header is validated before anything else is read, the image data is
+ * read directly into chip memory.
+ *
+ * @param fh file handle positioned at the start of the sprite sheet
+ * @param filename name for error messages
+ * @param sheet pointer to a Ratr0SpriteSheet structure
+ * @return the number of image bytes read, 0 on error
+ */
+ULONG ratr0_read_spritesheet_from(BPTR fh, const char *filename, struct Ratr0SpriteSheet *sheet)
+{
+    struct Ratr0SpriteSheetHeader *header = &sheet->header;
+    const char *error = NULL;
+
+    sheet->imgdata = NULL;
+    if (!read_fully(fh, header, sizeof(struct Ratr0SpriteSheetHeader))) {
+        error = "truncated header";
+    } else if (memcmp(header->id, SPRITESHEET_ID, FILE_ID_LEN)) {
+        error = "not a sprite sheet";
+    } else if (header->version != SPRITESHEET_VERSION) {
+        error = "unsupported version";
+    } else if (header->num_sprites > MAX_SPRITES_PER_SHEET ||
+               header->palette_size > MAX_SPRITE_PALETTE_SIZE) {
+        error = "too many sprites or colors";
+    } else if (!read_fully(fh, sheet->sprite_offsets, header->num_sprites * sizeof(UWORD)) ||
+               !read_fully(fh, sheet->palette, header->palette_size * sizeof(UWORD))) {
+        error = "truncated sprite table";
+    } else if (!(sheet->imgdata = AllocMem(header->imgdata_size, MEMF_CHIP))) {
+        error = "not enough chip memory";
+    } else if (!read_fully(fh, sheet->imgdata, header->imgdata_size)) {
+        error = "truncated image data";
+    } else if (header->checksum &&
+               ratr0_checksum(sheet->imgdata, header->imgdata_size) != header->checksum) {
+        error = "checksum mismatch";
+    }
+    if (error) {
+        printf("ratr0_read_spritesheet() error: '%s': %s\n", filename, error);
+        ratr0_free_spritesheet_data(sheet);
+        return 0;
+    }
+    return header->imgdata_size;
+}
+
+/**
+ * Opens the file and reads it with ratr0_read_spritesheet_from().
+ *
+ * @param filename path to the file
+ * @param sheet pointer to a Ratr0SpriteSheet structure
+ */
 ULONG ratr0_read_spritesheet(const char *filename, struct Ratr0SpriteSheet *sheet)
 {
-    int elems_read;
-    ULONG retval = 0;
-    FILE *fp = fopen(filename, "rb");
-
-    if (fp) {
-        elems_read = fread(&sheet->header, sizeof(struct Ratr0SpriteSheetHeader), 1, fp);
-        elems_read = fread(&sheet->sprite_offsets, sizeof(UWORD), sheet->header.num_sprites, fp);
-        elems_read = fread(&sheet->palette, sizeof(UWORD), sheet->header.palette_size, fp);
-        sheet->imgdata = AllocMem(sheet->header.imgdata_size, MEMF_CHIP|MEMF_CLEAR);
-        elems_read = fread(sheet->imgdata, sizeof(UBYTE), sheet->header.imgdata_size, fp);
-        fclose(fp);
-        retval = elems_read;
-    } else {
+    BPTR fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!fh) {
+        sheet->imgdata = NULL;
         printf("ratr0_read_spritesheet() error: file '%s' not found\n", filename);
+        return 0;
     }
-    return retval;
+    ULONG result = ratr0_read_spritesheet_from(fh, filename, sheet);
+    Close(fh);
+    return result;
 }
 
 void ratr0_free_spritesheet_data(struct Ratr0SpriteSheet *sheet)
 {
     if (sheet && sheet->imgdata) FreeMem(sheet->imgdata, sheet->header.imgdata_size);
+    if (sheet) sheet->imgdata = NULL;
+}
+
+static UWORD encode_sprite_pos(UWORD hstart, UWORD vstart)
+{
+    return ((vstart & 0xff) << 8) | ((hstart >> 1) & 0xff);
+}
+
+static UWORD encode_sprite_ctl(UWORD hstart, UWORD vstart, UWORD vstop)
+{
+    return ((vstop & 0xff) << 8) |  // vstop 8 low bits
+        ((vstart >> 8) & 1) << 2 |  // vstart high bit
+        ((vstop >> 8) & 1) << 1 |   // vstop high bit
+        (hstart & 1);               // hstart low bit
+}
+
+/**
+ * Writes the cached control words into the parts of a frame. The attach
+ * bit stays as it was set in the sprite sheet.
+ */
+static void write_sprite_ctl(struct Ratr0SpriteObject *obj, UWORD frame, BOOL write_ctl)
+{
+    for (int i = 0; i < obj->num_parts; i++) {
+        UWORD *data = obj->frames[frame][i];
+        data[0] = (obj->pos & 0xff00) | ((obj->pos + obj->pos_add[i]) & 0xff);
+        if (write_ctl) data[1] = obj->ctl | (data[1] & 0x80);
+    }
+}
+
+static void write_sprite_ptrs(struct Ratr0SpriteObject *obj)
+{
+    if (!obj->sprpt_slot) return;
+    for (int i = 0; i < obj->num_parts; i++) {
+        ULONG addr = (ULONG) obj->frames[obj->curr_frame][i];
+        obj->sprpt_slot[i * 4] = (addr >> 16) & 0xffff;
+        obj->sprpt_slot[i * 4 + 2] = addr & 0xffff;
+    }
+}
+
+/**
+ * Initializes an empty sprite object. Frames are added with
+ * ratr0_add_sprite_frame(), the object is placed with
+ * ratr0_move_sprite_object().
+ *
+ * @param obj the sprite object
+ * @param num_parts number of hardware sprites, 1-4
+ * @param attached TRUE if the parts are attached pairs
+ * @param height height in lines
+ * @param sprpt_slot copper list value slot of the first part's SPRxPTH,
+ *        the following parts are expected at a stride of 4 words
+ */
+void ratr0_init_sprite_object(struct Ratr0SpriteObject *obj, UWORD num_parts,
+                              BOOL attached, UWORD height, UWORD *sprpt_slot)
+{
+    if (num_parts > MAX_SPRITE_PARTS) num_parts = MAX_SPRITE_PARTS;
+    obj->num_parts = num_parts;
+    obj->num_frames = 0;
+    obj->attached = attached;
+    obj->height = height;
+    obj->x = obj->y = 0;
+    obj->pos = encode_sprite_pos(0, 0);
+    obj->ctl = encode_sprite_ctl(0, 0, height);
+    obj->curr_frame = 0;
+    obj->sprpt_slot = sprpt_slot;
+    for (int i = 0; i < num_parts; i++) {
+        // every 16 pixels add 8 to the hstart bits of the pos word
+        obj->pos_add[i] = (attached ? (i >> 1) : i) * 8;
+    }
+}
+
+/**
+ * Adds an animation frame whose parts are consecutive sprites of a sheet.
+ *
+ * @param obj the sprite object
+ * @param sheet the sprite sheet holding the frame
+ * @param first_sprite index of the frame's first part in the sheet
+ * @return TRUE on success, FALSE if the frame does not fit
+ */
+BOOL ratr0_add_sprite_frame(struct Ratr0SpriteObject *obj,
+                            struct Ratr0SpriteSheet *sheet, UWORD first_sprite)
+{
+    if (obj->num_frames >= MAX_SPRITE_FRAMES ||
+        first_sprite + obj->num_parts > sheet->header.num_sprites) {
+        puts("ratr0_add_sprite_frame() error: frame does not fit");
+        return FALSE;
+    }
+    UWORD frame = obj->num_frames++;
+    for (int i = 0; i < obj->num_parts; i++) {
+        obj->frames[frame][i] = (UWORD *) &sheet->imgdata[sheet->sprite_offsets[first_sprite + i]];
+    }
+    write_sprite_ctl(obj, frame, TRUE);
+    if (frame == obj->curr_frame) write_sprite_ptrs(obj);
+    return TRUE;
+}
+
+/**
+ * Moves the sprite object. The control words are only recomputed for the
+ * fields that changed and written into the parts of the current frame, a
+ * horizontal move usually only touches the pos words.
+ *
+ * @param obj the sprite object
+ * @param x horizontal sprite coordinate of the left edge
+ * @param y vertical sprite coordinate of the top edge
+ */
+void ratr0_move_sprite_object(struct Ratr0SpriteObject *obj, UWORD x, UWORD y)
+{
+    if (x == obj->x && y == obj->y) return;
+    UWORD ctl = obj->ctl;
+    if (y != obj->y) {
+        ctl = encode_sprite_ctl(x, y, y + obj->height);
+    } else if ((x ^ obj->x) & 1) {
+        ctl ^= 1;
+    }
+    obj->x = x;
+    obj->y = y;
+    obj->pos = encode_sprite_pos(x, y);
+    BOOL write_ctl = ctl != obj->ctl;
+    obj->ctl = ctl;
+    if (obj->num_frames) write_sprite_ctl(obj, obj->curr_frame, write_ctl);
+}
+
+/**
+ * Switches to another animation frame. The cached control words are copied
+ * into the frame's parts and the copper list is pointed at them.
+ *
+ * @param obj the sprite object
+ * @param frame index of the frame
+ */
+void ratr0_set_sprite_frame(struct Ratr0SpriteObject *obj, UWORD frame)
+{
+    if (frame == obj->curr_frame || frame >= obj->num_frames) return;
+    obj->curr_frame = frame;
+    write_sprite_ctl(obj, frame, TRUE);
+    write_sprite_ptrs(obj);
 }
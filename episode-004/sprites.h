@@ -2,7 +2,11 @@
 #ifndef __LEVEL_H__
 #define __LEVEL_H__
 
+#include <dos/dos.h>
+
 #define FILE_ID_LEN (8)
+#define SPRITESHEET_ID "RATR0SPR"
+#define SPRITESHEET_VERSION (1)
 
 struct Ratr0SpriteSheetHeader {
     UBYTE id[FILE_ID_LEN];
@@ -23,6 +27,35 @@ struct Ratr0SpriteSheet {
 };
 
 extern ULONG ratr0_read_spritesheet(const char *filename, struct Ratr0SpriteSheet *sheet);
+extern ULONG ratr0_read_spritesheet_from(BPTR fh, const char *filename, struct Ratr0SpriteSheet *sheet);
 extern void ratr0_free_spritesheet_data(struct Ratr0SpriteSheet *sheet);
 
+/*
+ * A sprite object combines up to 4 hardware sprites into one movable object,
+ * e.g. a 32 pixel wide attached sprite. The SPRxPOS/SPRxCTL words are encoded
+ * once per move and cached, every animation frame has its own table of part
+ * pointers, so changing the frame only swaps the table and the copper pointers.
+ */
+#define MAX_SPRITE_PARTS (4)
+#define MAX_SPRITE_FRAMES (8)
+
+struct Ratr0SpriteObject {
+    UWORD num_parts, num_frames;
+    BOOL attached;     // parts form attached pairs: 0/1 at x, 2/3 at x + 16
+    UWORD height;
+    UWORD x, y;
+    UWORD pos, ctl;    // cached control words of the leftmost part
+    UWORD pos_add[MAX_SPRITE_PARTS];  // per part hstart offset in pos units
+    UWORD curr_frame;
+    UWORD *frames[MAX_SPRITE_FRAMES][MAX_SPRITE_PARTS];
+    UWORD *sprpt_slot; // value slot of SPRxPTH in the copper list or NULL
+};
+
+extern void ratr0_init_sprite_object(struct Ratr0SpriteObject *obj, UWORD num_parts,
+                                     BOOL attached, UWORD height, UWORD *sprpt_slot);
+extern BOOL ratr0_add_sprite_frame(struct Ratr0SpriteObject *obj,
+                                   struct Ratr0SpriteSheet *sheet, UWORD first_sprite);
+extern void ratr0_move_sprite_object(struct Ratr0SpriteObject *obj, UWORD x, UWORD y);
+extern void ratr0_set_sprite_frame(struct Ratr0SpriteObject *obj, UWORD frame);
+
 #endif /* __LEVEL_H__ */
@@ -1,32 +1,97 @@
 #include <stdio.h>
+#include <string.h>
+#include <dos/dos.h>
 #include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
 #include "tilesheet.h"
 
+/*
+ * Reads exactly size bytes with a single unbuffered dos.library Read().
+ * A short read means that the file is truncated.
+ */
+static BOOL read_fully(BPTR fh, APTR buffer, LONG size)
+{
+    return size == 0 || Read(fh, buffer, size) == size;
+}
+
 /**
- * Reads the image information from specified RATR0 tile sheet file.
+ * Computes the checksum that is stored in the asset file headers: the 16 bit
+ * sum of the data words. A checksum of 0 in a header means "not set".
  *
- * @param filename path to the tile sheet file
+ * @param data pointer to the data
+ * @param size size of the data in bytes, a trailing odd byte is the high byte
+ * @return checksum
+ */
+UWORD ratr0_checksum(UBYTE *data, ULONG size)
+{
+    UWORD sum = 0;
+    UWORD *words = (UWORD *) data;
+    for (ULONG i = 0; i < size / 2; i++) sum += words[i];
+    if (size & 1) sum += data[size - 1] << 8;
+    return sum;
+}
+
+/**
+ * Reads a RATR0 tile sheet from an open file, e.g. an archive entry.
+ * The header is read and validated first, then the palette and the image
+ * data is read directly into chip memory.
+ *
+ * @param fh file handle positioned at the start of the tile sheet
+ * @param filename name for error messages
  * @param sheet pointer to a Ratr0TileSheet structure
+ * @return 1 on success, 0 on error
  */
-ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
+ULONG ratr0_read_tilesheet_from(BPTR fh, const char *filename, struct Ratr0TileSheet *sheet)
 {
-    int elems_read;
-    ULONG retval = 0;
+    struct Ratr0TileSheetHeader *header = &sheet->header;
+    const char *error = NULL;
 
-    FILE *fp = fopen(filename, "rb");
+    sheet->imgdata = NULL;
+    if (!read_fully(fh, header, sizeof(struct Ratr0TileSheetHeader))) {
+        error = "truncated header";
+    } else if (memcmp(header->id, TILESHEET_ID, FILE_ID_LEN)) {
+        error = "not a tile sheet";
+    } else if (header->version != TILESHEET_VERSION) {
+        error = "unsupported version";
+    } else if (header->palette_size > MAX_PALETTE_SIZE) {
+        error = "palette too large";
+    } else if (header->imgdata_size < (ULONG) header->width / 8 * header->height * header->bmdepth) {
+        error = "image data too small";
+    } else if (!read_fully(fh, sheet->palette, header->palette_size * sizeof(UWORD))) {
+        error = "truncated palette";
+    } else if (!(sheet->imgdata = AllocMem(header->imgdata_size, MEMF_CHIP))) {
+        error = "not enough chip memory";
+    } else if (!read_fully(fh, sheet->imgdata, header->imgdata_size)) {
+        error = "truncated image data";
+    } else if (header->checksum &&
+               ratr0_checksum(sheet->imgdata, header->imgdata_size) != header->checksum) {
+        error = "checksum mismatch";
+    }
+    if (error) {
+        printf("ratr0_read_tilesheet() error: '%s': %s\n", filename, error);
+        ratr0_free_tilesheet_data(sheet);
+        return 0;
+    }
+    return 1;
+}
 
-    if (fp) {
-        int num_img_bytes;
-        elems_read = fread(&sheet->header, sizeof(struct Ratr0TileSheetHeader), 1, fp);
-        elems_read = fread(&sheet->palette, sizeof(UWORD), sheet->header.palette_size, fp);
-        sheet->imgdata = AllocMem(sheet->header.imgdata_size, MEMF_CHIP|MEMF_CLEAR);
-        elems_read = fread(sheet->imgdata, sizeof(unsigned char), sheet->header.imgdata_size, fp);
-        fclose(fp);
-        return 1;
-    } else {
+/**
+ * Opens the file and reads it with ratr0_read_tilesheet_from().
+ *
+ * @param filename path to the file
+ * @param sheet pointer to a Ratr0TileSheet structure
+ */
+ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
+{
+    BPTR fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!fh) {
+        sheet->imgdata = NULL;
         printf("ratr0_read_tilesheet() error: file '%s' not found\n", filename);
         return 0;
     }
+    ULONG result = ratr0_read_tilesheet_from(fh, filename, sheet);
+    Close(fh);
+    return result;
 }
 
 /**
@@ -35,5 +100,6 @@ ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
 void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet)
 {
     if (sheet && sheet->imgdata) FreeMem(sheet->imgdata, sheet->header.imgdata_size);
+    if (sheet) sheet->imgdata = NULL;
 }
 
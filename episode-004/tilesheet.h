@@ -2,8 +2,12 @@
 #ifndef __TILESHEET_H__
 #define __TILESHEET_H__
 
+#include <dos/dos.h>
+
 // information about a tile sheet
 #define FILE_ID_LEN (8)
+#define TILESHEET_ID "RATR0TIL"
+#define TILESHEET_VERSION (2)
 
 // information about a tile sheet
 // File format version 2
@@ -29,7 +33,9 @@ struct Ratr0TileSheet {
     UBYTE *imgdata;
 };
 
+extern UWORD ratr0_checksum(UBYTE *data, ULONG size);
 extern ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet);
+extern ULONG ratr0_read_tilesheet_from(BPTR fh, const char *filename, struct Ratr0TileSheet *sheet);
 extern void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet);
 
 #endif /* __TILESHEET_H__ */
@@ -0,0 +1,767 @@
+#include <hardware/custom.h>
+#include <clib/exec_protos.h>
+#include <clib/graphics_protos.h>
+
+#include "bobs.h"
+#include "blit_cost.h"
+
+extern struct Custom custom;
+
+#define DMACONR_BZERO (0x2000)  // blitter zero: the last blit only produced 0 words
+
+/*
+  Computes the blit parameters to blit an aligned source to anywhere in the
+  destination.
+
+  Parameters:
+  - blit: the resulting register values and pointers
+  - bobs: a tile sheet that is assumed to include an additional mask plane
+  - background is the background image to blit into
+  - tilex, tiley: rather than pixel positions, this is the tile position
+    within the bobs and masks sheets
+  - dstx, dsty: The target coordinates to blit the object to within the
+    background image
+
+  Note:
+  the blit is not clipped, use ratr0_clip_bob_blit() on the result if the
+  bob can be partially outside of the background
+
+  If the background is interleaved, the bob sheet is expected to be
+  interleaved as well (see ratr0_interleave_tilesheet()) with the mask rows
+  replicated for every plane. The blit then covers
+  tile_height * bmdepth lines and all planes are drawn at once.
+*/
+void ratr0_compute_bob_blit(struct Ratr0BobBlit *blit,
+                            struct Ratr0TileSheet *bobs,
+                            struct Ratr0TileSheet *background,
+                            int tilex, int tiley,
+                            int dstx, int dsty)
+{
+    // actual object width (without the padding)
+    int tile_width_pixels = bobs->header.tile_width - SHIFT_PADDING;
+
+    // this tile's x-position relative to the word containing it
+    int tile_x0 = bobs->header.tile_width * tilex & 0x0f;
+
+    // 1. determine how wide the blit actually is
+    int blit_width = tile_width_pixels / 16;
+
+    // width not a multiple of 16 ? -> add 1 to the width
+    if (tile_width_pixels & 0x0f) blit_width++;
+
+    int blit_width0_pixels = blit_width * 16;  // blit width in pixels
+
+    // Final source blit width: does the tile extend into an additional word ?
+    int src_blit_width = blit_width;
+    if (tile_x0 > blit_width0_pixels - tile_width_pixels) src_blit_width++;
+
+    // 2. Determine the amount of shift and the first word in the
+    // destination
+    int dst_x0 = dstx & 0x0f;  // destination x relative to the containing word
+    int dst_shift = dst_x0 - tile_x0;  // shift amount
+    int dst_blit_width = blit_width;
+    int dst_offset = 0;
+
+    // negative shift => shift is to the left, so we extend the shift to the
+    // left and right-shift in the previous word so we always right-shift
+    if (dst_shift < 0) {
+        dst_shift = 16 + dst_shift;
+        dst_blit_width++;
+        dst_offset = -2;
+    }
+
+    // make the blit wider if it needs more space
+    if (dst_x0 > blit_width0_pixels - tile_width_pixels) {
+        dst_blit_width++;
+    }
+
+    UWORD alwm = 0xffff;
+    int final_blit_width = src_blit_width;
+
+    // due to relative positioning and shifts, the destination blit width
+    // can be larger than the source blit, so we use the larger of the 2
+    // and mask out last word of the source
+    if (dst_blit_width > src_blit_width) {
+        final_blit_width = dst_blit_width;
+        alwm = 0;
+    }
+    blit->bltafwm = 0xffff;
+    blit->bltalwm = alwm;
+    blit->width_words = final_blit_width;
+
+    // cookie cut enable channels B, C and D, LF => D = AB + ~AC => 0xca
+    // A = Mask sheet
+    // B = Tile sheet
+    // C = Background
+    // D = Background
+    blit->bltcon0 = 0x0fca | (dst_shift << 12);
+    blit->bltcon1 = dst_shift << 12;  // shift in B
+
+    // modulos are in bytes
+    blit->srcmod = bobs->header.width / 8 - (final_blit_width * 2);
+    blit->dstmod = background->header.width / 8 - (final_blit_width * 2);
+
+    // map the tile position to physical coordinates in the tile sheet
+    int srcx = tilex * bobs->header.tile_width;
+    int srcy = tiley * bobs->header.tile_height;
+
+    int bobs_plane_size = bobs->header.width / 8 * bobs->header.height;
+    int bobs_line_bytes = bobs->header.width / 8;
+    int bg_line_bytes = background->header.width / 8;
+
+    if (background->header.flags & TSFLAGS_NON_INTERLEAVED) {
+        // The blit size is the size of a plane of the tile size
+        blit->height = bobs->header.tile_height;
+        blit->lines_per_row = 1;
+        blit->num_planes = bobs->header.bmdepth;
+        blit->src_plane_size = bobs_plane_size;
+        blit->dst_plane_size = background->header.width / 8 * background->header.height;
+    } else {
+        // a line in an interleaved image consists of one row for every plane,
+        // the blit covers the tile rows of all planes
+        bobs_line_bytes *= bobs->header.bmdepth;
+        bg_line_bytes *= background->header.bmdepth;
+        blit->height = bobs->header.tile_height * bobs->header.bmdepth;
+        blit->lines_per_row = bobs->header.bmdepth;
+        blit->num_planes = 1;
+        blit->src_plane_size = 0;
+        blit->dst_plane_size = 0;
+    }
+    blit->rows = bobs->header.tile_height;
+    blit->src_row_bytes = bobs_line_bytes;
+    blit->dst_row_bytes = bg_line_bytes;
+    // dstx can be negative, so we can't just divide by 8
+    blit->dst_word0 = (dstx >> 4) + (dst_offset >> 1);
+    blit->dsty = dsty;
+
+    blit->src = bobs->imgdata + srcy * bobs_line_bytes + srcx / 8;
+    // The mask data follows the source image planes
+    blit->mask = bobs->imgdata + bobs_plane_size * bobs->header.bmdepth +
+        srcy * bobs_line_bytes + srcx / 8;
+    blit->dst = background->imgdata + dsty * bg_line_bytes + blit->dst_word0 * 2;
+}
+
+/*
+  Horizontal part of ratr0_clip_bob_blit(): reduces the blit to the source
+  pixels sa to sb (exclusive), counted from the first source word. The
+  first and last word masks cut off the other pixels of the mask before
+  the shift, so they can only trim the first and last source word of the
+  blit.
+
+  In ascending mode, destination word i receives the low bits of source
+  word i - 1 and the high bits of source word i. The last source word can
+  only be trimmed if its pixels don't spill into the next destination
+  word, otherwise that word needs an extra source word with the last word
+  mask cleared.
+  A descending blit that starts 1 source word earlier with a shift of
+  16 - shift pairs destination word i with source word i - 1 instead, so
+  the masks trim the source words at the other positions: the first word
+  mask the rightmost, the last word mask the leftmost source word.
+
+  Words that only receive masked out pixels are written back unchanged,
+  they just have to be within the destination row.
+
+  Returns FALSE if neither direction can trim both ends.
+*/
+static BOOL clip_horizontal(struct Ratr0BobBlit *blit, WORD sa, WORD sb, WORD row_words)
+{
+    UWORD shift = blit->bltcon0 >> 12;
+    // first and last visible source word and destination word
+    WORD fa = sa >> 4, la = (sb - 1) >> 4;
+    WORD da = (sa + shift) >> 4, db = (sb - 1 + shift) >> 4;
+    UWORD fmask = 0xffff >> (sa & 0x0f);
+    UWORD lmask = 0xffff << (15 - ((sb - 1) & 0x0f));
+    WORD first, width, src_word;
+
+    if ((db == la || lmask == 0xffff) && blit->dst_word0 + fa >= 0) {
+        // ascending: source word fa goes to destination word fa and if
+        // its visible pixels start in the next word, fa only receives 0s
+        first = fa;
+        src_word = fa;
+        width = db - fa + 1;
+        blit->bltafwm = fmask;
+        // the last word can't spill into the next line after the mask
+        blit->bltalwm = db == la ? lmask : 0;
+        if (width == 1) blit->bltafwm &= blit->bltalwm;
+    } else if (shift > 0 && (da > fa || (fmask == 0xffff && fa > 0)) &&
+               blit->dst_word0 + la + 1 < row_words) {
+        // descending: destination words da to la + 1, the leftmost word is
+        // paired with source word da - 1, which is fa or a word without
+        // visible pixels. The visible pixels of fa are all in the low bits
+        // that go to destination word da, so nothing spills into the line
+        // above after the mask.
+        first = da;
+        src_word = da - 1;
+        width = la + 1 - da + 1;
+        blit->bltafwm = lmask;
+        blit->bltalwm = da > fa ? fmask : 0;
+        blit->bltcon0 = (blit->bltcon0 & 0x0fff) | ((16 - shift) << 12);
+        blit->bltcon1 = ((16 - shift) << 12) | 0x02;
+    } else {
+        return FALSE;
+    }
+    blit->src += src_word * 2;
+    blit->mask += src_word * 2;
+    blit->dst += first * 2;
+    blit->dst_word0 += first;
+    blit->srcmod += (blit->width_words - width) * 2;
+    blit->dstmod += (blit->width_words - width) * 2;
+    blit->width_words = width;
+    return TRUE;
+}
+
+/*
+  Clips a bob blit against a clip rectangle by adjusting pointers,
+  modulos, size and first/last word masks. Only the pixels within the clip
+  rectangle are drawn.
+
+  If the bob is cut by both the left and the right clip edge, a single
+  blit might not be able to trim both ends (see clip_horizontal()). The
+  bob is then drawn with 2 blits that are split at a destination word
+  boundary, the second one is stored in rest. Both blits cover the same
+  rows, together they cover adjacent destination words.
+
+  Returns the number of blits to perform, 0 if the bob is completely
+  outside of the clip rectangle.
+*/
+int ratr0_clip_bob_blit(struct Ratr0BobBlit *blit, struct Ratr0ClipRect *clip,
+                        struct Ratr0BobBlit *rest)
+{
+    UWORD shift = blit->bltcon0 >> 12;
+    WORD top = clip->y0 - blit->dsty;
+    WORD bottom = blit->dsty + (WORD) blit->rows - clip->y1;
+    WORD blit_x0 = blit->dst_word0 * 16;
+
+    if (top < 0) top = 0;
+    if (bottom < 0) bottom = 0;
+
+    // fast path: all destination words of the blit are visible
+    if ((top | bottom) == 0 && blit_x0 >= clip->x0 &&
+        blit_x0 + (WORD) blit->width_words * 16 <= clip->x1) return 1;
+
+    if (top + bottom >= blit->rows) return 0;
+
+    // visible source pixels, counted from the first source word: the last
+    // source word is not drawn if its mask is cleared, and pixels shifted out
+    // of the last destination word are in the padding
+    WORD sa = clip->x0 - blit_x0 - shift;
+    WORD sb = clip->x1 - blit_x0 - shift;
+    WORD src_end = (blit->width_words - (blit->bltalwm ? 0 : 1)) * 16;
+    if (src_end > blit->width_words * 16 - shift) src_end = blit->width_words * 16 - shift;
+    if (sa < 0) sa = 0;
+    if (sb > src_end) sb = src_end;
+    if (sa >= sb) return 0;
+
+    // 1. vertical: skip rows at the top and bottom
+    blit->src += top * blit->src_row_bytes;
+    blit->mask += top * blit->src_row_bytes;
+    blit->dst += top * blit->dst_row_bytes;
+    blit->dsty += top;
+    blit->rows -= top + bottom;
+    blit->height = blit->rows * blit->lines_per_row;
+
+    // 2. horizontal
+    WORD row_words = blit->dst_row_bytes / blit->lines_per_row / 2;
+    *rest = *blit;
+    if (clip_horizontal(blit, sa, sb, row_words)) return 1;
+
+    // both ends need a different direction: the last destination word is
+    // drawn separately, each part then only has one clipped end that is not
+    // at a word boundary
+    WORD split = ((sb - 1 + shift) & ~0x0f) - shift;
+    *blit = *rest;
+    if (!clip_horizontal(blit, sa, split, row_words) ||
+        !clip_horizontal(rest, split, sb, row_words)) return 0;
+    return 2;
+}
+
+static void do_bob_blit(struct Ratr0BobBlit *blit)
+{
+    UWORD bltsize = (blit->height << 6) | (blit->width_words & 0x3f);
+    UBYTE *src = blit->src, *mask = blit->mask, *dst = blit->dst;
+
+    if (blit->bltcon1 & 0x02) {
+        // descending: start at the last word of the last line
+        src += (blit->height - 1) * (blit->width_words * 2 + blit->srcmod) +
+            blit->width_words * 2 - 2;
+        mask += (blit->height - 1) * (blit->width_words * 2 + blit->srcmod) +
+            blit->width_words * 2 - 2;
+        dst += (blit->height - 1) * (blit->width_words * 2 + blit->dstmod) +
+            blit->width_words * 2 - 2;
+    }
+
+    WaitBlit();
+    custom.bltafwm = blit->bltafwm;
+    custom.bltalwm = blit->bltalwm;
+    custom.bltcon0 = blit->bltcon0;
+    custom.bltcon1 = blit->bltcon1;
+    custom.bltamod = blit->srcmod;
+    custom.bltbmod = blit->srcmod;
+    custom.bltcmod = blit->dstmod;
+    custom.bltdmod = blit->dstmod;
+
+    for (int i = 0; i < blit->num_planes; i++) {
+        custom.bltapt = mask;
+        custom.bltbpt = src;
+        custom.bltcpt = dst;
+        custom.bltdpt = dst;
+        custom.bltsize = bltsize;
+        ratr0_account_blit(blit->bltcon0, blit->bltcon1, bltsize);
+
+        // Increase the pointers to the next plane
+        src += blit->src_plane_size;
+        dst += blit->dst_plane_size;
+
+        WaitBlit();
+    }
+}
+
+/*
+  Blit function where we can blit an aligned source to anywhere in the
+  destination. See ratr0_compute_bob_blit() for the parameters.
+*/
+void ratr0_blit_object(struct Ratr0TileSheet *bobs,
+                       struct Ratr0TileSheet *background,
+                       int tilex, int tiley,
+                       int dstx, int dsty)
+{
+    struct Ratr0BobBlit blit;
+    ratr0_compute_bob_blit(&blit, bobs, background, tilex, tiley, dstx, dsty);
+    do_bob_blit(&blit);
+}
+
+/*
+  Same as ratr0_blit_object(), but only draws the part of the bob that
+  is within the clip rectangle
+*/
+void ratr0_blit_object_clipped(struct Ratr0TileSheet *bobs,
+                               struct Ratr0TileSheet *background,
+                               int tilex, int tiley,
+                               int dstx, int dsty,
+                               struct Ratr0ClipRect *clip)
+{
+    struct Ratr0BobBlit blit, rest;
+    ratr0_compute_bob_blit(&blit, bobs, background, tilex, tiley, dstx, dsty);
+    int num_blits = ratr0_clip_bob_blit(&blit, clip, &rest);
+    if (num_blits > 0) do_bob_blit(&blit);
+    if (num_blits > 1) do_bob_blit(&rest);
+}
+
+/*
+ * Extracts num_pixels pixels starting at x position srcx from a bitplane
+ * row into left aligned words.
+ */
+static void extract_pixels(UBYTE *row, int srcx, int num_pixels, UWORD *out, int num_words)
+{
+    for (int i = 0; i < num_words; i++) out[i] = 0;
+    for (int i = 0; i < num_pixels; i++) {
+        int x = srcx + i;
+        if (row[x >> 3] & (0x80 >> (x & 7))) out[i >> 4] |= 0x8000 >> (i & 15);
+    }
+}
+
+// shift a row of words to the right, the last word of the row receives the
+// bits that are shifted out. The words are stored high byte first, like the
+// blitter reads them.
+static void shift_row(UWORD *in, int num_words, int shift, UBYTE *out)
+{
+    UWORD carry = 0;
+    for (int i = 0; i < num_words; i++) {
+        UWORD word = (in[i] >> shift) | carry;
+        out[i * 2] = word >> 8;
+        out[i * 2 + 1] = word & 0xff;
+        carry = shift ? in[i] << (16 - shift) : 0;
+    }
+}
+
+/**
+ * Generates the pre-shifted copies of all tiles in a bob sheet.
+ *
+ * @param cache the cache to initialize
+ * @param bobs a tile sheet that includes a mask plane
+ * @return TRUE if successful, FALSE if the bobs are too wide or no memory
+ *   could be allocated
+ */
+BOOL ratr0_preshift_tilesheet(struct Ratr0PreshiftCache *cache,
+                              struct Ratr0TileSheet *bobs)
+{
+    UWORD row_words[MAX_PRESHIFT_WORDS];
+    int num_pixels = bobs->header.tile_width - SHIFT_PADDING;
+    int depth = bobs->header.bmdepth;
+    int tile_height = bobs->header.tile_height;
+    int row_bytes = bobs->header.width / 8;
+    int plane_size = row_bytes * bobs->header.height;
+    BOOL interleaved = !(bobs->header.flags & TSFLAGS_NON_INTERLEAVED);
+
+    // one extra word that receives the shifted out pixels
+    int num_words = (num_pixels + 15) / 16 + 1;
+    if (num_words > MAX_PRESHIFT_WORDS) return FALSE;
+    int line_bytes = num_words * 2;
+    int mask_lines = interleaved ? tile_height * depth : tile_height;
+
+    cache->sheet = bobs;
+    cache->width_words = num_words;
+    cache->height = interleaved ? tile_height * depth : tile_height;
+    cache->num_planes = interleaved ? 1 : depth;
+    cache->plane_size = interleaved ? 0 : line_bytes * tile_height;
+    cache->mask_offset = line_bytes * tile_height * depth;
+    cache->shift_size = cache->mask_offset + line_bytes * mask_lines;
+    cache->tile_size = cache->shift_size * 16;
+    cache->data_size = cache->tile_size * bobs->header.num_tiles_h * bobs->header.num_tiles_v;
+    cache->data = AllocMem(cache->data_size, MEMF_CHIP);
+    if (!cache->data) return FALSE;
+
+    UBYTE *tile_data = cache->data;
+    for (int ty = 0; ty < bobs->header.num_tiles_v; ty++) {
+        for (int tx = 0; tx < bobs->header.num_tiles_h; tx++) {
+            int srcx = tx * bobs->header.tile_width;
+            int srcy = ty * tile_height;
+            for (int y = 0; y < tile_height; y++) {
+                // the mask plane is plane number "depth"
+                for (int p = 0; p <= depth; p++) {
+                    UBYTE *src_row;
+                    int line;
+                    if (interleaved) {
+                        src_row = bobs->imgdata + ((srcy + y) * depth + p) * row_bytes;
+                        if (p == depth) src_row = bobs->imgdata + plane_size * depth +
+                                            (srcy + y) * depth * row_bytes;
+                        line = y * depth + (p == depth ? 0 : p);
+                    } else {
+                        src_row = bobs->imgdata + p * plane_size + (srcy + y) * row_bytes;
+                        line = p == depth ? y : p * tile_height + y;
+                    }
+                    extract_pixels(src_row, srcx, num_pixels, row_words, num_words);
+                    for (int s = 0; s < 16; s++) {
+                        UBYTE *dst = tile_data + s * cache->shift_size + line * line_bytes;
+                        if (p < depth) {
+                            shift_row(row_words, num_words, s, dst);
+                        } else {
+                            dst += cache->mask_offset;
+                            shift_row(row_words, num_words, s, dst);
+                            // replicate the mask row for all planes of the line
+                            for (int i = 1; interleaved && i < depth; i++) {
+                                CopyMem(dst, dst + i * line_bytes, line_bytes);
+                            }
+                        }
+                    }
+                }
+            }
+            tile_data += cache->tile_size;
+        }
+    }
+    return TRUE;
+}
+
+void ratr0_free_preshift_cache(struct Ratr0PreshiftCache *cache)
+{
+    if (cache && cache->data) FreeMem(cache->data, cache->data_size);
+}
+
+/*
+  Computes the blit parameters to draw a pre-shifted bob. The shifted copy
+  already contains the sub-word position, so the blit always starts at the
+  word containing dstx and has a fixed width.
+*/
+void ratr0_compute_preshifted_blit(struct Ratr0BobBlit *blit,
+                                   struct Ratr0PreshiftCache *cache,
+                                   struct Ratr0TileSheet *background,
+                                   int tilex, int tiley,
+                                   int dstx, int dsty)
+{
+    int tilenum = tiley * cache->sheet->header.num_tiles_h + tilex;
+    UBYTE *src = cache->data + tilenum * cache->tile_size + (dstx & 0x0f) * cache->shift_size;
+    int bg_line_bytes = background->header.width / 8;
+
+    blit->bltcon0 = 0x0fca;  // D = AB + ~AC, no shift
+    blit->bltcon1 = 0;
+    blit->bltafwm = 0xffff;
+    blit->bltalwm = 0xffff;
+    blit->width_words = cache->width_words;
+    blit->height = cache->height;
+    blit->num_planes = cache->num_planes;
+    blit->srcmod = 0;
+    blit->dstmod = bg_line_bytes - cache->width_words * 2;
+    blit->src_plane_size = cache->plane_size;
+    if (cache->num_planes > 1) {
+        blit->dst_plane_size = bg_line_bytes * background->header.height;
+        blit->lines_per_row = 1;
+    } else {
+        bg_line_bytes *= background->header.bmdepth;
+        blit->dst_plane_size = 0;
+        blit->lines_per_row = background->header.bmdepth;
+    }
+    blit->rows = cache->sheet->header.tile_height;
+    blit->src_row_bytes = cache->width_words * 2 * blit->lines_per_row;
+    blit->dst_row_bytes = bg_line_bytes;
+    blit->dst_word0 = dstx >> 4;
+    blit->dsty = dsty;
+    blit->src = src;
+    blit->mask = src + cache->mask_offset;
+    blit->dst = background->imgdata + dsty * bg_line_bytes + blit->dst_word0 * 2;
+}
+
+/*
+  Blit a pre-shifted bob to anywhere in the destination
+*/
+void ratr0_blit_preshifted_object(struct Ratr0PreshiftCache *cache,
+                                  struct Ratr0TileSheet *background,
+                                  int tilex, int tiley,
+                                  int dstx, int dsty)
+{
+    struct Ratr0BobBlit blit;
+    ratr0_compute_preshifted_blit(&blit, cache, background, tilex, tiley, dstx, dsty);
+    do_bob_blit(&blit);
+}
+
+/*
+ * Straight copy with channels A and D, LF => D = A
+ */
+static void copy_blit(UBYTE *src, UWORD amod, UBYTE *dst, UWORD dmod, UWORD bltsize)
+{
+    WaitBlit();
+    custom.bltcon0 = 0x09f0;
+    custom.bltcon1 = 0;
+    custom.bltafwm = 0xffff;
+    custom.bltalwm = 0xffff;
+    custom.bltamod = amod;
+    custom.bltdmod = dmod;
+    custom.bltapt = src;
+    custom.bltdpt = dst;
+    custom.bltsize = bltsize;
+    ratr0_account_blit(0x09f0, 0, bltsize);
+}
+
+// save the background area that the blit is going to overwrite, a split
+// blit covers the adjacent words of both parts
+static void save_background(struct Ratr0BobSave *save, struct Ratr0BobBlit *blit,
+                            struct Ratr0BobBlit *rest)
+{
+    WORD word0 = blit->dst_word0, word1 = blit->dst_word0 + blit->width_words;
+    if (rest) {
+        if (rest->dst_word0 < word0) word0 = rest->dst_word0;
+        if (rest->dst_word0 + (WORD) rest->width_words > word1) {
+            word1 = rest->dst_word0 + rest->width_words;
+        }
+    }
+    UWORD width_words = word1 - word0;
+    UBYTE *src = blit->dst + (word0 - blit->dst_word0) * 2, *dst = save->buffer;
+
+    save->dst = src;
+    save->dstmod = blit->dstmod - (width_words - blit->width_words) * 2;
+    save->bltsize = (blit->height << 6) | (width_words & 0x3f);
+    save->num_planes = blit->num_planes;
+    save->dst_plane_size = blit->dst_plane_size;
+    save->save_plane_size = width_words * 2 * blit->height;
+
+    for (int i = 0; i < save->num_planes; i++) {
+        copy_blit(src, save->dstmod, dst, 0, save->bltsize);
+        src += save->dst_plane_size;
+        dst += save->save_plane_size;
+    }
+}
+
+static void restore_background(struct Ratr0BobSave *save)
+{
+    UBYTE *src = save->buffer, *dst = save->dst;
+
+    for (int i = 0; i < save->num_planes; i++) {
+        copy_blit(src, 0, dst, save->dstmod, save->bltsize);
+        src += save->save_plane_size;
+        dst += save->dst_plane_size;
+    }
+    save->dst = NULL;
+}
+
+/*
+ * Size of a save area: ratr0_compute_bob_blit() can make a blit 2 words
+ * wider than the object, 1 word if the tile starts late in its source
+ * word and 1 more if the destination shift is to the left and the
+ * object extends into another destination word.
+ */
+static ULONG save_area_bytes(struct Ratr0TileSheetHeader *h)
+{
+    UWORD width_words = (h->tile_width - SHIFT_PADDING + 15) / 16 + 2;
+    return (ULONG) width_words * 2 * h->tile_height * h->bmdepth;
+}
+
+/**
+ * Initializes the bob manager with 2 display buffers that contain the
+ * same background image. The manager does not take ownership of the bobs
+ * or the buffers.
+ *
+ * @param mgr the bob manager
+ * @param front the buffer that is currently displayed
+ * @param back the buffer that is drawn into first
+ * @param bobs array of bobs
+ * @param num_bobs number of bobs, at most MAX_BOBS
+ * @return TRUE if successful, FALSE if the save buffers could not be allocated
+ */
+BOOL ratr0_init_bob_manager(struct Ratr0BobManager *mgr,
+                            struct Ratr0TileSheet *front,
+                            struct Ratr0TileSheet *back,
+                            struct Ratr0Bob *bobs, int num_bobs)
+{
+    ULONG save_size = 0;
+    if (num_bobs > MAX_BOBS) num_bobs = MAX_BOBS;
+
+    mgr->buffers[0] = front;
+    mgr->buffers[1] = back;
+    mgr->back = 1;
+    mgr->bobs = bobs;
+    mgr->num_bobs = num_bobs;
+    mgr->clip.x0 = 0;
+    mgr->clip.y0 = 0;
+    mgr->clip.x1 = front->header.width;
+    mgr->clip.y1 = front->header.height;
+
+    for (int i = 0; i < num_bobs; i++) {
+        save_size += save_area_bytes(&bobs[i].sheet->header);
+    }
+    mgr->save_mem_size = save_size * NUM_BOB_BUFFERS;
+    mgr->save_mem = AllocMem(mgr->save_mem_size, MEMF_CHIP);
+    if (!mgr->save_mem) return FALSE;
+
+    UBYTE *save_buffer = mgr->save_mem;
+    for (int b = 0; b < NUM_BOB_BUFFERS; b++) {
+        for (int i = 0; i < num_bobs; i++) {
+            mgr->saves[b][i].buffer = save_buffer;
+            mgr->saves[b][i].dst = NULL;
+            save_buffer += save_area_bytes(&bobs[i].sheet->header);
+        }
+    }
+    return TRUE;
+}
+
+void ratr0_free_bob_manager(struct Ratr0BobManager *mgr)
+{
+    if (mgr && mgr->save_mem) FreeMem(mgr->save_mem, mgr->save_mem_size);
+}
+
+/**
+ * Draws all visible bobs into the back buffer in one pass:
+ * 1. restore the backgrounds that were saved the last time this buffer
+ *    was drawn to, in reverse order so overlapping bobs are restored
+ *    correctly
+ * 2. save the background at the new positions and draw the bobs
+ * The caller needs to own the blitter.
+ */
+void ratr0_render_bobs(struct Ratr0BobManager *mgr)
+{
+    struct Ratr0TileSheet *buffer = mgr->buffers[mgr->back];
+    struct Ratr0BobSave *saves = mgr->saves[mgr->back];
+    struct Ratr0BobBlit blit, rest;
+
+    for (int i = mgr->num_bobs - 1; i >= 0; i--) {
+        if (saves[i].dst) restore_background(&saves[i]);
+    }
+    for (int i = 0; i < mgr->num_bobs; i++) {
+        struct Ratr0Bob *bob = &mgr->bobs[i];
+        if (!bob->visible) continue;
+        if (bob->cache) {
+            ratr0_compute_preshifted_blit(&blit, bob->cache, buffer, bob->tilex, bob->tiley,
+                                          bob->x, bob->y);
+        } else {
+            ratr0_compute_bob_blit(&blit, bob->sheet, buffer, bob->tilex, bob->tiley,
+                                   bob->x, bob->y);
+        }
+        // the bob is completely outside, so there is nothing to save or draw
+        int num_blits = ratr0_clip_bob_blit(&blit, &mgr->clip, &rest);
+        if (num_blits == 0) {
+            saves[i].dst = NULL;
+            continue;
+        }
+        save_background(&saves[i], &blit, num_blits > 1 ? &rest : NULL);
+        do_bob_blit(&blit);
+        if (num_blits > 1) do_bob_blit(&rest);
+    }
+}
+
+/**
+ * Swaps front and back buffer after rendering. Call this at vertical blank
+ * and point the bitplane pointers to the returned buffer.
+ *
+ * @return the buffer that should be displayed now
+ */
+struct Ratr0TileSheet *ratr0_swap_bob_buffers(struct Ratr0BobManager *mgr)
+{
+    struct Ratr0TileSheet *front = mgr->buffers[mgr->back];
+    mgr->back ^= 1;
+    return front;
+}
+
+// mask row of a bob sheet, interleaved sheets replicate the row for every plane
+static UBYTE *mask_row(struct Ratr0TileSheet *sheet, int row, UWORD *row_bytes)
+{
+    struct Ratr0TileSheetHeader *h = &sheet->header;
+    UWORD plane_row_bytes = h->width / 8;
+    ULONG plane_size = plane_row_bytes * h->height;
+    *row_bytes = (h->flags & TSFLAGS_NON_INTERLEAVED) ? plane_row_bytes :
+        plane_row_bytes * h->bmdepth;
+    return sheet->imgdata + plane_size * h->bmdepth + row * *row_bytes;
+}
+
+/*
+  Tests 2 bobs for overlapping mask pixels.
+
+  The mask of bob a is read through channel A and shifted to the word
+  alignment of bob b's mask, which is read unshifted through channel C.
+  The first word mask cuts off a's pixels left of the overlap before the
+  shift. If the blit needs to shift, it is one word wider and the last word
+  mask clears the extra word, so nothing is shifted into the next line.
+  The pixels right of the overlap are not masked in this case, but within a
+  word they are in the empty padding of one of the two tiles.
+
+  Returns TRUE if the bobs collide
+*/
+BOOL ratr0_bob_collision(struct Ratr0Bob *a, struct Ratr0Bob *b)
+{
+    struct Ratr0TileSheetHeader *ha = &a->sheet->header, *hb = &b->sheet->header;
+    int width_a = ha->tile_width - SHIFT_PADDING, width_b = hb->tile_width - SHIFT_PADDING;
+
+    // overlap of the boxes, x1 and y1 are exclusive
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = a->x + width_a < b->x + width_b ? a->x + width_a : b->x + width_b;
+    int y1 = a->y + ha->tile_height < b->y + hb->tile_height ?
+        a->y + ha->tile_height : b->y + hb->tile_height;
+    if (x0 >= x1 || y0 >= y1) return FALSE;
+
+    // overlap in mask plane pixels of the two sheets
+    int ax0 = a->tilex * ha->tile_width + x0 - a->x;
+    int ax1 = ax0 + (x1 - x0);
+    int bx0 = b->tilex * hb->tile_width + x0 - b->x;
+    int offset = bx0 - ax0;  // a's pixels move by this many pixels
+    int shift = offset & 0x0f;
+    int first_word = ax0 >> 4;
+    int width = ((ax1 - 1) >> 4) - first_word + 1;
+
+    UWORD afwm = 0xffff >> (ax0 & 0x0f);
+    UWORD alwm = 0xffff << (15 - ((ax1 - 1) & 0x0f));
+    if (shift) {
+        width++;
+        alwm = 0;
+    }
+    UWORD amod, cmod;
+    UBYTE *amask = mask_row(a->sheet, a->tiley * ha->tile_height + y0 - a->y, &amod) +
+        first_word * 2;
+    // floor division, offset can be negative
+    UBYTE *cmask = mask_row(b->sheet, b->tiley * hb->tile_height + y0 - b->y, &cmod) +
+        (first_word + (offset >> 4)) * 2;
+    UWORD bltsize = ((y1 - y0) << 6) | (width & 0x3f);
+
+    // channels A and C, LF => D = AC, D is not written
+    UWORD bltcon0 = 0x0aa0 | (shift << 12);
+    WaitBlit();
+    custom.bltcon0 = bltcon0;
+    custom.bltcon1 = 0;
+    custom.bltafwm = afwm;
+    custom.bltalwm = alwm;
+    custom.bltamod = amod - width * 2;
+    custom.bltcmod = cmod - width * 2;
+    custom.bltapt = amask;
+    custom.bltcpt = cmask;
+    custom.bltsize = bltsize;
+    ratr0_account_blit(bltcon0, 0, bltsize);
+    WaitBlit();
+    return !(custom.dmaconr & DMACONR_BZERO);
+}
@@ -0,0 +1,147 @@
+#pragma once
+#ifndef __BOBS_H__
+#define __BOBS_H__
+
+#include "tilesheet.h"
+
+/*
+ * The BOB sheets are set up in a way that of the tile width, the first
+ * 16 pixels are empty and provided as padding for shifting.
+ */
+#define SHIFT_PADDING (16)
+
+// Register values and pointers for drawing a single bob. Pointers always
+// point to the first word of the first line, even for descending blits
+struct Ratr0BobBlit {
+    UBYTE *src, *mask, *dst;
+    UWORD bltcon0, bltcon1;
+    UWORD bltafwm, bltalwm;
+    UWORD srcmod, dstmod;
+    UWORD width_words;  // blit width in words
+    UWORD height;       // number of lines in a single blit
+    UWORD num_planes;   // number of blits: 1 if interleaved, bmdepth otherwise
+    ULONG src_plane_size, dst_plane_size;
+
+    // destination position and row layout, used for clipping
+    WORD dst_word0;       // first destination word within a row, can be negative
+    WORD dsty;            // first destination row, can be negative
+    UWORD rows;           // number of bob rows
+    UWORD lines_per_row;  // bmdepth if interleaved, 1 otherwise
+    UWORD src_row_bytes;  // bytes per bob row in source and mask
+    UWORD dst_row_bytes;  // bytes per bob row in the destination
+};
+
+// clip rectangle, x1 and y1 are exclusive
+struct Ratr0ClipRect {
+    WORD x0, y0, x1, y1;
+};
+
+extern void ratr0_compute_bob_blit(struct Ratr0BobBlit *blit,
+                                   struct Ratr0TileSheet *bobs,
+                                   struct Ratr0TileSheet *background,
+                                   int tilex, int tiley,
+                                   int dstx, int dsty);
+extern int ratr0_clip_bob_blit(struct Ratr0BobBlit *blit, struct Ratr0ClipRect *clip,
+                               struct Ratr0BobBlit *rest);
+extern void ratr0_blit_object(struct Ratr0TileSheet *bobs,
+                              struct Ratr0TileSheet *background,
+                              int tilex, int tiley,
+                              int dstx, int dsty);
+extern void ratr0_blit_object_clipped(struct Ratr0TileSheet *bobs,
+                                      struct Ratr0TileSheet *background,
+                                      int tilex, int tiley,
+                                      int dstx, int dsty,
+                                      struct Ratr0ClipRect *clip);
+
+/*
+ * Pre-shifted bob cache: at load time, 16 horizontally shifted copies
+ * of every tile and its mask are generated in chip memory. Drawing a bob
+ * is then a fixed width blit without shifting or masking of first and last
+ * words. The layout of the cache follows the bob sheet: if the sheet is
+ * interleaved, the mask rows are replicated for every plane. The
+ * background needs to have the same layout.
+ */
+struct Ratr0PreshiftCache {
+    struct Ratr0TileSheet *sheet;
+    UBYTE *data;        // chip memory
+    ULONG data_size;
+    UWORD width_words;  // blit width in words
+    UWORD height;       // number of lines in a single blit
+    UWORD num_planes;   // number of blits: 1 if interleaved, bmdepth otherwise
+    ULONG plane_size;   // size of a plane in a shifted copy, 0 if interleaved
+    ULONG mask_offset;  // offset of the mask within a shifted copy
+    ULONG shift_size;   // size of a shifted copy, including mask
+    ULONG tile_size;    // size of all 16 shifted copies of a tile
+};
+
+// maximum bob width in words, including the shift word
+#define MAX_PRESHIFT_WORDS (8)
+
+extern BOOL ratr0_preshift_tilesheet(struct Ratr0PreshiftCache *cache,
+                                     struct Ratr0TileSheet *bobs);
+extern void ratr0_free_preshift_cache(struct Ratr0PreshiftCache *cache);
+extern void ratr0_compute_preshifted_blit(struct Ratr0BobBlit *blit,
+                                          struct Ratr0PreshiftCache *cache,
+                                          struct Ratr0TileSheet *background,
+                                          int tilex, int tiley,
+                                          int dstx, int dsty);
+extern void ratr0_blit_preshifted_object(struct Ratr0PreshiftCache *cache,
+                                         struct Ratr0TileSheet *background,
+                                         int tilex, int tiley,
+                                         int dstx, int dsty);
+
+/*
+ * Bob manager: moving bobs on a double buffered display.
+ * Before a bob is drawn, the background below it is saved into a chip
+ * memory save buffer. The next time the same display buffer is drawn to,
+ * the saved backgrounds are restored in reverse order first.
+ */
+struct Ratr0Bob {
+    struct Ratr0TileSheet *sheet;
+    struct Ratr0PreshiftCache *cache;  // optional, if not NULL, draw pre-shifted
+    int tilex, tiley;
+    int x, y;
+    BOOL visible;
+};
+
+// saved background area of a bob
+struct Ratr0BobSave {
+    UBYTE *buffer;  // chip memory
+    UBYTE *dst;     // where the saved data came from, NULL if nothing saved
+    UWORD dstmod, bltsize;
+    UWORD num_planes;
+    ULONG dst_plane_size, save_plane_size;
+};
+
+#define MAX_BOBS (48)
+#define NUM_BOB_BUFFERS (2)
+
+struct Ratr0BobManager {
+    struct Ratr0TileSheet *buffers[NUM_BOB_BUFFERS];
+    int back;  // index of the buffer we draw into
+    int num_bobs;
+    struct Ratr0Bob *bobs;
+    struct Ratr0ClipRect clip;  // defaults to the buffer size
+    struct Ratr0BobSave saves[NUM_BOB_BUFFERS][MAX_BOBS];
+    UBYTE *save_mem;
+    ULONG save_mem_size;
+};
+
+extern BOOL ratr0_init_bob_manager(struct Ratr0BobManager *mgr,
+                                   struct Ratr0TileSheet *front,
+                                   struct Ratr0TileSheet *back,
+                                   struct Ratr0Bob *bobs, int num_bobs);
+extern void ratr0_free_bob_manager(struct Ratr0BobManager *mgr);
+extern void ratr0_render_bobs(struct Ratr0BobManager *mgr);
+extern struct Ratr0TileSheet *ratr0_swap_bob_buffers(struct Ratr0BobManager *mgr);
+
+/*
+ * Pixel exact collision between 2 bobs: the blitter ANDs the mask planes
+ * of the bobs in the overlap of their boxes with channel D disabled, so
+ * nothing is written. The result is the blitter zero flag in DMACONR.
+ * This relies on the SHIFT_PADDING pixels of a tile being empty in the
+ * mask. The caller needs to own the blitter.
+ */
+extern BOOL ratr0_bob_collision(struct Ratr0Bob *a, struct Ratr0Bob *b);
+
+#endif /* __BOBS_H__ */
@@ -1,6 +1,8 @@
 /**
  * example_01.c - blitter object / cookie cut example
  * Demonstrate blitting masked object
+ * When compiled with -DINTERLEAVED, the images are converted into the
+ * interleaved format and a bob is drawn with a single blit for all planes
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +19,7 @@
 #include <ahpc_registers.h>
 
 #include "tilesheet.h"
+#include "bobs.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -186,133 +189,6 @@ static void cleanup(void)
     reset_display();
 }
 
-#define SHIFT_PADDING (16)
-/*
-  Blit function where we can blit an aligned source to anywhere in the
-  destination. This function assumes that the BOB sheet is set up in
-  a way that of the tile width, the first 16 pixels are empty and provided
-  as padding for shifting.
-
-  Parameters:
-  - bobs: a tile sheet that is assumed to include an additional mask plane
-  - background is the background image to blit into
-  - tilex, tiley: rather than pixel positions, this is the tile position
-    within the bobs and masks sheets
-  - dstx, dsty: The target coordinates to blit the object to within the
-    background image
-
-  Note:
-  we won't handle clipping at the boundaries to keep things simple
-*/
-static void blit_object(struct Ratr0TileSheet *bobs,
-			struct Ratr0TileSheet *background,
-			int tilex, int tiley,
-			int dstx, int dsty)
-{
-    // actual object width (without the padding)
-    int tile_width_pixels = bobs->header.tile_width - SHIFT_PADDING;
-
-    // this tile's x-position relative to the word containing it
-    int tile_x0 = bobs->header.tile_width * tilex & 0x0f;
-
-    // 1. determine how wide the blit actually is
-    int blit_width = tile_width_pixels / 16;
-
-    // width not a multiple of 16 ? -> add 1 to the width
-    if (tile_width_pixels & 0x0f) blit_width++;
-
-    int blit_width0_pixels = blit_width * 16;  // blit width in pixels
-
-    // Final source blit width: does the tile extend into an additional word ?
-    int src_blit_width = blit_width;
-    if (tile_x0 > blit_width0_pixels - tile_width_pixels) src_blit_width++;
-
-    // 2. Determine the amount of shift and the first word in the
-    // destination
-    int dst_x0 = dstx & 0x0f;  // destination x relative to the containing word
-    int dst_shift = dst_x0 - tile_x0;  // shift amount
-    int dst_blit_width = blit_width;
-    int dst_offset = 0;
-
-    // negative shift => shift is to the left, so we extend the shift to the
-    // left and right-shift in the previous word so we always right-shift
-    if (dst_shift < 0) {
-        dst_shift = 16 + dst_shift;
-        dst_blit_width++;
-        dst_offset = -2;
-    }
-
-    // make the blit wider if it needs more space
-    if (dst_x0 > blit_width0_pixels - tile_width_pixels) {
-        dst_blit_width++;
-    }
-
-    UWORD alwm = 0xffff;
-    int final_blit_width = src_blit_width;
-
-    // due to relative positioning and shifts, the destination blit width
-    // can be larger than the source blit, so we use the larger of the 2
-    // and mask out last word of the source
-    if (dst_blit_width > src_blit_width) {
-        final_blit_width = dst_blit_width;
-        alwm = 0;
-    }
-
-    WaitBlit();
-
-    custom.bltafwm = 0xffff;
-    custom.bltalwm = alwm;
-
-    // cookie cut enable channels B, C and D, LF => D = AB + ~AC => 0xca
-    // A = Mask sheet
-    // B = Tile sheet
-    // C = Background
-    // D = Background
-    custom.bltcon0 = 0x0fca | (dst_shift << 12);
-    custom.bltcon1 = dst_shift << 12;  // shift in B
-
-    // modulos are in bytes
-    UWORD srcmod = bobs->header.width / 8 - (final_blit_width * 2);
-    UWORD dstmod = background->header.width / 8 - (final_blit_width * 2);
-    custom.bltamod = srcmod;
-    custom.bltbmod = srcmod;
-    custom.bltcmod = dstmod;
-    custom.bltdmod = dstmod;
-
-    // The blit size is the size of a plane of the tile size (1 word * 16)
-    UWORD bltsize = ((bobs->header.tile_height) << 6) |
-        (final_blit_width & 0x3f);
-
-    // map the tile position to physical coordinates in the tile sheet
-    int srcx = tilex * bobs->header.tile_width;
-    int srcy = tiley * bobs->header.tile_height;
-
-    int bobs_plane_size = bobs->header.width / 8 * bobs->header.height;
-    int bg_plane_size = background->header.width / 8 * background->header.height;
-
-    UBYTE *src = bobs->imgdata + srcy * bobs->header.width / 8 + srcx / 8;
-    // The mask data is the plane after the source image planes
-    UBYTE *mask = bobs->imgdata + bobs_plane_size * bobs->header.bmdepth +
-        srcy * bobs->header.width / 8 + srcx / 8;
-    UBYTE *dst = background->imgdata + dsty * background->header.width / 8 +
-        dstx / 8 + dst_offset;
-
-    for (int i = 0; i < bobs->header.bmdepth; i++) {
-
-        custom.bltapt = mask;
-        custom.bltbpt = src;
-        custom.bltcpt = dst;
-        custom.bltdpt = dst;
-        custom.bltsize = bltsize;
-
-        // Increase the pointers to the next plane
-        src += bobs_plane_size;
-        dst += bg_plane_size;
-
-        WaitBlit();
-    }
-}
-
 int main(int argc, char **argv)
 {
     if (!setup_input_handler()) {
@@ -332,6 +208,13 @@ int main(int argc, char **argv)
         cleanup();
         return 1;
     }
+#ifdef INTERLEAVED
+    if (!ratr0_interleave_tilesheet(&background) || !ratr0_interleave_tilesheet(&bobs)) {
+        puts("Could not convert images to interleaved format");
+        cleanup();
+        return 1;
+    }
+#endif
 
     if (is_pal) {
         coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
@@ -344,18 +227,29 @@ int main(int argc, char **argv)
     int img_row_bytes = background.header.width / 8;
     UBYTE num_colors = 1 << background.header.bmdepth;
 
+#ifdef INTERLEAVED
+    // adjust the bitplane modulos for the interleaved background
+    int bplmod = (background.header.bmdepth - 1) * img_row_bytes;
+    coplist[COPLIST_IDX_BPL1MOD_VALUE] = bplmod;
+    coplist[COPLIST_IDX_BPL2MOD_VALUE] = bplmod;
+#endif
+
     // 1. copy the background palette to the copper list
     for (int i = 0; i < num_colors; i++) {
         coplist[COPLIST_IDX_COLOR00_VALUE + (i << 1)] = background.palette[i];
     }
 
     // 2. prepare background bitplanes and point the copper list entries
-    // to the bitplanes. The data is non-interleaved.
+    // to the bitplanes
     int coplist_idx = COPLIST_IDX_BPL1PTH_VALUE;
     int plane_size = background.header.height * img_row_bytes;
     ULONG addr;
     for (int i = 0; i < background.header.bmdepth; i++) {
+#ifdef INTERLEAVED
+        addr = (ULONG) &(background.imgdata[i * img_row_bytes]);
+#else
         addr = (ULONG) &(background.imgdata[i * plane_size]);
+#endif
         coplist[coplist_idx] = (addr >> 16) & 0xffff;
         coplist[coplist_idx + 2] = addr & 0xffff;
         coplist_idx += 4; // next bitplane
@@ -365,10 +259,10 @@ int main(int argc, char **argv)
     custom.dmacon  = 0x0020;
 
     OwnBlitter();
-    blit_object(&bobs, &background, 1, 0, 40, 58);
-    blit_object(&bobs, &background, 0, 0, 18, 5);
-    blit_object(&bobs, &background, 2, 0, 83, 77);
-    blit_object(&bobs, &background, 3, 0, 163, 155);
+    ratr0_blit_object(&bobs, &background, 1, 0, 40, 58);
+    ratr0_blit_object(&bobs, &background, 0, 0, 18, 5);
+    ratr0_blit_object(&bobs, &background, 2, 0, 83, 77);
+    ratr0_blit_object(&bobs, &background, 3, 0, 163, 155);
     DisownBlitter();
 
     // initialize and activate the copper list
@@ -0,0 +1,342 @@
+/**
+ * example_02.c - moving bobs example
+ * Demonstrate moving blitter objects on a double buffered display, the
+ * background below the bobs is saved and restored every frame
+ * If there is enough chip memory, the bobs are drawn from a pre-shifted cache
+ * Bobs are clipped at the display borders
+ * The blitter DMA cycles used per frame are reported on exit
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hardware/custom.h>
+#include <clib/exec_protos.h>
+#include <clib/intuition_protos.h>
+#include <clib/graphics_protos.h>
+
+#include <clib/alib_protos.h>
+#include <devices/input.h>
+
+#include <graphics/gfxbase.h>
+#include <ahpc_registers.h>
+
+#include "tilesheet.h"
+#include "bobs.h"
+#include "blit_cost.h"
+
+extern struct GfxBase *GfxBase;
+extern struct Custom custom;
+
+// 20 instead of 127 because of input.device priority
+#define TASK_PRIORITY           (20)
+#define PRA_FIR0_BIT            (1 << 6)
+
+#define DIWSTRT_VALUE      0x2c81
+#define DIWSTOP_VALUE_PAL  0x2cc1
+#define DIWSTOP_VALUE_NTSC 0xf4c1
+
+// Data fetch
+#define DDFSTRT_VALUE      0x0038
+#define DDFSTOP_VALUE      0x00d0
+
+// Display dimensions and data size
+#define DISPLAY_WIDTH    (320)
+#define DISPLAY_HEIGHT   (256)
+#define DISPLAY_ROW_BYTES (DISPLAY_WIDTH / 8)
+
+#define IMG_FILENAME_PAL "grid_320x256x4.ts"
+#define IMG_FILENAME_NTSC "grid_320x200x4.ts"
+
+// playfield control
+// single playfield, 4 bitplanes (16 colors)
+#define BPLCON0_VALUE (0x4200)
+// We have single playfield, so priority is determined in bits
+// 5-3 and we need to set the playfield 2 priority bit (bit 6)
+#define BPLCON2_VALUE (0x0048)
+
+// copper instruction macros
+#define COP_MOVE(addr, data) addr, data
+#define COP_WAIT_END  0xffff, 0xfffe
+
+// copper list indexes
+#define COPLIST_IDX_DIWSTOP_VALUE (9)
+#define COPLIST_IDX_BPL1MOD_VALUE (COPLIST_IDX_DIWSTOP_VALUE + 6)
+#define COPLIST_IDX_BPL2MOD_VALUE (COPLIST_IDX_BPL1MOD_VALUE + 2)
+#define COPLIST_IDX_COLOR00_VALUE (COPLIST_IDX_BPL2MOD_VALUE + 2)
+#define COPLIST_IDX_BPL1PTH_VALUE (COPLIST_IDX_COLOR00_VALUE + 32)
+
+static UWORD __chip coplist[] = {
+    COP_MOVE(FMODE,   0), // set fetch mode = 0
+
+    COP_MOVE(DDFSTRT, DDFSTRT_VALUE),
+    COP_MOVE(DDFSTOP, DDFSTOP_VALUE),
+    COP_MOVE(DIWSTRT, DIWSTRT_VALUE),
+    COP_MOVE(DIWSTOP, DIWSTOP_VALUE_PAL),
+    COP_MOVE(BPLCON0, BPLCON0_VALUE),
+    COP_MOVE(BPLCON2, BPLCON2_VALUE),
+    COP_MOVE(BPL1MOD, 0),
+    COP_MOVE(BPL2MOD, 0),
+
+    // set up the display colors
+    COP_MOVE(COLOR00, 0x000), COP_MOVE(COLOR01, 0x000),
+    COP_MOVE(COLOR02, 0x000), COP_MOVE(COLOR03, 0x000),
+    COP_MOVE(COLOR04, 0x000), COP_MOVE(COLOR05, 0x000),
+    COP_MOVE(COLOR06, 0x000), COP_MOVE(COLOR07, 0x000),
+    COP_MOVE(COLOR08, 0x000), COP_MOVE(COLOR09, 0x000),
+    COP_MOVE(COLOR10, 0x000), COP_MOVE(COLOR11, 0x000),
+    COP_MOVE(COLOR12, 0x000), COP_MOVE(COLOR13, 0x000),
+    COP_MOVE(COLOR14, 0x000), COP_MOVE(COLOR15, 0x000),
+
+    COP_MOVE(BPL1PTH, 0), COP_MOVE(BPL1PTL, 0),
+    COP_MOVE(BPL2PTH, 0), COP_MOVE(BPL2PTL, 0),
+    COP_MOVE(BPL3PTH, 0), COP_MOVE(BPL3PTL, 0),
+    COP_MOVE(BPL4PTH, 0), COP_MOVE(BPL4PTL, 0),
+
+    COP_WAIT_END,
+    COP_WAIT_END
+};
+
+static volatile ULONG *custom_vposr = (volatile ULONG *) 0xdff004;
+
+// Wait for this position for vertical blank
+// translated from http://eab.abime.net/showthread.php?t=51928
+static vb_waitpos;
+
+static void wait_vblank()
+{
+    while (((*custom_vposr) & 0x1ff00) != (vb_waitpos<<8)) ;
+}
+
+static BOOL init_display(void)
+{
+    LoadView(NULL);  // clear display, reset hardware registers
+    WaitTOF();       // 2 WaitTOFs to wait for 1. long frame and
+    WaitTOF();       // 2. short frame copper lists to finish (if interlaced)
+    return (((struct GfxBase *) GfxBase)->DisplayFlags & PAL) == PAL;
+}
+
+static void reset_display(void)
+{
+    LoadView(((struct GfxBase *) GfxBase)->ActiView);
+    WaitTOF();
+    WaitTOF();
+    custom.cop1lc = (ULONG) ((struct GfxBase *) GfxBase)->copinit;
+    RethinkDisplay();
+}
+
+static struct Ratr0TileSheet background, background2, bobs;
+static struct Ratr0BobManager bob_manager;
+static struct Ratr0PreshiftCache bob_cache;
+
+// To handle input
+static struct MsgPort *input_mp;
+static struct IOStdReq *input_io;
+static struct Interrupt handler_info;
+static int should_exit;
+
+static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
+                                           __reg("a1") APTR handler_data)
+{
+    struct InputEvent *result = event, *prev = NULL;
+
+    Forbid();
+    // Intercept all raw mouse events before they reach Intuition, ignore
+    // everything else
+    if (result->ie_Class == IECLASS_RAWMOUSE) {
+        if (result->ie_Code == IECODE_LBUTTON) {
+            should_exit = 1;
+        }
+        return NULL;
+    }
+    Permit();
+    return result;
+}
+
+static void cleanup_input_handler(void)
+{
+    if (input_io) {
+        // remove our input handler from the chain
+        input_io->io_Command = IND_REMHANDLER;
+        input_io->io_Data = (APTR) &handler_info;
+        DoIO((struct IORequest *) input_io);
+
+        if (!(CheckIO((struct IORequest *) input_io))) AbortIO((struct IORequest *) input_io);
+        WaitIO((struct IORequest *) input_io);
+        CloseDevice((struct IORequest *) input_io);
+        DeleteExtIO((struct IORequest *) input_io);
+    }
+    if (input_mp) DeletePort(input_mp);
+}
+
+static BYTE error;
+
+static int setup_input_handler(void)
+{
+    input_mp = CreatePort(0, 0);
+    input_io = (struct IOStdReq *) CreateExtIO(input_mp, sizeof(struct IOStdReq));
+    error = OpenDevice("input.device", 0L, (struct IORequest *) input_io, 0);
+
+    handler_info.is_Code = (void (*)(void)) my_input_handler;
+    handler_info.is_Data = NULL;
+    handler_info.is_Node.ln_Pri = 100;
+    handler_info.is_Node.ln_Name = "bobs02";
+    input_io->io_Command = IND_ADDHANDLER;
+    input_io->io_Data = (APTR) &handler_info;
+    DoIO((struct IORequest *) input_io);
+    return 1;
+}
+
+static void cleanup(void)
+{
+    cleanup_input_handler();
+    ratr0_free_bob_manager(&bob_manager);
+    ratr0_free_preshift_cache(&bob_cache);
+    ratr0_free_tilesheet_data(&bobs);
+    ratr0_free_tilesheet_data(&background2);
+    ratr0_free_tilesheet_data(&background);
+    reset_display();
+}
+
+// point the copper list's bitplane pointers to an interleaved buffer
+static void set_display_buffer(struct Ratr0TileSheet *buffer)
+{
+    int img_row_bytes = buffer->header.width / 8;
+    int coplist_idx = COPLIST_IDX_BPL1PTH_VALUE;
+    ULONG addr;
+    for (int i = 0; i < buffer->header.bmdepth; i++) {
+        addr = (ULONG) &(buffer->imgdata[i * img_row_bytes]);
+        coplist[coplist_idx] = (addr >> 16) & 0xffff;
+        coplist[coplist_idx + 2] = addr & 0xffff;
+        coplist_idx += 4; // next bitplane
+    }
+}
+
+#define NUM_BOBS (32)
+static struct Ratr0Bob bob_objects[NUM_BOBS];
+static int bob_dx[NUM_BOBS], bob_dy[NUM_BOBS];
+static struct Ratr0BlitBudget blit_budget;
+static ULONG num_collisions;
+
+// bobs are clipped, so they can move partially outside of the display
+#define MIN_BOB_X (16)
+#define BOB_OVERLAP (16)
+
+int main(int argc, char **argv)
+{
+    if (!setup_input_handler()) {
+        puts("Could not initialize input handler");
+        return 1;
+    }
+    SetTaskPri(FindTask(NULL), TASK_PRIORITY);
+    BOOL is_pal = init_display();
+    const char *bgfile = is_pal ? IMG_FILENAME_PAL : IMG_FILENAME_NTSC;
+    if (!ratr0_read_tilesheet(bgfile, &background)) {
+        puts("Could not read background image");
+        cleanup();
+        return 1;
+    }
+    if (!ratr0_read_tilesheet("rodland_bobs.ts", &bobs)) {
+        puts("Could not read bob sheet");
+        cleanup();
+        return 1;
+    }
+    // interleaved images allow us to draw a bob with a single blit
+    if (!ratr0_interleave_tilesheet(&background) || !ratr0_interleave_tilesheet(&bobs)) {
+        puts("Could not convert images to interleaved format");
+        cleanup();
+        return 1;
+    }
+    if (!ratr0_clone_tilesheet(&background2, &background)) {
+        puts("Could not allocate back buffer");
+        cleanup();
+        return 1;
+    }
+
+    // trade chip memory for speed if possible, otherwise we shift at blit time
+    BOOL use_cache = ratr0_preshift_tilesheet(&bob_cache, &bobs);
+
+    int max_x = background.header.width - (bobs.header.tile_width - SHIFT_PADDING) - 16;
+    int max_y = background.header.height - bobs.header.tile_height;
+    for (int i = 0; i < NUM_BOBS; i++) {
+        bob_objects[i].sheet = &bobs;
+        bob_objects[i].cache = use_cache ? &bob_cache : NULL;
+        bob_objects[i].tilex = i % bobs.header.num_tiles_h;
+        bob_objects[i].tiley = 0;
+        bob_objects[i].x = MIN_BOB_X + (i * 37) % (max_x - MIN_BOB_X);
+        bob_objects[i].y = (i * 53) % max_y;
+        bob_objects[i].visible = TRUE;
+        bob_dx[i] = (i & 1) ? 1 : -1;
+        bob_dy[i] = (i & 2) ? 1 : -1;
+    }
+    if (!ratr0_init_bob_manager(&bob_manager, &background, &background2,
+                                bob_objects, NUM_BOBS)) {
+        puts("Could not allocate bob save buffers");
+        cleanup();
+        return 1;
+    }
+
+    if (is_pal) {
+        coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
+        vb_waitpos = 303;
+    } else {
+        coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_NTSC;
+        vb_waitpos = 262;
+    }
+
+    int img_row_bytes = background.header.width / 8;
+    UBYTE num_colors = 1 << background.header.bmdepth;
+
+    // 1. adjust the bitplane modulos for the interleaved background
+    int bplmod = (background.header.bmdepth - 1) * img_row_bytes;
+    coplist[COPLIST_IDX_BPL1MOD_VALUE] = bplmod;
+    coplist[COPLIST_IDX_BPL2MOD_VALUE] = bplmod;
+
+    // 2. copy the background palette to the copper list
+    for (int i = 0; i < num_colors; i++) {
+        coplist[COPLIST_IDX_COLOR00_VALUE + (i << 1)] = background.palette[i];
+    }
+
+    // 3. display the front buffer
+    set_display_buffer(&background);
+
+    // no sprite DMA
+    custom.dmacon  = 0x0020;
+
+    // initialize and activate the copper list
+    custom.cop1lc = (ULONG) coplist;
+
+    ratr0_init_blit_budget(&blit_budget, is_pal, background.header.bmdepth,
+                           DISPLAY_WIDTH, is_pal ? DISPLAY_HEIGHT : 200);
+    ratr0_set_blit_budget(&blit_budget);
+
+    OwnBlitter();
+    // the event loop
+    while (!should_exit) {
+        ratr0_begin_blit_frame(&blit_budget);
+        for (int i = 0; i < NUM_BOBS; i++) {
+            struct Ratr0Bob *bob = &bob_objects[i];
+            bob->x += bob_dx[i];
+            bob->y += bob_dy[i];
+            if (bob->x <= -BOB_OVERLAP || bob->x >= max_x + BOB_OVERLAP) bob_dx[i] = -bob_dx[i];
+            if (bob->y <= -BOB_OVERLAP || bob->y >= max_y + BOB_OVERLAP) bob_dy[i] = -bob_dy[i];
+        }
+        // pixel exact collisions, pairs with disjoint boxes don't blit
+        for (int i = 0; i < NUM_BOBS; i++) {
+            for (int j = i + 1; j < NUM_BOBS; j++) {
+                if (ratr0_bob_collision(&bob_objects[i], &bob_objects[j])) num_collisions++;
+            }
+        }
+        // draw into the back buffer and show it at the next vertical blank
+        ratr0_render_bobs(&bob_manager);
+        ratr0_end_blit_frame(&blit_budget);
+        wait_vblank();
+        set_display_buffer(ratr0_swap_bob_buffers(&bob_manager));
+    }
+    WaitBlit();
+    DisownBlitter();
+
+    cleanup();
+    ratr0_print_blit_budget(&blit_budget);
+    printf("bob collisions: %lu\n", num_collisions);
+    return 0;
+}
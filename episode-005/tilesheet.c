@@ -1,32 +1,84 @@
 #include <stdio.h>
+#include <string.h>
+#include <dos/dos.h>
 #include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
 #include "tilesheet.h"
 
+/*
+ * Reads exactly size bytes with a single unbuffered dos.library Read().
+ * A short read means that the file is truncated.
+ */
+static BOOL read_fully(BPTR fh, APTR buffer, LONG size)
+{
+    return size == 0 || Read(fh, buffer, size) == size;
+}
+
+/**
+ * Computes the checksum that is stored in the asset file headers: the 16 bit
+ * sum of the data words. A checksum of 0 in a header means "not set".
+ *
+ * @param data pointer to the data
+ * @param size size of the data in bytes, a trailing odd byte is the high byte
+ * @return checksum
+ */
+UWORD ratr0_checksum(UBYTE *data, ULONG size)
+{
+    UWORD sum = 0;
+    UWORD *words = (UWORD *) data;
+    for (ULONG i = 0; i < size / 2; i++) sum += words[i];
+    if (size & 1) sum += data[size - 1] << 8;
+    return sum;
+}
+
 /**
  * Reads the image information from specified RATR0 tile sheet file.
+ * The header is read and validated first, then the palette and the image
+ * data is read directly into chip memory.
  *
  * @param filename path to the tile sheet file
  * @param sheet pointer to a Ratr0TileSheet structure
+ * @return 1 on success, 0 on error
  */
 ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
 {
-    int elems_read;
-    ULONG retval = 0;
-
-    FILE *fp = fopen(filename, "rb");
-
-    if (fp) {
-        int num_img_bytes;
-        elems_read = fread(&sheet->header, sizeof(struct Ratr0TileSheetHeader), 1, fp);
-        elems_read = fread(&sheet->palette, sizeof(UWORD), sheet->header.palette_size, fp);
-        sheet->imgdata = AllocMem(sheet->header.imgdata_size, MEMF_CHIP|MEMF_CLEAR);
-        elems_read = fread(sheet->imgdata, sizeof(unsigned char), sheet->header.imgdata_size, fp);
-        fclose(fp);
-        return 1;
-    } else {
+    struct Ratr0TileSheetHeader *header = &sheet->header;
+    const char *error = NULL;
+
+    sheet->imgdata = NULL;
+    BPTR fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!fh) {
         printf("ratr0_read_tilesheet() error: file '%s' not found\n", filename);
         return 0;
     }
+    if (!read_fully(fh, header, sizeof(struct Ratr0TileSheetHeader))) {
+        error = "truncated header";
+    } else if (memcmp(header->id, TILESHEET_ID, FILE_ID_LEN)) {
+        error = "not a tile sheet";
+    } else if (header->version != TILESHEET_VERSION) {
+        error = "unsupported version";
+    } else if (header->palette_size > MAX_PALETTE_SIZE) {
+        error = "palette too large";
+    } else if (header->imgdata_size < (ULONG) header->width / 8 * header->height * header->bmdepth) {
+        error = "image data too small";
+    } else if (!read_fully(fh, sheet->palette, header->palette_size * sizeof(UWORD))) {
+        error = "truncated palette";
+    } else if (!(sheet->imgdata = AllocMem(header->imgdata_size, MEMF_CHIP))) {
+        error = "not enough chip memory";
+    } else if (!read_fully(fh, sheet->imgdata, header->imgdata_size)) {
+        error = "truncated image data";
+    } else if (header->checksum &&
+               ratr0_checksum(sheet->imgdata, header->imgdata_size) != header->checksum) {
+        error = "checksum mismatch";
+    }
+    Close(fh);
+
+    if (error) {
+        printf("ratr0_read_tilesheet() error: '%s': %s\n", filename, error);
+        ratr0_free_tilesheet_data(sheet);
+        return 0;
+    }
+    return 1;
 }
 
 /**
@@ -35,5 +87,68 @@ ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
 void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet)
 {
     if (sheet && sheet->imgdata) FreeMem(sheet->imgdata, sheet->header.imgdata_size);
+    if (sheet) sheet->imgdata = NULL;
+}
+
+
+/**
+ * Converts the image data of a non-interleaved tile sheet into the
+ * interleaved format. If the sheet has a mask plane, the mask rows are
+ * replicated for every bitplane, so a mask can be applied to all planes of
+ * an interleaved image in a single blit. In that case the mask data is as
+ * large as the image data and directly follows it.
+ *
+ * @param sheet pointer to a Ratr0TileSheet structure
+ * @return TRUE if successful, FALSE if no memory could be allocated
+ */
+BOOL ratr0_interleave_tilesheet(struct Ratr0TileSheet *sheet)
+{
+    if (!(sheet->header.flags & TSFLAGS_NON_INTERLEAVED)) return TRUE;
+
+    int row_bytes = sheet->header.width / 8;
+    int depth = sheet->header.bmdepth;
+    int plane_size = row_bytes * sheet->header.height;
+    ULONG img_size = plane_size * depth;
+    ULONG data_size = (sheet->header.flags & TSFLAGS_HAS_MASK) ? img_size * 2 : img_size;
+    UBYTE *data = AllocMem(data_size, MEMF_CHIP);
+    if (!data) return FALSE;
+
+    UBYTE *dst = data;
+    for (int y = 0; y < sheet->header.height; y++) {
+        for (int i = 0; i < depth; i++) {
+            CopyMem(sheet->imgdata + i * plane_size + y * row_bytes, dst, row_bytes);
+            dst += row_bytes;
+        }
+    }
+    if (sheet->header.flags & TSFLAGS_HAS_MASK) {
+        UBYTE *mask = sheet->imgdata + img_size;
+        for (int y = 0; y < sheet->header.height; y++) {
+            for (int i = 0; i < depth; i++) {
+                CopyMem(mask + y * row_bytes, dst, row_bytes);
+                dst += row_bytes;
+            }
+        }
+    }
+    FreeMem(sheet->imgdata, sheet->header.imgdata_size);
+    sheet->imgdata = data;
+    sheet->header.imgdata_size = data_size;
+    sheet->header.flags &= ~TSFLAGS_NON_INTERLEAVED;
+    return TRUE;
 }
 
+/**
+ * Creates a copy of a tile sheet with its own image data in chip memory,
+ * e.g. to use an image as a second display buffer.
+ *
+ * @param dst the new tile sheet, free with ratr0_free_tilesheet_data()
+ * @param src the tile sheet to copy
+ * @return TRUE if successful, FALSE if no memory could be allocated
+ */
+BOOL ratr0_clone_tilesheet(struct Ratr0TileSheet *dst, struct Ratr0TileSheet *src)
+{
+    *dst = *src;
+    dst->imgdata = AllocMem(src->header.imgdata_size, MEMF_CHIP);
+    if (!dst->imgdata) return FALSE;
+    CopyMem(src->imgdata, dst->imgdata, src->header.imgdata_size);
+    return TRUE;
+}
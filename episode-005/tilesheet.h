@@ -4,6 +4,8 @@
 
 // information about a tile sheet
 #define FILE_ID_LEN (8)
+#define TILESHEET_ID "RATR0TIL"
+#define TILESHEET_VERSION (2)
 
 // information about a tile sheet
 // File format version 2
@@ -22,6 +24,10 @@ struct Ratr0TileSheetHeader {
     UWORD checksum;
 };
 
+// header flags
+#define TSFLAGS_NON_INTERLEAVED (0x04)
+#define TSFLAGS_HAS_MASK        (0x08)
+
 #define MAX_PALETTE_SIZE (32)
 struct Ratr0TileSheet {
     struct Ratr0TileSheetHeader header;
@@ -29,7 +35,10 @@ struct Ratr0TileSheet {
     UBYTE *imgdata;
 };
 
+extern UWORD ratr0_checksum(UBYTE *data, ULONG size);
 extern ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet);
 extern void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet);
+extern BOOL ratr0_interleave_tilesheet(struct Ratr0TileSheet *sheet);
+extern BOOL ratr0_clone_tilesheet(struct Ratr0TileSheet *dst, struct Ratr0TileSheet *src);
 
 #endif /* __TILESHEET_H__ */
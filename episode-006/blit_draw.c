@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <hardware/custom.h>
+#include <clib/graphics_protos.h>
+
+#include "blit_draw.h"
+
+extern struct Custom custom;
+
+/**
+ *  Draw a line assuming left top corner is at 0, 0 of the destination bit plane.
+ */
+// some empty memory to point the first line pixel to
+static UWORD __chip scratchmem[12];
+void ratr0_draw_line(struct Ratr0TileSheet *background, struct DrawLineParams *p)
+{
+    UWORD dx = abs(p->x2 - p->x1), dy = abs(p->y2 - p->y1), dmax, dmin;
+    UWORD bytes_per_line = background->header.width / 8;
+
+    // Determine the octant and therefore the code bits
+    UBYTE code;
+    if (p->y1 >= p->y2) {
+        if (p->x1 <= p->x2) {
+            code = dx >= dy ? 6 : 1;
+        } else {
+            code = dx <= dy ? 3 : 7;
+        }
+    } else {
+        if (p->x1 >= p->x2) {
+            code = dx >= dy ? 5 : 2;
+        } else {
+            code = dx <= dy ? 0 : 4;
+        }
+    }
+
+    if (dx <= dy) {
+        dmin = dx;
+        dmax = dy;
+    } else {
+        dmin = dy;
+        dmax = dx;
+    }
+    WORD aptlval = 4 * dmin - 2 * dmax;
+    UWORD startx = (p->x1 & 0xf) << 12;  // x1 modulo 16
+    UWORD texture = ((p->x1 + p->pattern_offset) & 0xf) << 12;  // BSH in BLTCON1
+    UWORD sign = (aptlval < 0 ? 1 : 0) << 6;
+    UWORD bltcon1val = texture | sign | (code << 2) | (p->single << 1) | 0x01;
+
+    APTR start_address = background->imgdata +
+        p->plane * (background->header.width / 8 * background->header.height) +
+        p->y1 * bytes_per_line + p->x1 / 8;
+
+    WaitBlit();
+    custom.bltapt = (APTR) ((UWORD) aptlval);
+    custom.bltcpt = start_address;
+
+    // this is actually only used for the first pixel of the line
+    // if we point this to another memory area, the first pixel will
+    // not be plotted. Research this more and then see whether we should
+    // use that in the tutorial
+    custom.bltdpt = p->omit_first_pixel ? scratchmem : start_address;
+
+    custom.bltamod = 4 * (dmin - dmax);
+    custom.bltbmod = 4 * dmin;
+
+    custom.bltcmod = background->header.width / 8;  // destination width in bytes
+    custom.bltdmod = background->header.width / 8;
+    custom.bltcon0 = 0x0b00 | p->lf_byte | startx;
+    custom.bltcon1 = bltcon1val;
+
+    custom.bltadat = 0x8000;  // draw "pen" pixel
+    custom.bltbdat = p->line_pattern;
+    custom.bltafwm = 0xffff;
+    custom.bltalwm = 0xffff;
+
+    custom.bltsize = ((dmax + 1) << 6) + 2;
+}
+
+/*
+  Use area fill in the specified rectangular region. It does this
+  by copying the area to itself using D = A in descending mode,
+  where src A is the background image itself. Set the fill bits
+  to specify the fill operation
+
+  Note: fill comes after shift, mask and logical operations, so
+  we can't mask out the fill
+*/
+void ratr0_area_fill(struct Ratr0TileSheet *background,
+                     struct AreaFillParams *params)
+{
+    // determine the left and right borders, which are at the
+    // word boundaries to the left and right sides
+    int left = params->x1  - (params->x1 & 0x0f);
+    int right = params->x2 + 16 - (params->x2 & 0x0f);
+    int blit_width_pixels = right - left;
+    int blit_height = (params->y2 - params->y1) + 1;
+    int num_words = blit_width_pixels / 16;
+    UBYTE fill_mode = params->exclusive ? 16 : 8;
+
+    WaitBlit();
+    custom.bltafwm = 0xffff;
+    custom.bltalwm = 0xffff;
+
+    custom.bltcon0 = 0x09f0;       // enable channels A and D, LF => D = A
+    // descending mode + fill parameters
+    custom.bltcon1 = fill_mode | (params->fill_carry_input << 2) | 0x2;
+
+    // modulos are in bytes
+    UWORD bltmod = (background->header.width - blit_width_pixels) / 8;
+    // the address of source A and D has to be the word that defines the right
+    // bottom corner
+    UBYTE *src = background->imgdata + (params->y2 * background->header.width / 8) +
+	right / 8 - 2;
+
+    custom.bltdpt = src;
+    custom.bltapt = src;
+    custom.bltdmod = bltmod;
+    custom.bltamod = bltmod;
+
+    custom.bltsize = (blit_height << 6) | (num_words & 0x3f);
+}
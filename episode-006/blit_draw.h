@@ -0,0 +1,29 @@
+#pragma once
+#ifndef __BLIT_DRAW_H__
+#define __BLIT_DRAW_H__
+
+#include "tilesheet.h"
+
+/*
+ * Line drawing and area fill with the blitter, shared by the examples.
+ * Both work on non-interleaved bitmaps.
+ */
+#define LF_COOKIE_CUT (0xca)
+#define LF_XOR (0x4a)
+
+struct DrawLineParams {
+    UWORD x1, y1, x2, y2;
+    int plane;
+    UWORD line_pattern;
+    UBYTE pattern_offset, lf_byte, single, omit_first_pixel;
+};
+
+struct AreaFillParams {
+    int x1, y1, x2, y2;
+    UBYTE exclusive, fill_carry_input;
+};
+
+extern void ratr0_draw_line(struct Ratr0TileSheet *background, struct DrawLineParams *p);
+extern void ratr0_area_fill(struct Ratr0TileSheet *background, struct AreaFillParams *params);
+
+#endif /* __BLIT_DRAW_H__ */
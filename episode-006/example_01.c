@@ -17,6 +17,7 @@
 #include <ahpc_registers.h>
 
 #include "tilesheet.h"
+#include "blit_draw.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -121,11 +122,7 @@ static int should_exit;
 #define SPACE (0x40)
 
 // Area fill parameters
-struct AreaFillParams {
-    int x1, y1, x2, y2;
-    UBYTE exclusive, fill_carry_input;
-
-} fill_params[] = {
+struct AreaFillParams fill_params[] = {
     { 0, 14, 63, 48, FALSE, 0 },
     { 64, 14, 127, 48, FALSE, 1 },
     { 128, 14, 191, 48, FALSE, 0 },
@@ -139,9 +136,6 @@ struct AreaFillParams {
 static int num_params = 8;
 static int param_idx = 0;
 
-static void area_fill(struct Ratr0TileSheet *background,
-                      struct AreaFillParams *params);
-
 static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
                                            __reg("a1") APTR handler_data)
 {
@@ -158,7 +152,7 @@ static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
     } else if (result->ie_Class == IECLASS_RAWKEY) {
         if (result->ie_Code == SPACE) {
             if (param_idx < num_params) {
-                area_fill(&background, &fill_params[param_idx++]);
+                ratr0_area_fill(&background, &fill_params[param_idx++]);
             }
         }
     }
@@ -207,51 +201,6 @@ static void cleanup(void)
     reset_display();
 }
 
-
-/*
-  Use area fill in the specified rectangular region. It does this
-  by copying the area to itself using D = A in descending mode,
-  where src A is the background image itself. Set the fill bits
-  to specify the fill operation
-
-  Note: fill comes after shift, mask and logical operations, so
-  we can't mask out the fill
-*/
-static void area_fill(struct Ratr0TileSheet *background,
-                      struct AreaFillParams *params)
-{
-    // determine the left and right borders, which are at the
-    // word boundaries to the left and right sides
-    int left = params->x1  - (params->x1 & 0x0f);
-    int right = params->x2 + 16 - (params->x2 & 0x0f);
-    int blit_width_pixels = right - left;
-    int blit_height = (params->y2 - params->y1) + 1;
-    int num_words = blit_width_pixels / 16;
-    UBYTE fill_mode = params->exclusive ? 16 : 8;
-
-    WaitBlit();
-    custom.bltafwm = 0xffff;
-    custom.bltalwm = 0xffff;
-
-    custom.bltcon0 = 0x09f0;       // enable channels A and D, LF => D = A
-    // descending mode + fill parameters
-    custom.bltcon1 = fill_mode | (params->fill_carry_input << 2) | 0x2;
-
-    // modulos are in bytes
-    UWORD bltmod = (background->header.width - blit_width_pixels) / 8;
-    // the address of source A and D has to be the word that defines the right
-    // bottom corner
-    UBYTE *src = background->imgdata + (params->y2 * background->header.width / 8) +
-	right / 8 - 2;
-
-    custom.bltdpt = src;
-    custom.bltapt = src;
-    custom.bltdmod = bltmod;
-    custom.bltamod = bltmod;
-
-    custom.bltsize = (blit_height << 6) | (num_words & 0x3f);
-}
-
 int main(int argc, char **argv)
 {
     if (!setup_input_handler()) {
@@ -17,6 +17,7 @@
 #include <ahpc_registers.h>
 
 #include "tilesheet.h"
+#include "blit_draw.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -119,15 +120,8 @@ static struct Interrupt handler_info;
 static int should_exit;
 
 #define SPACE (0x40)
-#define LF_COOKIE_CUT (0xca)
-#define LF_XOR (0x4a)
-
-struct DrawLineParams {
-    UWORD x1, y1, x2, y2;
-    int plane;
-    UWORD line_pattern;
-    UBYTE pattern_offset, lf_byte, single, omit_first_pixel;
-} line_params[] = {
+
+struct DrawLineParams line_params[] = {
     { 1, 8, 63, 35, 0, 0xffff, 0, LF_COOKIE_CUT, FALSE, TRUE },
     { 127, 35, 65, 8, 1, 0xcccc, 3, LF_COOKIE_CUT, FALSE, FALSE },
     { 129, 32, 191, 32, 0, 0xffff, 0, LF_COOKIE_CUT, FALSE, TRUE },
@@ -138,8 +132,6 @@ struct DrawLineParams {
 static int num_params = 6;
 static int param_idx = 0;
 
-static void draw_line(struct Ratr0TileSheet *background, struct DrawLineParams *p);
-
 static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
                                            __reg("a1") APTR handler_data)
 {
@@ -156,7 +148,7 @@ static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
     } else if (result->ie_Class == IECLASS_RAWKEY) {
         if (result->ie_Code == SPACE) {
             if (param_idx < num_params) {
-                draw_line(&background, &line_params[param_idx++]);
+                ratr0_draw_line(&background, &line_params[param_idx++]);
             }
         }
     }
@@ -205,75 +197,6 @@ static void cleanup(void)
     reset_display();
 }
 
-/**
- *  Draw a line assuming left top corner is at 0, 0 of the destination bit plane.
- */
-// some empty memory to point the first line pixel to
-static UWORD __chip scratchmem[12];
-static void draw_line(struct Ratr0TileSheet *background, struct DrawLineParams *p)
-{
-    UWORD dx = abs(p->x2 - p->x1), dy = abs(p->y2 - p->y1), dmax, dmin;
-    UWORD bytes_per_line = background->header.width / 8;
-
-    // Determine the octant code
-    UBYTE code;
-    if (p->y1 >= p->y2) {
-        if (p->x1 <= p->x2) {
-            code = dx >= dy ? 6 : 1;
-        } else {
-            code = dx <= dy ? 3 : 7;
-        }
-    } else {
-        if (p->x1 >= p->x2) {
-            code = dx >= dy ? 5 : 2;
-        } else {
-            code = dx <= dy ? 0 : 4;
-        }
-    }
-
-    if (dx <= dy) {
-        dmin = dx;
-        dmax = dy;
-    } else {
-        dmin = dy;
-        dmax = dx;
-    }
-    WORD aptlval = 4 * dmin - 2 * dmax;
-    UWORD startx = (p->x1 & 0xf) << 12;  // x1 modulo 16
-    UWORD texture = ((p->x1 + p->pattern_offset) & 0xf) << 12;  // BSH in BLTCON1
-    UWORD sign = (aptlval < 0 ? 1 : 0) << 6;
-    UWORD bltcon1val = texture | sign | (code << 2) | (p->single << 1) | 0x01;
-
-    APTR start_address = background->imgdata +
-        p->plane * (background->header.width / 8 * background->header.height) +
-        p->y1 * bytes_per_line + p->x1 / 8;
-
-    WaitBlit();
-    custom.bltapt = (APTR) ((UWORD) aptlval);
-    custom.bltcpt = start_address;
-
-    // this is actually only used for the first pixel of the line
-    // if we point this to another memory area, the first pixel will
-    // not be plotted. Research this more and then see whether we should
-    // use that in the tutorial
-    custom.bltdpt = p->omit_first_pixel ? scratchmem : start_address;
-
-    custom.bltamod = 4 * (dmin - dmax);
-    custom.bltbmod = 4 * dmin;
-
-    custom.bltcmod = background->header.width / 8;  // destination width in bytes
-    custom.bltdmod = background->header.width / 8;
-    custom.bltcon0 = 0x0b00 | p->lf_byte | startx;
-    custom.bltcon1 = bltcon1val;
-
-    custom.bltadat = 0x8000;  // draw "pen" pixel
-    custom.bltbdat = p->line_pattern;
-    custom.bltafwm = 0xffff;
-    custom.bltalwm = 0xffff;
-
-    custom.bltsize = ((dmax + 1) << 6) + 2;
-}
-
 int main(int argc, char **argv)
 {
     if (!setup_input_handler()) {
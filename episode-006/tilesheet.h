@@ -4,6 +4,8 @@
 
 // information about a tile sheet
 #define FILE_ID_LEN (8)
+#define TILESHEET_ID "RATR0TIL"
+#define TILESHEET_VERSION (2)
 
 // information about a tile sheet
 // File format version 2
@@ -29,6 +31,7 @@ struct Ratr0TileSheet {
     UBYTE *imgdata;
 };
 
+extern UWORD ratr0_checksum(UBYTE *data, ULONG size);
 extern ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet);
 extern void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet);
 
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <dos/dos.h>
+#include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
+
+#include "archive.h"
+
+/**
+ * Opens an archive and reads its index. The file stays open until
+ * ratr0_close_archive() is called.
+ *
+ * @param filename path to the archive
+ * @param archive pointer to a Ratr0Archive structure
+ * @return TRUE on success
+ */
+BOOL ratr0_open_archive(const char *filename, struct Ratr0Archive *archive)
+{
+    struct Ratr0ArchiveHeader *header = &archive->header;
+    const char *error = NULL;
+    LONG index_size = 0;
+
+    archive->entries = NULL;
+    archive->fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!archive->fh) {
+        printf("ratr0_open_archive() error: file '%s' not found\n", filename);
+        return FALSE;
+    }
+    if (Read(archive->fh, header, sizeof(struct Ratr0ArchiveHeader)) !=
+        sizeof(struct Ratr0ArchiveHeader)) {
+        error = "truncated header";
+    } else if (memcmp(header->id, ARCHIVE_ID, ARCHIVE_ID_LEN)) {
+        error = "not an archive";
+    } else if (header->version != ARCHIVE_VERSION) {
+        error = "unsupported version";
+    } else if (header->num_entries == 0) {
+        error = "empty archive";
+    } else if (!(archive->entries = AllocMem(index_size = header->num_entries *
+                                             sizeof(struct Ratr0ArchiveEntry), MEMF_ANY))) {
+        error = "not enough memory";
+    } else if (Read(archive->fh, archive->entries, index_size) != index_size) {
+        error = "truncated index";
+    }
+    if (error) {
+        printf("ratr0_open_archive() error: '%s': %s\n", filename, error);
+        ratr0_close_archive(archive);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Closes the archive file and frees the index.
+ */
+void ratr0_close_archive(struct Ratr0Archive *archive)
+{
+    if (archive->entries) {
+        FreeMem(archive->entries, archive->header.num_entries * sizeof(struct Ratr0ArchiveEntry));
+    }
+    if (archive->fh) Close(archive->fh);
+    archive->entries = NULL;
+    archive->fh = 0;
+}
+
+/**
+ * Looks up an entry by name.
+ *
+ * @return the entry id, -1 if there is no entry with this name
+ */
+int ratr0_find_archive_entry(struct Ratr0Archive *archive, const char *name)
+{
+    for (int i = 0; i < archive->header.num_entries; i++) {
+        if (!strncmp((const char *) archive->entries[i].name, name, ARCHIVE_NAME_LEN)) return i;
+    }
+    printf("ratr0_find_archive_entry() error: no entry '%s'\n", name);
+    return -1;
+}
+
+/**
+ * Positions the archive file at the start of an entry, so a loader that
+ * reads from a file handle can read it.
+ *
+ * @return the archive file handle, 0 if the id is invalid
+ */
+BPTR ratr0_seek_archive_entry(struct Ratr0Archive *archive, int id)
+{
+    if (id < 0 || id >= archive->header.num_entries) return 0;
+    // entries are usually read in order, so this does not actually move
+    if (Seek(archive->fh, archive->entries[id].offset, OFFSET_BEGINNING) == -1) return 0;
+    return archive->fh;
+}
+
+/**
+ * Reads the data of an entry into a buffer.
+ *
+ * @param archive the archive
+ * @param id entry id
+ * @param dst destination buffer
+ * @param max_size size of the destination buffer
+ * @return number of bytes read, 0 on error
+ */
+ULONG ratr0_read_archive_entry(struct Ratr0Archive *archive, int id, UBYTE *dst, ULONG max_size)
+{
+    BPTR fh = ratr0_seek_archive_entry(archive, id);
+    if (!fh) return 0;
+    ULONG size = archive->entries[id].size;
+    if (size > max_size) {
+        printf("ratr0_read_archive_entry() error: entry '%s' is too large\n",
+               archive->entries[id].name);
+        return 0;
+    }
+    return Read(fh, dst, size) == size ? size : 0;
+}
+
+/**
+ * Allocates memory of the entry's memory type and reads the entry.
+ * The data needs to be freed with ratr0_free_archive_data().
+ *
+ * @return the data, NULL on error
+ */
+UBYTE *ratr0_load_archive_entry(struct Ratr0Archive *archive, int id)
+{
+    if (id < 0 || id >= archive->header.num_entries) return NULL;
+    struct Ratr0ArchiveEntry *entry = &archive->entries[id];
+    UBYTE *data = AllocMem(entry->size,
+                           entry->mem_type == ARCHIVE_MEM_CHIP ? MEMF_CHIP : MEMF_ANY);
+    if (!data) {
+        printf("ratr0_load_archive_entry() error: not enough memory for '%s'\n", entry->name);
+        return NULL;
+    }
+    if (!ratr0_read_archive_entry(archive, id, data, entry->size)) {
+        FreeMem(data, entry->size);
+        return NULL;
+    }
+    return data;
+}
+
+void ratr0_free_archive_data(struct Ratr0Archive *archive, int id, UBYTE *data)
+{
+    if (data) FreeMem(data, archive->entries[id].size);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef __ARCHIVE_H__
+#define __ARCHIVE_H__
+
+#include <dos/dos.h>
+
+/*
+ * Packed asset archive: all assets of a program in a single file, so only
+ * one file needs to be opened at startup. The header is followed by an
+ * index with the name, position, size and memory type of every entry, the
+ * entry data follows the index in the same order.
+ * Archives are created with tools/pack_assets.py.
+ */
+#define ARCHIVE_ID "RATR0PAK"
+#define ARCHIVE_ID_LEN (8)
+#define ARCHIVE_VERSION (1)
+#define ARCHIVE_NAME_LEN (24)
+
+// entry types
+#define ARCHIVE_TYPE_RAW         (0)
+#define ARCHIVE_TYPE_TILESHEET   (1)
+#define ARCHIVE_TYPE_LEVEL       (2)
+#define ARCHIVE_TYPE_SPRITESHEET (3)
+#define ARCHIVE_TYPE_SAMPLE      (4)
+
+// memory the entry should be loaded into
+#define ARCHIVE_MEM_ANY  (0)
+#define ARCHIVE_MEM_CHIP (1)
+
+struct Ratr0ArchiveHeader {
+    UBYTE id[ARCHIVE_ID_LEN];
+    UBYTE version, reserved;
+    UWORD num_entries;
+};
+
+struct Ratr0ArchiveEntry {
+    UBYTE name[ARCHIVE_NAME_LEN];  // 0 terminated
+    ULONG offset;  // from the start of the file
+    ULONG size;
+    UBYTE type, mem_type;
+};
+
+struct Ratr0Archive {
+    BPTR fh;
+    struct Ratr0ArchiveHeader header;
+    struct Ratr0ArchiveEntry *entries;
+};
+
+extern BOOL ratr0_open_archive(const char *filename, struct Ratr0Archive *archive);
+extern void ratr0_close_archive(struct Ratr0Archive *archive);
+extern int ratr0_find_archive_entry(struct Ratr0Archive *archive, const char *name);
+extern BPTR ratr0_seek_archive_entry(struct Ratr0Archive *archive, int id);
+extern ULONG ratr0_read_archive_entry(struct Ratr0Archive *archive, int id, UBYTE *dst, ULONG max_size);
+extern UBYTE *ratr0_load_archive_entry(struct Ratr0Archive *archive, int id);
+extern void ratr0_free_archive_data(struct Ratr0Archive *archive, int id, UBYTE *data);
+
+#endif /* __ARCHIVE_H__ */
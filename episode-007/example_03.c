@@ -1,4 +1,3 @@
-#include <hardware/dmabits.h>
 #include <graphics/gfxbase.h>
 #include <devices/input.h>
 
@@ -9,12 +8,15 @@
 
 #include <stdio.h>
 
+#include "archive.h"
+#include "stream.h"
+
 /*
  * This example demonstrates switching between sounds and interrupting the
- * previously playing sound
+ * previously playing sound. The sounds are streamed from the archive
+ * through 2 small chip memory buffers instead of being loaded.
  */
 extern struct GfxBase *GfxBase;
-extern struct Custom custom;
 
 // To handle input
 static struct MsgPort *input_mp;
@@ -22,19 +24,16 @@ static struct IOStdReq *input_io;
 static struct Interrupt handler_info;
 static int should_exit;
 
+// all samples are loaded from a single archive, see the Makefile
+#define ARCHIVE_FILENAME "example_03.pak"
+
 // These are 22.05k samples
-#define SOUND1_FILE "sr22.05k/strat_powerchord.raw8"
-#define SOUND1_DATA_BYTES (14715)
-#define SOUND2_FILE "sr22.05k/only_amiga.raw8"
-#define SOUND2_DATA_BYTES (21264)
-#define SOUND3_FILE "sr22.05k/cowbell.raw8"
-#define SOUND3_DATA_BYTES (10747)
-#define SOUND4_FILE "sr7k/bass.raw8"
-#define SOUND4_DATA_BYTES (2551)
-#define SOUND5_FILE "sr22.05k/otomatone.raw8"
-#define SOUND5_DATA_BYTES (18132)
-#define SOUND6_FILE "sr22.05k/welcome.raw8"
-#define SOUND6_DATA_BYTES (51325)
+#define SOUND1_FILE "strat_powerchord.raw8"
+#define SOUND2_FILE "only_amiga.raw8"
+#define SOUND3_FILE "cowbell.raw8"
+#define SOUND4_FILE "bass.raw8"
+#define SOUND5_FILE "otomatone.raw8"
+#define SOUND6_FILE "welcome.raw8"
 
 // NTSC: 1 / (sample rate * 2.79365 * 10^-7)
 // PAL 1 / (sample rate * 2.81937 * 10^-7)
@@ -46,12 +45,10 @@ static int should_exit;
 #define SAMPLE_PERIOD_7K_PAL (507)
 #define MAX_VOLUME (64)
 
-static UBYTE __chip sound1_data[SOUND1_DATA_BYTES];
-static UBYTE __chip sound2_data[SOUND2_DATA_BYTES];
-static UBYTE __chip sound3_data[SOUND3_DATA_BYTES];
-static UBYTE __chip sound4_data[SOUND4_DATA_BYTES];
-static UBYTE __chip sound5_data[SOUND5_DATA_BYTES];
-static UBYTE __chip sound6_data[SOUND6_DATA_BYTES];
+// a buffer plays for about 1/5 second at 22.05k, which is plenty for a
+// sequential read, the 2 buffers replace over 100 KB of sample data in
+// chip memory
+#define STREAM_BUFFER_BYTES (4096)
 
 UWORD sample_periods_pal[] = {SAMPLE_PERIOD_22_05K_PAL, SAMPLE_PERIOD_14K_PAL, SAMPLE_PERIOD_7K_PAL};
 UWORD sample_periods_ntsc[] = {SAMPLE_PERIOD_22_05K_NTSC, SAMPLE_PERIOD_14K_NTSC,
@@ -61,21 +58,22 @@ enum SampleRate {SAMPLE_RATE_22_05K = 0, SAMPLE_RATE_14K, SAMPLE_RATE_7K};
 
 struct SoundData {
     const char *path;
-    UBYTE __chip *data;
-    UWORD num_bytes;
+    ULONG offset;  // in the archive
+    ULONG num_bytes;
     int sample_rate;
 } sounds[] = {
-    { SOUND1_FILE, sound1_data, SOUND1_DATA_BYTES, SAMPLE_RATE_22_05K },
-    { SOUND2_FILE, sound2_data, SOUND2_DATA_BYTES, SAMPLE_RATE_22_05K },
-    { SOUND3_FILE, sound3_data, SOUND3_DATA_BYTES, SAMPLE_RATE_22_05K },
-    { SOUND4_FILE, sound4_data, SOUND4_DATA_BYTES, SAMPLE_RATE_7K },
-    { SOUND5_FILE, sound5_data, SOUND5_DATA_BYTES, SAMPLE_RATE_22_05K },
-    { SOUND6_FILE, sound6_data, SOUND6_DATA_BYTES, SAMPLE_RATE_22_05K }
+    { SOUND1_FILE, 0, 0, SAMPLE_RATE_22_05K },
+    { SOUND2_FILE, 0, 0, SAMPLE_RATE_22_05K },
+    { SOUND3_FILE, 0, 0, SAMPLE_RATE_22_05K },
+    { SOUND4_FILE, 0, 0, SAMPLE_RATE_7K },
+    { SOUND5_FILE, 0, 0, SAMPLE_RATE_22_05K },
+    { SOUND6_FILE, 0, 0, SAMPLE_RATE_22_05K }
 };
 
 #define NUM_SOUNDS (6)
 static int next_sound = 1;
 static BOOL go_next_sound = FALSE;
+static struct Ratr0Stream stream;
 
 static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
                                            __reg("a1") APTR handler_data)
@@ -129,30 +127,31 @@ static int setup_input_handler(void)
     return 1;
 }
 
-void play_next_sound(BOOL is_pal)
+static void play_sound(struct SoundData *sound, BOOL is_pal)
 {
-    // stop DMA, shorten sample period and set volume to 0
-    custom.dmacon = DMAF_AUD0;
-    custom.aud[0].ac_per = 1;
-    custom.aud[0].ac_vol = 0;
-
-    // wait at least 2 sample periods, we wait for 6 lines here
-    LONG vpos = VBeamPos();
-    while (VBeamPos() - vpos < 6) ;
-
-    // now we switch to the next sound
-    custom.aud[0].ac_ptr = (UWORD *) sounds[next_sound].data;
-    custom.aud[0].ac_len = sounds[next_sound].num_bytes / 2;
-    custom.aud[0].ac_per = is_pal ? sample_periods_pal[sounds[next_sound].sample_rate] :
-        sample_periods_ntsc[sounds[next_sound].sample_rate];
-    custom.aud[0].ac_vol = MAX_VOLUME;
-
-    // start fetching data again
-    custom.dmacon = DMAF_SETCLR | DMAF_AUD0;
-
-    next_sound++;
-    next_sound %= NUM_SOUNDS;
-    go_next_sound = FALSE;
+    // the stream stops the previous sound
+    ratr0_play_stream(&stream, sound->offset, sound->num_bytes,
+                      is_pal ? sample_periods_pal[sound->sample_rate] :
+                      sample_periods_ntsc[sound->sample_rate], MAX_VOLUME);
+}
+
+// looks up the positions of the sounds in the archive
+static BOOL find_sounds(void)
+{
+    struct Ratr0Archive archive;
+    if (!ratr0_open_archive(ARCHIVE_FILENAME, &archive)) return FALSE;
+    for (int i = 0; i < NUM_SOUNDS; i++) {
+        int id = ratr0_find_archive_entry(&archive, sounds[i].path);
+        if (id < 0) {
+            printf("Could not find sound '%s'\n", sounds[i].path);
+            ratr0_close_archive(&archive);
+            return FALSE;
+        }
+        sounds[i].offset = archive.entries[id].offset;
+        sounds[i].num_bytes = archive.entries[id].size;
+    }
+    ratr0_close_archive(&archive);
+    return TRUE;
 }
 
 int main(int argc, char **argv)
@@ -161,32 +160,26 @@ int main(int argc, char **argv)
         puts("Could not initialize input handler");
         return 1;
     }
-    custom.dmacon = DMAF_AUD0;
     BOOL is_pal = (((struct GfxBase *) GfxBase)->DisplayFlags & PAL) == PAL;
-    FILE *fp;
-    int bytes_read;
-    for (int i = 0; i < NUM_SOUNDS; i++) {
-        fp = fopen(sounds[i].path, "rb");
-        bytes_read = fread(sounds[i].data, sizeof(UBYTE), sounds[i].num_bytes, fp);
-        fclose(fp);
+    if (!find_sounds() ||
+        !ratr0_init_stream(&stream, ARCHIVE_FILENAME, 0, STREAM_BUFFER_BYTES)) {
+        cleanup_input_handler();
+        return 1;
     }
-    custom.aud[0].ac_ptr = (UWORD *) sounds[0].data;
-    custom.aud[0].ac_len = sounds[0].num_bytes / 2;
-    custom.aud[0].ac_per = is_pal ? sample_periods_pal[sounds[0].sample_rate] :
-       sample_periods_ntsc[sounds[0].sample_rate];
-    custom.aud[0].ac_vol = MAX_VOLUME;
-
-    custom.dmacon = DMAF_SETCLR | DMAF_AUD0;
+    play_sound(&sounds[0], is_pal);
 
     // the event loop
     while (!should_exit) {
         if (go_next_sound) {
-          play_next_sound(is_pal);
+            play_sound(&sounds[next_sound], is_pal);
+            next_sound = (next_sound + 1) % NUM_SOUNDS;
+            go_next_sound = FALSE;
         }
         WaitTOF();
     }
-    // stop audio channel 0
-    custom.dmacon = DMAF_AUD0;
+    // stops audio channel 0
+    ratr0_free_stream(&stream);
+    if (stream.underruns) printf("%d buffer underruns\n", stream.underruns);
     cleanup_input_handler();
     return 0;
 }
@@ -0,0 +1,190 @@
+#include <hardware/dmabits.h>
+#include <graphics/gfxbase.h>
+#include <devices/input.h>
+
+#include <clib/exec_protos.h>
+#include <clib/graphics_protos.h>
+#include <clib/intuition_protos.h>
+#include <clib/alib_protos.h>
+
+#include <stdio.h>
+
+#include "archive.h"
+#include "mixer.h"
+
+/*
+ * This example demonstrates the software mixer: every click of the right
+ * mouse button starts the next sound on a free voice while the previous
+ * sounds keep playing, a bass loop plays in the background
+ */
+extern struct GfxBase *GfxBase;
+extern struct Custom custom;
+
+// To handle input
+static struct MsgPort *input_mp;
+static struct IOStdReq *input_io;
+static struct Interrupt handler_info;
+static int should_exit;
+
+// the samples of example_03, see the Makefile
+#define ARCHIVE_FILENAME "example_03.pak"
+#define BASS_FILE "bass.raw8"
+
+// Mixing at half the 22.05k sample rate keeps the mixing cost low, 8 voices
+// are mixed into the 4 hardware channels
+#define MIX_PERIOD_PAL (322)
+#define MIX_PERIOD_NTSC (324)
+#define SAMPLE_PERIOD_22_05K_NTSC (162)
+#define SAMPLE_PERIOD_22_05K_PAL (161)
+#define SAMPLE_PERIOD_7K_NTSC (511)
+#define SAMPLE_PERIOD_7K_PAL (507)
+#define MIX_CHANNELS (4)
+#define VOICES_PER_CHANNEL (2)
+#define MIX_BUFFER_BYTES (512)
+
+struct SoundData {
+    const char *path;
+    BYTE *data;  // does not need to be in chip memory
+    UWORD num_bytes;
+    ULONG step;
+} sounds[] = {
+    { "strat_powerchord.raw8" },
+    { "only_amiga.raw8" },
+    { "cowbell.raw8" },
+    { "otomatone.raw8" },
+    { "welcome.raw8" },
+    { BASS_FILE }
+};
+
+#define NUM_SOUNDS (6)
+#define BASS_SOUND (5)
+static int next_sound = 0;
+static BOOL go_next_sound = FALSE;
+static struct Ratr0Mixer mixer;
+
+static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
+                                           __reg("a1") APTR handler_data)
+{
+    struct InputEvent *result = event, *prev = NULL;
+
+    Forbid();
+    // Intercept all raw mouse events before they reach Intuition, ignore
+    // everything else
+    if (result->ie_Class == IECLASS_RAWMOUSE) {
+        if (result->ie_Code == IECODE_LBUTTON) {
+            should_exit = 1;
+        } else if (result->ie_Code == IECODE_RBUTTON) {
+            go_next_sound = TRUE;
+        }
+        return NULL;
+    }
+    Permit();
+    return result;
+}
+
+static void cleanup_input_handler(void)
+{
+    if (input_io) {
+        // remove our input handler from the chain
+        input_io->io_Command = IND_REMHANDLER;
+        input_io->io_Data = (APTR) &handler_info;
+        DoIO((struct IORequest *) input_io);
+
+        if (!(CheckIO((struct IORequest *) input_io))) AbortIO((struct IORequest *) input_io);
+        WaitIO((struct IORequest *) input_io);
+        CloseDevice((struct IORequest *) input_io);
+        DeleteExtIO((struct IORequest *) input_io);
+    }
+    if (input_mp) DeletePort(input_mp);
+}
+
+static int setup_input_handler(void)
+{
+    input_mp = CreatePort(0, 0);
+    input_io = (struct IOStdReq *) CreateExtIO(input_mp, sizeof(struct IOStdReq));
+    BYTE error = OpenDevice("input.device", 0L, (struct IORequest *) input_io, 0);
+
+    handler_info.is_Code = (void (*)(void)) my_input_handler;
+    handler_info.is_Data = NULL;
+    handler_info.is_Node.ln_Pri = 100;
+    handler_info.is_Node.ln_Name = "ex04";
+    input_io->io_Command = IND_ADDHANDLER;
+    input_io->io_Data = (APTR) &handler_info;
+    DoIO((struct IORequest *) input_io);
+    return 1;
+}
+
+static void cleanup(void)
+{
+    ratr0_free_mixer(&mixer);
+    for (int i = 0; i < NUM_SOUNDS; i++) {
+        if (sounds[i].data) FreeMem(sounds[i].data, sounds[i].num_bytes);
+    }
+    cleanup_input_handler();
+}
+
+// reads the samples into any memory
+static BOOL load_sounds(void)
+{
+    struct Ratr0Archive archive;
+    if (!ratr0_open_archive(ARCHIVE_FILENAME, &archive)) return FALSE;
+    for (int i = 0; i < NUM_SOUNDS; i++) {
+        int id = ratr0_find_archive_entry(&archive, sounds[i].path);
+        if (id < 0) {
+            printf("Could not find sound '%s'\n", sounds[i].path);
+            ratr0_close_archive(&archive);
+            return FALSE;
+        }
+        ULONG size = archive.entries[id].size;
+        // the mixer's positions are limited to 16 bits
+        sounds[i].num_bytes = size > 0xffff ? 0xffff : size;
+        sounds[i].data = AllocMem(sounds[i].num_bytes, MEMF_ANY);
+        if (!sounds[i].data ||
+            !ratr0_read_archive_entry(&archive, id, (UBYTE *) sounds[i].data, sounds[i].num_bytes)) {
+            printf("Could not read sound '%s'\n", sounds[i].path);
+            ratr0_close_archive(&archive);
+            return FALSE;
+        }
+    }
+    ratr0_close_archive(&archive);
+    return TRUE;
+}
+
+int main(int argc, char **argv)
+{
+    if (!setup_input_handler()) {
+        puts("Could not initialize input handler");
+        return 1;
+    }
+    BOOL is_pal = (((struct GfxBase *) GfxBase)->DisplayFlags & PAL) == PAL;
+    if (!load_sounds() ||
+        !ratr0_init_mixer(&mixer, MIX_CHANNELS, VOICES_PER_CHANNEL, MIX_BUFFER_BYTES,
+                          is_pal ? MIX_PERIOD_PAL : MIX_PERIOD_NTSC)) {
+        cleanup();
+        return 1;
+    }
+    for (int i = 0; i < NUM_SOUNDS; i++) {
+        UWORD period = i == BASS_SOUND ?
+            (is_pal ? SAMPLE_PERIOD_7K_PAL : SAMPLE_PERIOD_7K_NTSC) :
+            (is_pal ? SAMPLE_PERIOD_22_05K_PAL : SAMPLE_PERIOD_22_05K_NTSC);
+        sounds[i].step = ratr0_mixer_step(&mixer, period);
+    }
+    ratr0_start_mixer(&mixer);
+    ratr0_play_voice(&mixer, sounds[BASS_SOUND].data, sounds[BASS_SOUND].num_bytes,
+                     sounds[BASS_SOUND].step, 32, TRUE);
+
+    // the event loop
+    while (!should_exit) {
+        if (go_next_sound) {
+            struct SoundData *sound = &sounds[next_sound];
+            if (ratr0_play_voice(&mixer, sound->data, sound->num_bytes, sound->step, 64, FALSE) < 0) {
+                puts("all voices busy");
+            }
+            next_sound = (next_sound + 1) % BASS_SOUND;
+            go_next_sound = FALSE;
+        }
+        WaitTOF();
+    }
+    cleanup();
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <hardware/dmabits.h>
+#include <graphics/gfxbase.h>
+#include <devices/input.h>
+
+#include <clib/exec_protos.h>
+#include <clib/graphics_protos.h>
+#include <clib/intuition_protos.h>
+#include <clib/alib_protos.h>
+
+#include <stdio.h>
+
+#include "modplayer.h"
+
+/*
+ * This example plays a ProTracker module until the left mouse button is
+ * clicked. The module is given on the command line, the longest time the
+ * player's interrupt took is printed at the end.
+ */
+extern struct GfxBase *GfxBase;
+
+// To handle input
+static struct MsgPort *input_mp;
+static struct IOStdReq *input_io;
+static struct Interrupt handler_info;
+static int should_exit;
+
+#define DEFAULT_MOD_FILE "music.mod"
+
+static struct Ratr0ModPlayer player;
+
+static struct InputEvent *my_input_handler(__reg("a0") struct InputEvent *event,
+                                           __reg("a1") APTR handler_data)
+{
+    struct InputEvent *result = event, *prev = NULL;
+
+    Forbid();
+    // Intercept all raw mouse events before they reach Intuition, ignore
+    // everything else
+    if (result->ie_Class == IECLASS_RAWMOUSE) {
+        if (result->ie_Code == IECODE_LBUTTON) {
+            should_exit = 1;
+        }
+        return NULL;
+    }
+    Permit();
+    return result;
+}
+
+static void cleanup_input_handler(void)
+{
+    if (input_io) {
+        // remove our input handler from the chain
+        input_io->io_Command = IND_REMHANDLER;
+        input_io->io_Data = (APTR) &handler_info;
+        DoIO((struct IORequest *) input_io);
+
+        if (!(CheckIO((struct IORequest *) input_io))) AbortIO((struct IORequest *) input_io);
+        WaitIO((struct IORequest *) input_io);
+        CloseDevice((struct IORequest *) input_io);
+        DeleteExtIO((struct IORequest *) input_io);
+    }
+    if (input_mp) DeletePort(input_mp);
+}
+
+static int setup_input_handler(void)
+{
+    input_mp = CreatePort(0, 0);
+    input_io = (struct IOStdReq *) CreateExtIO(input_mp, sizeof(struct IOStdReq));
+    BYTE error = OpenDevice("input.device", 0L, (struct IORequest *) input_io, 0);
+
+    handler_info.is_Code = (void (*)(void)) my_input_handler;
+    handler_info.is_Data = NULL;
+    handler_info.is_Node.ln_Pri = 100;
+    handler_info.is_Node.ln_Name = "ex05";
+    input_io->io_Command = IND_ADDHANDLER;
+    input_io->io_Data = (APTR) &handler_info;
+    DoIO((struct IORequest *) input_io);
+    return 1;
+}
+
+static void cleanup(void)
+{
+    ratr0_free_mod(&player);
+    cleanup_input_handler();
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : DEFAULT_MOD_FILE;
+    if (!setup_input_handler()) {
+        puts("Could not initialize input handler");
+        return 1;
+    }
+    if (!ratr0_load_mod(filename, &player)) {
+        cleanup();
+        return 1;
+    }
+    BOOL is_pal = (((struct GfxBase *) GfxBase)->DisplayFlags & PAL) == PAL;
+    printf("playing '%s', %d patterns\n", player.title, player.num_patterns);
+    if (!ratr0_start_mod(&player, is_pal)) {
+        cleanup();
+        return 1;
+    }
+
+    // the event loop
+    while (!should_exit) {
+        WaitTOF();
+    }
+    ratr0_stop_mod(&player);
+    printf("longest interrupt: %d raster lines\n", player.max_lines);
+    cleanup();
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include <exec/memory.h>
+#include <hardware/custom.h>
+#include <hardware/dmabits.h>
+#include <hardware/intbits.h>
+#include <clib/exec_protos.h>
+
+#include <stdio.h>
+
+#include "mixer.h"
+
+extern struct Custom custom;
+
+// sample values scaled by volume and number of voices, indexed by the
+// sample as unsigned byte
+static BYTE volume_tables[MIXER_VOLUME_LEVELS][256];
+
+static const UWORD AUDIO_INTF[] = { INTF_AUD0, INTF_AUD1, INTF_AUD2, INTF_AUD3 };
+static const UWORD AUDIO_DMAF[] = { DMAF_AUD0, DMAF_AUD1, DMAF_AUD2, DMAF_AUD3 };
+
+static void init_volume_tables(UWORD voices_per_channel)
+{
+    for (int v = 0; v < MIXER_VOLUME_LEVELS; v++) {
+        for (int s = 0; s < 256; s++) {
+            volume_tables[v][s] = (BYTE) ((BYTE) s * v * 2 / (64 * voices_per_channel));
+        }
+    }
+}
+
+/**
+ * Initializes the mixer and allocates the output buffers.
+ *
+ * @param mixer the mixer
+ * @param num_channels number of hardware channels, the mixer uses channels 0 to
+ *        num_channels - 1
+ * @param voices_per_channel number of voices mixed into each hardware channel
+ * @param buffer_bytes size of an output buffer, a multiple of 4. The
+ *        latency of starting a voice is up to 2 buffers.
+ * @param period sample period of the mixed output
+ * @return FALSE if the parameters are out of range or there is not enough
+ *         chip memory
+ */
+BOOL ratr0_init_mixer(struct Ratr0Mixer *mixer, UWORD num_channels,
+                      UWORD voices_per_channel, UWORD buffer_bytes, UWORD period)
+{
+    mixer->buffer_mem = NULL;
+    mixer->running = FALSE;
+    if (num_channels == 0 || num_channels > MIXER_MAX_CHANNELS ||
+        voices_per_channel == 0 ||
+        num_channels * voices_per_channel > MIXER_MAX_VOICES ||
+        buffer_bytes == 0 || (buffer_bytes & 3)) {
+        puts("ratr0_init_mixer() error: invalid parameters");
+        return FALSE;
+    }
+    mixer->buffer_mem = AllocMem(num_channels * buffer_bytes * 2, MEMF_CHIP | MEMF_CLEAR);
+    if (!mixer->buffer_mem) {
+        puts("ratr0_init_mixer() error: not enough chip memory");
+        return FALSE;
+    }
+    mixer->num_channels = num_channels;
+    mixer->voices_per_channel = voices_per_channel;
+    mixer->buffer_bytes = buffer_bytes;
+    mixer->period = period;
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) mixer->voices[i].active = FALSE;
+
+    BYTE *buffer = mixer->buffer_mem;
+    for (int i = 0; i < num_channels; i++) {
+        struct Ratr0MixerChannel *channel = &mixer->channels[i];
+        channel->mixer = mixer;
+        channel->index = i;
+        channel->buffers[0] = buffer;
+        channel->buffers[1] = buffer + buffer_bytes;
+        channel->back = 1;
+        buffer += buffer_bytes * 2;
+    }
+    init_volume_tables(voices_per_channel);
+    return TRUE;
+}
+
+/*
+ * Mixes up to num_samples samples of a voice into out, returns the number
+ * of samples that were mixed. If add is FALSE, the samples are stored
+ * instead of added. The loops are unrolled for the 68000, the position
+ * is a 16.16 fixed point value, so the index is its upper word.
+ */
+#define MIX_STORE *out++ = table[(UBYTE) data[pos >> 16]]; pos += step
+#define MIX_ADD   *out++ += table[(UBYTE) data[pos >> 16]]; pos += step
+
+static UWORD mix_voice(struct Ratr0MixerVoice *voice, BYTE *out, UWORD num_samples, BOOL add)
+{
+    register const BYTE *data = voice->data;
+    register const BYTE *table = volume_tables[voice->volume >> 1];
+    register ULONG pos = voice->pos, step = voice->step;
+
+    // samples left until the end of the voice
+    ULONG left = (voice->end - pos + step - 1) / step;
+    UWORD count = left < num_samples ? left : num_samples;
+    UWORD n = count >> 2;
+
+    if (add) {
+        while (n--) {
+            MIX_ADD; MIX_ADD; MIX_ADD; MIX_ADD;
+        }
+        for (n = count & 3; n; n--) {
+            MIX_ADD;
+        }
+    } else {
+        while (n--) {
+            MIX_STORE; MIX_STORE; MIX_STORE; MIX_STORE;
+        }
+        for (n = count & 3; n; n--) {
+            MIX_STORE;
+        }
+    }
+    voice->pos = pos;
+    return count;
+}
+
+/*
+ * Mixes the voices of a channel into a buffer. A voice covers the buffer
+ * from the start until it ends, so the samples before the end of the
+ * longest voice so far are added to, the ones after it are stored.
+ */
+static void mix_channel(struct Ratr0MixerChannel *channel, BYTE *out)
+{
+    struct Ratr0Mixer *mixer = channel->mixer;
+    struct Ratr0MixerVoice *voice = &mixer->voices[channel->index * mixer->voices_per_channel];
+    UWORD num_samples = mixer->buffer_bytes, mixed = 0;
+
+    for (int i = 0; i < mixer->voices_per_channel; i++, voice++) {
+        UWORD done = 0;
+        while (voice->active && done < num_samples) {
+            BOOL add = done < mixed;
+            done += mix_voice(voice, out + done, (add ? mixed : num_samples) - done, add);
+            if (voice->pos >= voice->end) {
+                // keep the fraction when looping
+                while (voice->pos >= voice->end) voice->pos -= voice->end;
+                voice->active = voice->loop;
+            }
+        }
+        if (done > mixed) mixed = done;
+    }
+    // silence after the longest voice
+    BYTE *p = out + mixed;
+    while (mixed < num_samples && (mixed & 3)) {
+        *p++ = 0;
+        mixed++;
+    }
+    for (ULONG *lp = (ULONG *) p, n = (num_samples - mixed) >> 2; n; n--) *lp++ = 0;
+}
+
+/*
+ * Audio interrupt handler: the hardware has started to play the front
+ * buffer, queue the back buffer and mix it.
+ */
+static void audio_int_handler(__reg("a1") struct Ratr0MixerChannel *channel)
+{
+    BYTE *buffer = channel->buffers[channel->back];
+    custom.aud[channel->index].ac_ptr = (UWORD *) buffer;
+    custom.intreq = AUDIO_INTF[channel->index];
+    channel->back ^= 1;
+    mix_channel(channel, buffer);
+}
+
+/**
+ * Installs the audio interrupts and starts playing. The mixer owns the
+ * hardware channels until ratr0_stop_mixer() is called.
+ *
+ * @param mixer the mixer
+ */
+void ratr0_start_mixer(struct Ratr0Mixer *mixer)
+{
+    UWORD intf = 0, dmaf = 0;
+    for (int i = 0; i < mixer->num_channels; i++) {
+        intf |= AUDIO_INTF[i];
+        dmaf |= AUDIO_DMAF[i];
+    }
+    mixer->old_intena = custom.intenar;
+    custom.dmacon = dmaf;
+    custom.intena = intf;
+    custom.intreq = intf;
+
+    for (int i = 0; i < mixer->num_channels; i++) {
+        struct Ratr0MixerChannel *channel = &mixer->channels[i];
+        channel->interrupt.is_Node.ln_Type = NT_INTERRUPT;
+        channel->interrupt.is_Node.ln_Pri = 0;
+        channel->interrupt.is_Node.ln_Name = "ratr0 mixer";
+        channel->interrupt.is_Data = (APTR) channel;
+        channel->interrupt.is_Code = (void (*)(void)) audio_int_handler;
+        channel->old_interrupt = SetIntVector(INTB_AUD0 + i, &channel->interrupt);
+
+        // start with the silent front buffer, the interrupt queues the back buffer
+        mix_channel(channel, channel->buffers[0]);
+        channel->back = 1;
+        custom.aud[i].ac_ptr = (UWORD *) channel->buffers[0];
+        custom.aud[i].ac_len = mixer->buffer_bytes / 2;
+        custom.aud[i].ac_per = mixer->period;
+        custom.aud[i].ac_vol = 64;
+    }
+    custom.intena = INTF_SETCLR | intf;
+    custom.dmacon = DMAF_SETCLR | dmaf;
+    mixer->running = TRUE;
+}
+
+/**
+ * Stops the audio DMA of the mixer's channels and restores the interrupts.
+ *
+ * @param mixer the mixer
+ */
+void ratr0_stop_mixer(struct Ratr0Mixer *mixer)
+{
+    UWORD intf = 0, dmaf = 0;
+    if (!mixer->running) return;
+    for (int i = 0; i < mixer->num_channels; i++) {
+        intf |= AUDIO_INTF[i];
+        dmaf |= AUDIO_DMAF[i];
+    }
+    custom.dmacon = dmaf;
+    custom.intena = intf;
+    custom.intreq = intf;
+    for (int i = 0; i < mixer->num_channels; i++) {
+        SetIntVector(INTB_AUD0 + i, mixer->channels[i].old_interrupt);
+    }
+    custom.intena = INTF_SETCLR | (mixer->old_intena & intf);
+    mixer->running = FALSE;
+}
+
+void ratr0_free_mixer(struct Ratr0Mixer *mixer)
+{
+    ratr0_stop_mixer(mixer);
+    if (mixer->buffer_mem) {
+        FreeMem(mixer->buffer_mem, mixer->num_channels * mixer->buffer_bytes * 2);
+        mixer->buffer_mem = NULL;
+    }
+}
+
+/**
+ * Computes the step of a sample that is recorded for the given period:
+ * the ratio of the mixer's period and the sample's period.
+ *
+ * @param mixer the mixer
+ * @param sample_period the period the sample would be played with on a
+ *        hardware channel
+ * @return the 16.16 fixed point step
+ */
+ULONG ratr0_mixer_step(struct Ratr0Mixer *mixer, UWORD sample_period)
+{
+    return ((ULONG) mixer->period << 16) / sample_period;
+}
+
+/**
+ * Starts a sample on a free voice.
+ *
+ * @param mixer the mixer
+ * @param data signed 8 bit sample data, does not need to be in chip memory
+ * @param num_bytes length of the sample
+ * @param step 16.16 fixed point pitch step, MIXER_STEP_1 plays the sample
+ *        at the mixing rate, see ratr0_mixer_step()
+ * @param volume 0-64
+ * @param loop TRUE if the sample should be repeated until the voice is stopped
+ * @return the voice, -1 if all voices are busy
+ */
+int ratr0_play_voice(struct Ratr0Mixer *mixer, const BYTE *data, UWORD num_bytes,
+                     ULONG step, UBYTE volume, BOOL loop)
+{
+    // spread the voices over the channels
+    int num_voices = mixer->num_channels * mixer->voices_per_channel;
+    for (int n = 0; n < num_voices; n++) {
+        int i = (n % mixer->num_channels) * mixer->voices_per_channel + n / mixer->num_channels;
+        struct Ratr0MixerVoice *voice = &mixer->voices[i];
+        if (voice->active) continue;
+        Disable();
+        voice->data = data;
+        voice->end = (ULONG) num_bytes << 16;
+        voice->pos = 0;
+        voice->step = step;
+        voice->volume = volume > 64 ? 64 : volume;
+        voice->loop = loop;
+        voice->active = num_bytes > 0;
+        Enable();
+        return i;
+    }
+    return -1;
+}
+
+/**
+ * Changes the pitch and volume of a playing voice.
+ */
+void ratr0_set_voice(struct Ratr0Mixer *mixer, int voice, ULONG step, UBYTE volume)
+{
+    Disable();
+    mixer->voices[voice].step = step;
+    mixer->voices[voice].volume = volume > 64 ? 64 : volume;
+    Enable();
+}
+
+void ratr0_stop_voice(struct Ratr0Mixer *mixer, int voice)
+{
+    mixer->voices[voice].active = FALSE;
+}
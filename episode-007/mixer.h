@@ -0,0 +1,71 @@
+#pragma once
+#ifndef __MIXER_H__
+#define __MIXER_H__
+
+#include <exec/types.h>
+#include <exec/interrupts.h>
+
+/*
+ * Software mixer: plays more voices than there are hardware channels.
+ *
+ * Every hardware channel used by the mixer plays from 2 buffers in chip
+ * memory. When the audio interrupt of a channel signals that the hardware
+ * has started playing one buffer, the location registers are pointed to
+ * the other buffer, which is then mixed from the channel's voices.
+ * Voice v is mixed into hardware channel v / voices_per_channel.
+ *
+ * The samples of a voice are scaled through a volume table that also
+ * divides by the number of voices per channel, so the sum can't clip
+ * and mixing is a table lookup and a byte add per sample.
+ * The pitch of a voice is a 16.16 fixed point step through its sample
+ * data per output sample, which limits samples to 65535 bytes.
+ */
+#define MIXER_MAX_CHANNELS (4)
+#define MIXER_MAX_VOICES (16)
+#define MIXER_VOLUME_LEVELS (33)  // volume 0-64 in steps of 2
+#define MIXER_STEP_1 (0x10000)    // play at the mixing rate
+
+struct Ratr0MixerVoice {
+    const BYTE *data;
+    ULONG end;     // sample length << 16
+    ULONG pos;     // 16.16 position in the sample
+    ULONG step;    // 16.16 position increment per output sample
+    UBYTE volume;  // 0-64
+    BOOL loop, active;
+};
+
+struct Ratr0Mixer;
+
+struct Ratr0MixerChannel {
+    struct Ratr0Mixer *mixer;
+    UWORD index;       // hardware channel
+    BYTE *buffers[2];  // chip memory
+    UWORD back;        // buffer that is not played, mixed next
+    struct Interrupt interrupt;
+    struct Interrupt *old_interrupt;
+};
+
+struct Ratr0Mixer {
+    UWORD num_channels, voices_per_channel;
+    UWORD buffer_bytes;  // multiple of 4
+    UWORD period;        // of the mixed output
+    BYTE *buffer_mem;
+    struct Ratr0MixerChannel channels[MIXER_MAX_CHANNELS];
+    struct Ratr0MixerVoice voices[MIXER_MAX_VOICES];
+    UWORD old_intena;
+    BOOL running;
+};
+
+extern BOOL ratr0_init_mixer(struct Ratr0Mixer *mixer, UWORD num_channels,
+                             UWORD voices_per_channel, UWORD buffer_bytes, UWORD period);
+extern void ratr0_start_mixer(struct Ratr0Mixer *mixer);
+extern void ratr0_stop_mixer(struct Ratr0Mixer *mixer);
+extern void ratr0_free_mixer(struct Ratr0Mixer *mixer);
+
+extern ULONG ratr0_mixer_step(struct Ratr0Mixer *mixer, UWORD sample_period);
+extern int ratr0_play_voice(struct Ratr0Mixer *mixer, const BYTE *data, UWORD num_bytes,
+                            ULONG step, UBYTE volume, BOOL loop);
+extern void ratr0_set_voice(struct Ratr0Mixer *mixer, int voice, ULONG step, UBYTE volume);
+extern void ratr0_stop_voice(struct Ratr0Mixer *mixer, int voice);
+
+#endif /* __MIXER_H__ */
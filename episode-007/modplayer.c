@@ -0,0 +1,688 @@
+#include <exec/memory.h>
+#include <hardware/custom.h>
+#include <hardware/cia.h>
+#include <hardware/dmabits.h>
+#include <hardware/intbits.h>
+#include <resources/cia.h>
+#include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
+#include <clib/cia_protos.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modplayer.h"
+
+extern struct Custom custom;
+extern struct CIA ciab;
+
+static volatile UWORD *custom_vhposr = (volatile UWORD *) 0xdff006;
+
+#define MOD_SAMPLE_HEADER_BYTES (30)
+#define MOD_PATTERN_NOTES (MOD_NUM_ROWS * MOD_NUM_CHANNELS)
+#define MIN_PERIOD (113)
+#define MAX_PERIOD (856)
+#define MAX_VOLUME (64)
+#define DEFAULT_SPEED (6)
+#define DEFAULT_TEMPO (125)
+
+// periods of C-1 to B-3 for the 16 finetunes
+static const UWORD PERIODS[16][MOD_NUM_NOTES] = {
+    { // finetune 0
+        856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453,
+        428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226,
+        214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113
+    },
+    { // finetune 1
+        850, 802, 757, 715, 673, 635, 600, 566, 534, 504, 477, 450,
+        425, 401, 378, 357, 337, 318, 300, 283, 267, 252, 238, 224,
+        212, 201, 189, 179, 169, 159, 150, 142, 134, 126, 119, 112
+    },
+    { // finetune 2
+        844, 796, 751, 710, 668, 631, 595, 562, 530, 501, 473, 447,
+        422, 398, 376, 355, 334, 315, 298, 281, 265, 250, 237, 223,
+        211, 199, 187, 177, 168, 158, 149, 141, 133, 125, 118, 111
+    },
+    { // finetune 3
+        838, 791, 746, 705, 663, 626, 591, 558, 526, 497, 470, 443,
+        419, 395, 373, 352, 332, 313, 296, 279, 263, 249, 235, 221,
+        209, 198, 186, 176, 166, 157, 148, 140, 132, 124, 117, 111
+    },
+    { // finetune 4
+        832, 785, 740, 700, 659, 622, 587, 554, 523, 494, 466, 440,
+        416, 392, 370, 350, 329, 311, 293, 277, 261, 247, 233, 220,
+        208, 196, 185, 175, 165, 155, 147, 139, 131, 123, 117, 110
+    },
+    { // finetune 5
+        826, 779, 735, 694, 654, 617, 583, 550, 519, 490, 463, 437,
+        413, 390, 367, 347, 327, 309, 291, 275, 259, 245, 231, 218,
+        206, 195, 183, 174, 164, 154, 146, 138, 130, 122, 116, 109
+    },
+    { // finetune 6
+        820, 774, 730, 689, 649, 613, 578, 546, 515, 486, 460, 434,
+        410, 387, 365, 345, 325, 306, 289, 273, 258, 243, 230, 216,
+        205, 193, 182, 172, 163, 153, 145, 137, 129, 122, 115, 108
+    },
+    { // finetune 7
+        814, 768, 724, 685, 645, 608, 574, 542, 511, 483, 456, 431,
+        407, 384, 362, 342, 322, 304, 287, 271, 256, 241, 228, 215,
+        203, 192, 181, 171, 162, 152, 144, 136, 128, 121, 114, 107
+    },
+    { // finetune -8
+        907, 856, 807, 763, 718, 678, 640, 604, 570, 538, 509, 480,
+        453, 428, 404, 381, 359, 339, 320, 302, 285, 269, 254, 239,
+        227, 214, 201, 191, 180, 170, 160, 152, 143, 135, 127, 120
+    },
+    { // finetune -7
+        900, 850, 802, 757, 713, 673, 635, 600, 566, 534, 505, 476,
+        450, 425, 401, 379, 357, 337, 318, 300, 283, 267, 252, 238,
+        225, 212, 200, 189, 179, 168, 159, 150, 142, 134, 126, 119
+    },
+    { // finetune -6
+        894, 844, 796, 752, 708, 668, 631, 595, 562, 530, 501, 473,
+        447, 422, 398, 376, 354, 334, 315, 298, 281, 265, 251, 236,
+        223, 211, 198, 188, 178, 167, 158, 149, 141, 133, 125, 118
+    },
+    { // finetune -5
+        887, 838, 790, 746, 703, 664, 626, 591, 558, 527, 498, 470,
+        444, 419, 395, 373, 351, 332, 313, 295, 279, 263, 249, 234,
+        222, 209, 197, 187, 176, 166, 157, 148, 140, 132, 124, 117
+    },
+    { // finetune -4
+        881, 832, 784, 741, 698, 659, 622, 587, 554, 523, 494, 466,
+        441, 416, 392, 371, 349, 329, 311, 293, 277, 261, 247, 233,
+        220, 208, 196, 185, 175, 165, 155, 147, 139, 131, 124, 116
+    },
+    { // finetune -3
+        875, 826, 779, 736, 693, 654, 617, 582, 550, 519, 491, 463,
+        437, 413, 389, 368, 346, 327, 309, 291, 275, 260, 245, 231,
+        219, 206, 194, 184, 174, 164, 154, 146, 138, 130, 123, 115
+    },
+    { // finetune -2
+        868, 820, 773, 730, 688, 649, 613, 578, 546, 515, 487, 460,
+        434, 410, 387, 365, 344, 325, 306, 289, 273, 258, 243, 229,
+        217, 205, 193, 183, 172, 162, 153, 145, 137, 129, 122, 115
+    },
+    { // finetune -1
+        862, 814, 768, 725, 683, 645, 608, 574, 542, 512, 483, 456,
+        431, 407, 384, 363, 341, 322, 304, 287, 271, 256, 242, 228,
+        216, 203, 191, 181, 171, 161, 152, 144, 136, 128, 121, 114
+    }
+};
+
+// half a sine wave for vibrato and tremolo
+static const UBYTE VIBRATO_TABLE[32] = {
+    0, 24, 49, 74, 97, 120, 141, 161, 180, 197, 212, 224, 235, 244, 250, 253,
+    255, 253, 250, 244, 235, 224, 212, 197, 180, 161, 141, 120, 97, 74, 49, 24
+};
+
+static const UWORD AUDIO_DMAF[] = { DMAF_AUD0, DMAF_AUD1, DMAF_AUD2, DMAF_AUD3 };
+static const char *MOD_IDS[] = { "M.K.", "M!K!", "FLT4", "4CHN" };
+
+static BOOL read_fully(BPTR fh, APTR buffer, LONG size)
+{
+    return size == 0 || Read(fh, buffer, size) == size;
+}
+
+static UWORD get_word(const UBYTE *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+// the note with the nearest period, 0 if there is no period
+static UBYTE period_to_note(UWORD period)
+{
+    if (!period) return 0;
+    int note = 0;
+    for (int i = 1; i < MOD_NUM_NOTES; i++) {
+        if (abs(period - PERIODS[0][i]) < abs(period - PERIODS[0][note])) note = i;
+    }
+    return note + 1;
+}
+
+static BOOL is_4channel_mod(const UBYTE *id)
+{
+    for (int i = 0; i < sizeof(MOD_IDS) / sizeof(MOD_IDS[0]); i++) {
+        if (!memcmp(id, MOD_IDS[i], 4)) return TRUE;
+    }
+    return FALSE;
+}
+
+static void read_sample_headers(struct Ratr0ModPlayer *player,
+                                UBYTE headers[MOD_NUM_SAMPLES][MOD_SAMPLE_HEADER_BYTES])
+{
+    player->sample_mem_size = 0;
+    for (int i = 0; i < MOD_NUM_SAMPLES; i++) {
+        struct Ratr0ModSample *sample = &player->samples[i];
+        // the name takes the first 22 bytes
+        const UBYTE *h = headers[i] + 22;
+        sample->length = get_word(h);
+        sample->finetune = h[2] & 0x0f;
+        sample->volume = h[3] > MAX_VOLUME ? MAX_VOLUME : h[3];
+        sample->repeat_start = get_word(h + 4);
+        sample->repeat_length = get_word(h + 6);
+        if (sample->repeat_start + sample->repeat_length > sample->length) {
+            sample->repeat_length = sample->repeat_start < sample->length ?
+                sample->length - sample->repeat_start : 0;
+        }
+        player->sample_mem_size += (ULONG) sample->length * 2;
+    }
+}
+
+// converts the patterns from the file format to Ratr0ModNote in place
+static void convert_patterns(struct Ratr0ModPlayer *player)
+{
+    UBYTE *p = (UBYTE *) player->patterns;
+    ULONG num_notes = (ULONG) player->num_patterns * MOD_PATTERN_NOTES;
+    for (ULONG i = 0; i < num_notes; i++, p += 4) {
+        struct Ratr0ModNote *note = (struct Ratr0ModNote *) p;
+        UBYTE sample = (p[0] & 0xf0) | (p[2] >> 4);
+        UBYTE effect = p[2] & 0x0f;
+        note->note = period_to_note(((p[0] & 0x0f) << 8) | p[1]);
+        note->sample = sample > MOD_NUM_SAMPLES ? 0 : sample;
+        note->effect = effect;
+        // param stays in p[3]
+    }
+}
+
+// reads the sample data, a truncated last sample is padded with silence
+static void read_samples(BPTR fh, struct Ratr0ModPlayer *player)
+{
+    BYTE *data = player->sample_mem;
+    for (int i = 0; i < MOD_NUM_SAMPLES; i++) {
+        struct Ratr0ModSample *sample = &player->samples[i];
+        LONG size = (LONG) sample->length * 2;
+        sample->data = data;
+        if (size > 0 && Read(fh, data, size) > 0 && sample->repeat_length <= 1) {
+            // a sample without loop repeats its first word, which needs to be silent
+            data[0] = data[1] = 0;
+        }
+        data += size;
+    }
+}
+
+/**
+ * Reads a module from an open file, e.g. an archive entry.
+ *
+ * @param fh file handle positioned at the start of the module
+ * @param filename name for error messages
+ * @param player the player to load the module into
+ * @return TRUE on success
+ */
+BOOL ratr0_load_mod_from(BPTR fh, const char *filename, struct Ratr0ModPlayer *player)
+{
+    UBYTE sample_headers[MOD_NUM_SAMPLES][MOD_SAMPLE_HEADER_BYTES];
+    UBYTE song_info[2], id[4];
+    const char *error = NULL;
+
+    player->patterns = NULL;
+    player->sample_mem = NULL;
+    player->playing = FALSE;
+    player->title[20] = 0;
+    if (!read_fully(fh, player->title, 20) ||
+        !read_fully(fh, sample_headers, sizeof(sample_headers)) ||
+        !read_fully(fh, song_info, 2) ||
+        !read_fully(fh, player->orders, MOD_MAX_ORDERS) ||
+        !read_fully(fh, id, 4)) {
+        error = "truncated header";
+    } else if (!is_4channel_mod(id)) {
+        error = "not a 4 channel module";
+    } else if (song_info[0] == 0 || song_info[0] > MOD_MAX_ORDERS) {
+        error = "invalid song length";
+    }
+    if (!error) {
+        player->song_length = song_info[0];
+        player->restart = song_info[1] < song_info[0] ? song_info[1] : 0;
+        // all orders count, even the ones after the song length
+        player->num_patterns = 0;
+        for (int i = 0; i < MOD_MAX_ORDERS; i++) {
+            if (player->orders[i] >= player->num_patterns) player->num_patterns = player->orders[i] + 1;
+        }
+        player->patterns_size = (ULONG) player->num_patterns * MOD_PATTERN_NOTES * 4;
+        read_sample_headers(player, sample_headers);
+
+        if (!(player->patterns = AllocMem(player->patterns_size, MEMF_ANY))) {
+            error = "not enough memory for the patterns";
+        } else if (!read_fully(fh, player->patterns, player->patterns_size)) {
+            error = "truncated patterns";
+        } else if (player->sample_mem_size &&
+                   !(player->sample_mem = AllocMem(player->sample_mem_size,
+                                                   MEMF_CHIP | MEMF_CLEAR))) {
+            error = "not enough chip memory for the samples";
+        }
+    }
+    if (error) {
+        printf("ratr0_load_mod() error: '%s': %s\n", filename, error);
+        ratr0_free_mod(player);
+        return FALSE;
+    }
+    convert_patterns(player);
+    read_samples(fh, player);
+    return TRUE;
+}
+
+/**
+ * Opens the file and reads it with ratr0_load_mod_from().
+ *
+ * @param filename path to the module
+ * @param player the player to load the module into
+ * @return TRUE on success
+ */
+BOOL ratr0_load_mod(const char *filename, struct Ratr0ModPlayer *player)
+{
+    BPTR fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!fh) {
+        player->patterns = NULL;
+        player->sample_mem = NULL;
+        player->playing = FALSE;
+        printf("ratr0_load_mod() error: file '%s' not found\n", filename);
+        return FALSE;
+    }
+    BOOL result = ratr0_load_mod_from(fh, filename, player);
+    Close(fh);
+    return result;
+}
+
+void ratr0_free_mod(struct Ratr0ModPlayer *player)
+{
+    ratr0_stop_mod(player);
+    if (player->patterns) FreeMem(player->patterns, player->patterns_size);
+    if (player->sample_mem) FreeMem(player->sample_mem, player->sample_mem_size);
+    player->patterns = NULL;
+    player->sample_mem = NULL;
+}
+
+/*
+ * Note triggering
+ */
+static void trigger_note(struct Ratr0ModPlayer *player, int c, UBYTE note)
+{
+    struct Ratr0ModChannel *channel = &player->channels[c];
+    if (!channel->sample || !channel->sample->length) return;
+    channel->note = note;
+    channel->period = channel->periods[note];
+    channel->vibrato_pos = channel->tremolo_pos = 0;
+    player->dma_mask |= AUDIO_DMAF[c];
+}
+
+// starts the one-shot timer, writing the high byte loads and starts it
+static void start_dma_timer(void)
+{
+    ciab.ciatblo = MOD_DMA_WAIT_TICKS & 0xff;
+    ciab.ciatbhi = MOD_DMA_WAIT_TICKS >> 8;
+}
+
+/*
+ * Starts the channels in dma_mask: the DMA of a channel needs to be off
+ * for the new location to be used, after it has been restarted, the loop
+ * registers are set for the DMA to continue with. Instead of waiting in
+ * the interrupt, the DMA is restarted and the loop registers are written
+ * from the CIA-B timer interrupt (see dma_timer_handler()).
+ * Channels of a start that is still in progress are restarted again.
+ */
+static void start_channels(struct Ratr0ModPlayer *player)
+{
+    // the timer interrupt has a higher level, stop it before the update
+    ciab.ciacrb &= ~CIACRBF_START;
+    SetICR(player->ciab_base, CIAICRF_TB);
+
+    UWORD mask = player->dma_mask;
+    player->dma_pending |= mask;
+    custom.dmacon = player->dma_pending;
+    for (int c = 0; c < MOD_NUM_CHANNELS; c++) {
+        if (!(mask & AUDIO_DMAF[c])) continue;
+        struct Ratr0ModChannel *channel = &player->channels[c];
+        struct Ratr0ModSample *sample = channel->sample;
+        UWORD length = sample->repeat_length > 1 ?
+            sample->repeat_start + sample->repeat_length : sample->length;
+        UWORD offset = channel->effect == 0x9 ? channel->offset << 7 : 0;  // in words
+        if (offset >= length) offset = length - 1;
+        custom.aud[c].ac_ptr = (UWORD *) (sample->data + offset * 2);
+        custom.aud[c].ac_len = length - offset;
+    }
+    player->dma_mask = 0;
+    player->dma_restarted = FALSE;
+    start_dma_timer();
+}
+
+/*
+ * CIA-B timer B interrupt: MOD_DMA_WAIT_TICKS after start_channels() has
+ * stopped the channels, their DMA is restarted. After the same time
+ * again, the channels have fetched their start location and the loop
+ * registers are written.
+ */
+static void dma_timer_handler(__reg("a1") struct Ratr0ModPlayer *player)
+{
+    UWORD mask = player->dma_pending;
+    if (!player->dma_restarted) {
+        custom.dmacon = DMAF_SETCLR | mask;
+        player->dma_restarted = TRUE;
+        start_dma_timer();
+        return;
+    }
+    for (int c = 0; c < MOD_NUM_CHANNELS; c++) {
+        if (!(mask & AUDIO_DMAF[c])) continue;
+        struct Ratr0ModSample *sample = player->channels[c].sample;
+        if (sample->repeat_length > 1) {
+            custom.aud[c].ac_ptr = (UWORD *) (sample->data + sample->repeat_start * 2);
+            custom.aud[c].ac_len = sample->repeat_length;
+        } else {
+            custom.aud[c].ac_ptr = (UWORD *) sample->data;
+            custom.aud[c].ac_len = 1;
+        }
+    }
+    player->dma_pending = 0;
+}
+
+/*
+ * Effects
+ */
+static void volume_slide(struct Ratr0ModChannel *channel, UBYTE param)
+{
+    int volume = channel->volume;
+    if (param & 0xf0) volume += param >> 4;
+    else volume -= param & 0x0f;
+    channel->volume = volume < 0 ? 0 : volume > MAX_VOLUME ? MAX_VOLUME : volume;
+}
+
+static void tone_portamento(struct Ratr0ModChannel *channel)
+{
+    if (!channel->target_period) return;
+    if (channel->period < channel->target_period) {
+        channel->period += channel->porta_speed;
+        if (channel->period > channel->target_period) channel->period = channel->target_period;
+    } else if (channel->period > channel->target_period) {
+        channel->period = channel->period - channel->target_period > channel->porta_speed ?
+            channel->period - channel->porta_speed : channel->target_period;
+    }
+    channel->out_period = channel->period;
+}
+
+// sine wave position 0-63, negative in the second half
+static WORD vibrato_value(UBYTE pos, UBYTE depth, UBYTE shift)
+{
+    WORD value = (VIBRATO_TABLE[pos & 31] * depth) >> shift;
+    return pos & 32 ? -value : value;
+}
+
+static void vibrato(struct Ratr0ModChannel *channel)
+{
+    channel->out_period = channel->period +
+        vibrato_value(channel->vibrato_pos, channel->vibrato & 0x0f, 7);
+    channel->vibrato_pos = (channel->vibrato_pos + (channel->vibrato >> 4)) & 63;
+}
+
+static void tremolo(struct Ratr0ModChannel *channel)
+{
+    WORD volume = channel->volume +
+        vibrato_value(channel->tremolo_pos, channel->tremolo & 0x0f, 6);
+    channel->out_volume = volume < 0 ? 0 : volume > MAX_VOLUME ? MAX_VOLUME : volume;
+    channel->tremolo_pos = (channel->tremolo_pos + (channel->tremolo >> 4)) & 63;
+}
+
+static void set_period(struct Ratr0ModChannel *channel, int period)
+{
+    channel->period = period < MIN_PERIOD ? MIN_PERIOD : period > MAX_PERIOD ? MAX_PERIOD : period;
+    channel->out_period = channel->period;
+}
+
+// effects of the first tick of a row
+static void row_effects(struct Ratr0ModPlayer *player, int c)
+{
+    struct Ratr0ModChannel *channel = &player->channels[c];
+    UBYTE param = channel->param, x = param >> 4, y = param & 0x0f;
+
+    switch (channel->effect) {
+    case 0x3:
+        if (param) channel->porta_speed = param;
+        break;
+    case 0x4:
+        if (x) channel->vibrato = (channel->vibrato & 0x0f) | (x << 4);
+        if (y) channel->vibrato = (channel->vibrato & 0xf0) | y;
+        break;
+    case 0x7:
+        if (x) channel->tremolo = (channel->tremolo & 0x0f) | (x << 4);
+        if (y) channel->tremolo = (channel->tremolo & 0xf0) | y;
+        break;
+    case 0x9:
+        if (param) channel->offset = param;
+        break;
+    case 0xb:
+        player->jump_order = param;
+        player->position_jump = TRUE;
+        break;
+    case 0xc:
+        channel->volume = param > MAX_VOLUME ? MAX_VOLUME : param;
+        break;
+    case 0xd:
+        player->break_row = x * 10 + y;
+        if (player->break_row >= MOD_NUM_ROWS) player->break_row = 0;
+        player->pattern_break = TRUE;
+        break;
+    case 0xe:
+        switch (x) {
+        case 0x1: set_period(channel, channel->period - y); break;
+        case 0x2: set_period(channel, channel->period + y); break;
+        case 0x6:
+            if (!y) {
+                channel->loop_row = player->row;
+            } else if (!channel->loop_count) {
+                channel->loop_count = y;
+                player->break_row = channel->loop_row;
+                player->loop_jump = TRUE;
+            } else if (--channel->loop_count) {
+                player->break_row = channel->loop_row;
+                player->loop_jump = TRUE;
+            }
+            break;
+        case 0xa: volume_slide(channel, y << 4); break;
+        case 0xb: volume_slide(channel, y); break;
+        case 0xc: if (!y) channel->volume = 0; break;
+        case 0xe: if (!player->pattern_delay) player->pattern_delay = y; break;
+        default: break;
+        }
+        break;
+    case 0xf:
+        if (param >= 0x20) player->tempo = param;
+        else if (param) player->speed = param;
+        break;
+    default:
+        break;
+    }
+}
+
+// effects of the other ticks of a row
+static void tick_effects(struct Ratr0ModPlayer *player, int c, UBYTE tick)
+{
+    struct Ratr0ModChannel *channel = &player->channels[c];
+    UBYTE param = channel->param, x = param >> 4, y = param & 0x0f;
+
+    switch (channel->effect) {
+    case 0x0:
+        if (param) {
+            UBYTE note = channel->note + (tick % 3 == 1 ? x : tick % 3 == 2 ? y : 0);
+            channel->out_period = channel->periods[note < MOD_NUM_NOTES ? note : MOD_NUM_NOTES - 1];
+        }
+        break;
+    case 0x1: set_period(channel, channel->period - param); break;
+    case 0x2: set_period(channel, channel->period + param); break;
+    case 0x3: tone_portamento(channel); break;
+    case 0x4: vibrato(channel); break;
+    case 0x5:
+        tone_portamento(channel);
+        volume_slide(channel, param);
+        break;
+    case 0x6:
+        vibrato(channel);
+        volume_slide(channel, param);
+        break;
+    case 0x7: tremolo(channel); break;
+    case 0xa: volume_slide(channel, param); break;
+    case 0xe:
+        switch (x) {
+        case 0x9: if (y && tick % y == 0) trigger_note(player, c, channel->note); break;
+        case 0xc: if (tick == y) channel->volume = 0; break;
+        case 0xd:
+            if (tick == y && channel->delayed) {
+                trigger_note(player, c, channel->delayed->note - 1);
+                channel->delayed = NULL;
+            }
+            break;
+        default: break;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void start_row(struct Ratr0ModPlayer *player)
+{
+    struct Ratr0ModNote *note = &player->patterns[
+        (ULONG) player->orders[player->order] * MOD_PATTERN_NOTES + player->row * MOD_NUM_CHANNELS];
+
+    for (int c = 0; c < MOD_NUM_CHANNELS; c++, note++) {
+        struct Ratr0ModChannel *channel = &player->channels[c];
+        channel->effect = note->effect;
+        channel->param = note->param;
+        channel->delayed = NULL;
+        if (note->sample) {
+            channel->sample = &player->samples[note->sample - 1];
+            channel->periods = PERIODS[channel->sample->finetune];
+            channel->volume = channel->sample->volume;
+        }
+        if (note->note && channel->periods) {
+            if (note->effect == 0x3 || note->effect == 0x5) {
+                channel->target_period = channel->periods[note->note - 1];
+            } else if (note->effect == 0xe && (note->param >> 4) == 0xd && (note->param & 0x0f)) {
+                channel->delayed = note;
+            } else {
+                trigger_note(player, c, note->note - 1);
+            }
+        }
+        channel->out_period = channel->period;
+        row_effects(player, c);
+    }
+}
+
+static void next_row(struct Ratr0ModPlayer *player)
+{
+    if (player->loop_jump) {
+        player->row = player->break_row;
+    } else if (player->position_jump || player->pattern_break) {
+        player->order = player->position_jump ? player->jump_order : player->order + 1;
+        player->row = player->pattern_break ? player->break_row : 0;
+    } else if (++player->row == MOD_NUM_ROWS) {
+        player->row = 0;
+        player->order++;
+    }
+    if (player->order >= player->song_length) player->order = player->restart;
+    player->loop_jump = player->position_jump = player->pattern_break = FALSE;
+}
+
+static void mod_tick(struct Ratr0ModPlayer *player)
+{
+    UBYTE row_tick = player->tick % player->speed;
+    if (player->tick == 0) {
+        start_row(player);
+    } else {
+        for (int c = 0; c < MOD_NUM_CHANNELS; c++) {
+            struct Ratr0ModChannel *channel = &player->channels[c];
+            channel->out_period = channel->period;
+            if (row_tick) tick_effects(player, c, row_tick);
+        }
+    }
+    if (player->dma_mask) start_channels(player);
+    for (int c = 0; c < MOD_NUM_CHANNELS; c++) {
+        struct Ratr0ModChannel *channel = &player->channels[c];
+        if (channel->effect != 0x7) channel->out_volume = channel->volume;
+        custom.aud[c].ac_per = channel->out_period;
+        custom.aud[c].ac_vol = channel->out_volume;
+    }
+    if (++player->tick >= player->speed * (player->pattern_delay + 1)) {
+        player->tick = 0;
+        player->pattern_delay = 0;
+        next_row(player);
+    }
+}
+
+/*
+ * VERTB interrupt server: runs as many ticks as the tempo asks for in
+ * this frame. Returns 0 so the servers after it in the chain are called.
+ */
+static ULONG vertb_server(__reg("a1") struct Ratr0ModPlayer *player)
+{
+    UBYTE start_line = *custom_vhposr >> 8;
+    player->tempo_acc += player->tempo * 2;
+    while (player->tempo_acc >= player->tempo_threshold) {
+        player->tempo_acc -= player->tempo_threshold;
+        mod_tick(player);
+    }
+    UBYTE lines = (UBYTE) ((*custom_vhposr >> 8) - start_line);
+    if (lines > player->max_lines) player->max_lines = lines;
+    return 0;
+}
+
+/**
+ * Starts playing the module from the beginning.
+ *
+ * @param player the player with a loaded module
+ * @param is_pal TRUE if the vertical blank rate is 50 Hz, FALSE for 60 Hz
+ * @return FALSE if CIA-B timer B is in use
+ */
+BOOL ratr0_start_mod(struct Ratr0ModPlayer *player, BOOL is_pal)
+{
+    if (player->playing) return TRUE;
+    if (!player->patterns) return FALSE;
+
+    for (int c = 0; c < MOD_NUM_CHANNELS; c++) {
+        memset(&player->channels[c], 0, sizeof(struct Ratr0ModChannel));
+        custom.aud[c].ac_vol = 0;
+    }
+    custom.dmacon = DMAF_AUD0 | DMAF_AUD1 | DMAF_AUD2 | DMAF_AUD3;
+    player->speed = DEFAULT_SPEED;
+    player->tempo = DEFAULT_TEMPO;
+    // ticks happen at tempo * 2 / 5 per second
+    player->tempo_threshold = is_pal ? 5 * 50 : 5 * 60;
+    player->tempo_acc = 0;
+    player->tick = player->row = player->order = 0;
+    player->pattern_delay = 0;
+    player->loop_jump = player->position_jump = player->pattern_break = FALSE;
+    player->dma_mask = player->dma_pending = 0;
+    player->dma_restarted = TRUE;
+    player->max_lines = 0;
+
+    player->ciab_base = OpenResource(CIABNAME);
+    player->dma_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    player->dma_interrupt.is_Node.ln_Pri = 0;
+    player->dma_interrupt.is_Node.ln_Name = "ratr0_modplayer dma";
+    player->dma_interrupt.is_Data = (APTR) player;
+    player->dma_interrupt.is_Code = (void (*)(void)) dma_timer_handler;
+    if (!player->ciab_base || AddICRVector(player->ciab_base, CIAICRB_TB, &player->dma_interrupt)) {
+        puts("ratr0_start_mod() error: CIA-B timer B is in use");
+        return FALSE;
+    }
+    // one-shot mode, the timer is started by start_channels()
+    ciab.ciacrb = (ciab.ciacrb & CIACRBF_ALARM) | CIACRBF_RUNMODE;
+
+    player->vertb_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    player->vertb_interrupt.is_Node.ln_Pri = 0;
+    player->vertb_interrupt.is_Node.ln_Name = "ratr0_modplayer";
+    player->vertb_interrupt.is_Data = (APTR) player;
+    player->vertb_interrupt.is_Code = (void (*)(void)) vertb_server;
+    AddIntServer(INTB_VERTB, &player->vertb_interrupt);
+    player->playing = TRUE;
+    return TRUE;
+}
+
+void ratr0_stop_mod(struct Ratr0ModPlayer *player)
+{
+    if (!player->playing) return;
+    RemIntServer(INTB_VERTB, &player->vertb_interrupt);
+    ciab.ciacrb &= ~CIACRBF_START;
+    RemICRVector(player->ciab_base, CIAICRB_TB, &player->dma_interrupt);
+    custom.dmacon = DMAF_AUD0 | DMAF_AUD1 | DMAF_AUD2 | DMAF_AUD3;
+    for (int c = 0; c < MOD_NUM_CHANNELS; c++) custom.aud[c].ac_vol = 0;
+    player->playing = FALSE;
+}
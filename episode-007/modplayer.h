@@ -0,0 +1,104 @@
+#pragma once
+#ifndef __MODPLAYER_H__
+#define __MODPLAYER_H__
+
+#include <exec/types.h>
+#include <exec/interrupts.h>
+#include <dos/dos.h>
+
+/*
+ * ProTracker MOD player.
+ *
+ * 4 channel, 31 sample modules ("M.K.", "M!K!", "FLT4", "4CHN") are
+ * loaded with the samples in chip memory and the patterns in any memory.
+ * The patterns are converted to note numbers at load time, so a tick
+ * never has to search the period table.
+ *
+ * The player runs from a vertical blank interrupt server. The tempo of
+ * the Fxx command is emulated by accumulating ticks at 2/5 * tempo per
+ * second, which is 1 tick per frame at the default tempo on PAL and the
+ * correct speed on NTSC. A tick writes the period and volume registers
+ * of the 4 channels, rows that start notes additionally stop the DMA of
+ * the channels. The interrupt doesn't wait for the channels to stop: a
+ * one-shot CIA-B timer B interrupt restarts them MOD_DMA_WAIT_TICKS later
+ * and writes the loop registers after the same time again, so the player
+ * needs CIA-B timer B.
+ *
+ * Supported effects: 0-7, 9-F, E1, E2, E6, E9, EA-EE.
+ */
+#define MOD_NUM_SAMPLES (31)
+#define MOD_NUM_CHANNELS (4)
+#define MOD_NUM_ROWS (64)
+#define MOD_NUM_NOTES (36)
+#define MOD_MAX_ORDERS (128)
+// CIA ticks between stopping, restarting and looping the DMA, about 5
+// raster lines
+#define MOD_DMA_WAIT_TICKS (227)
+
+struct Ratr0ModSample {
+    BYTE *data;         // chip memory
+    UWORD length;       // in words
+    UWORD repeat_start, repeat_length;  // in words, no loop if repeat_length <= 1
+    UBYTE finetune;     // 0-15, 8-15 are -8 to -1
+    UBYTE volume;
+};
+
+// pattern entry, converted from the file format at load time
+struct Ratr0ModNote {
+    UBYTE note;    // 1-36, 0 if there is no note
+    UBYTE sample;  // 1-31, 0 if there is no sample
+    UBYTE effect, param;
+};
+
+struct Ratr0ModChannel {
+    struct Ratr0ModSample *sample;
+    const UWORD *periods;  // period table of the sample's finetune
+    struct Ratr0ModNote *delayed;  // note of an EDx command
+    UBYTE note;            // 0-35
+    UBYTE effect, param;
+    UWORD period, target_period;
+    UBYTE volume;
+    UBYTE porta_speed;
+    UBYTE vibrato, vibrato_pos;  // speed << 4 | depth
+    UBYTE tremolo, tremolo_pos;
+    UBYTE offset;          // last sample offset parameter
+    UBYTE loop_row, loop_count;
+    UWORD out_period;      // with arpeggio and vibrato
+    UBYTE out_volume;      // with tremolo
+};
+
+struct Ratr0ModPlayer {
+    char title[21];
+    UBYTE song_length, restart, num_patterns;
+    UBYTE orders[MOD_MAX_ORDERS];
+    struct Ratr0ModNote *patterns;  // MOD_NUM_ROWS * MOD_NUM_CHANNELS notes each
+    ULONG patterns_size;
+    struct Ratr0ModSample samples[MOD_NUM_SAMPLES];
+    BYTE *sample_mem;
+    ULONG sample_mem_size;
+
+    struct Ratr0ModChannel channels[MOD_NUM_CHANNELS];
+    UBYTE speed, row, order;
+    UWORD tick;      // up to speed * (pattern_delay + 1) ticks per row
+    UBYTE pattern_delay;
+    UBYTE break_row, jump_order;
+    BOOL pattern_break, position_jump, loop_jump;
+    UWORD tempo, tempo_acc, tempo_threshold;
+    UWORD dma_mask;  // channels that start a note in this tick
+    UWORD dma_pending;   // channels that are being restarted by the timer
+    BOOL dma_restarted;  // the timer has restarted their DMA
+
+    struct Interrupt vertb_interrupt;
+    struct Interrupt dma_interrupt;  // CIA-B timer B
+    struct Library *ciab_base;
+    BOOL playing;
+    UWORD max_lines;  // longest interrupt in raster lines
+};
+
+extern BOOL ratr0_load_mod_from(BPTR fh, const char *filename, struct Ratr0ModPlayer *player);
+extern BOOL ratr0_load_mod(const char *filename, struct Ratr0ModPlayer *player);
+extern void ratr0_free_mod(struct Ratr0ModPlayer *player);
+extern BOOL ratr0_start_mod(struct Ratr0ModPlayer *player, BOOL is_pal);
+extern void ratr0_stop_mod(struct Ratr0ModPlayer *player);
+
+#endif /* __MODPLAYER_H__ */
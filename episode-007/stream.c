@@ -0,0 +1,258 @@
+#include <exec/memory.h>
+#include <dos/dosextens.h>
+#include <hardware/custom.h>
+#include <hardware/dmabits.h>
+#include <hardware/intbits.h>
+#include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
+
+#include <stdio.h>
+
+#include "stream.h"
+
+extern struct Custom custom;
+
+static const UWORD AUDIO_INTF[] = { INTF_AUD0, INTF_AUD1, INTF_AUD2, INTF_AUD3 };
+static const UWORD AUDIO_DMAF[] = { DMAF_AUD0, DMAF_AUD1, DMAF_AUD2, DMAF_AUD3 };
+
+/*
+ * CreateProc() of Kickstart 1.3 only starts processes from a segment
+ * list, so the process is started from a segment that jumps to its
+ * function. The segment list BPTR points to the next pointer, the code
+ * follows it.
+ */
+struct FakeSegment {
+    ULONG size;
+    BPTR next;
+    UWORD jmp;  // jmp absolute.l
+    APTR code;
+};
+#define JMP_ABS_L (0x4ef9)
+
+// the stream of the process that is being started
+static struct Ratr0Stream *starting_stream;
+
+/*
+ * Reads the next part of the sample into a buffer, the rest of the
+ * buffer is cleared so a short last part is followed by silence.
+ */
+static void fill_buffer(struct Ratr0Stream *stream, UWORD b)
+{
+    BYTE *buffer = stream->buffers[b];
+    ULONG size = stream->remaining < stream->buffer_bytes ?
+        stream->remaining : stream->buffer_bytes;
+    LONG num_read = size ? Read(stream->fh, buffer, size) : 0;
+    if (num_read < 0) num_read = 0;
+    // a read error ends the sample
+    stream->remaining = num_read == size ? stream->remaining - size : 0;
+    for (UWORD i = num_read; i < stream->buffer_bytes; i++) buffer[i] = 0;
+    stream->filled[b] = num_read;
+}
+
+static void stream_process(void)
+{
+    struct Ratr0Stream *stream = starting_stream;
+    BYTE refill_signal = AllocSignal(-1);
+
+    stream->refill_mask = refill_signal == -1 ? 0 : 1L << refill_signal;
+    stream->process = FindTask(NULL);
+    Signal(stream->owner, stream->done_mask);
+    if (refill_signal == -1) return;
+
+    for (;;) {
+        ULONG signals = Wait(stream->refill_mask | SIGBREAKF_CTRL_C);
+        while (stream->refill_pending) {
+            Disable();
+            UWORD b = stream->refill;
+            stream->refill_pending = FALSE;
+            stream->refill_busy = TRUE;
+            Enable();
+            fill_buffer(stream, b);
+            stream->refill_busy = FALSE;
+            Signal(stream->owner, stream->done_mask);
+        }
+        if (signals & SIGBREAKF_CTRL_C) break;
+    }
+    FreeSignal(refill_signal);
+    // the owner may only free the stream after the process is gone
+    Forbid();
+    Signal(stream->owner, stream->done_mask);
+}
+
+/*
+ * Audio interrupt handler: the hardware has latched the queued buffer,
+ * queue the other one, which has finished playing, and have it refilled.
+ */
+static void audio_int_handler(__reg("a1") struct Ratr0Stream *stream)
+{
+    UWORD started = stream->queued, next = started ^ 1;
+    custom.intreq = AUDIO_INTF[stream->channel];
+    if (!stream->filled[started]) {
+        // end of the sample
+        custom.intena = AUDIO_INTF[stream->channel];
+        custom.dmacon = AUDIO_DMAF[stream->channel];
+        stream->playing = FALSE;
+        return;
+    }
+    if (stream->refill_pending || stream->refill_busy) stream->underruns++;
+    custom.aud[stream->channel].ac_ptr = (UWORD *) stream->buffers[next];
+    stream->queued = next;
+    stream->refill = next;
+    stream->refill_pending = TRUE;
+    Signal(stream->process, stream->refill_mask);
+}
+
+/**
+ * Opens the file, allocates the buffers and starts the refill process.
+ * The stream owns the hardware channel until ratr0_free_stream() is called.
+ *
+ * @param stream the stream
+ * @param filename file that contains the samples
+ * @param channel hardware channel 0-3
+ * @param buffer_bytes size of a buffer, even. A buffer needs to play
+ *        longer than a read of that size takes.
+ * @return FALSE if the file can't be opened or there are not enough resources
+ */
+BOOL ratr0_init_stream(struct Ratr0Stream *stream, const char *filename,
+                       UWORD channel, UWORD buffer_bytes)
+{
+    const char *error = NULL;
+    struct FakeSegment *segment;
+
+    stream->fh = 0;
+    stream->buffers[0] = NULL;
+    stream->process = NULL;
+    stream->segment = NULL;
+    stream->done_signal = -1;
+    stream->playing = FALSE;
+    stream->refill_pending = stream->refill_busy = FALSE;
+    stream->channel = channel;
+    stream->buffer_bytes = buffer_bytes;
+    stream->owner = FindTask(NULL);
+    stream->underruns = 0;
+
+    if (channel > 3 || buffer_bytes == 0 || (buffer_bytes & 1)) {
+        error = "invalid parameters";
+    } else if (!(stream->fh = Open((CONST_STRPTR) filename, MODE_OLDFILE))) {
+        error = "file not found";
+    } else if (!(stream->buffers[0] = AllocMem(buffer_bytes * 2, MEMF_CHIP | MEMF_CLEAR))) {
+        error = "not enough chip memory";
+    } else if ((stream->done_signal = AllocSignal(-1)) == -1) {
+        error = "no free signal";
+    } else if (!(segment = stream->segment = AllocMem(sizeof(struct FakeSegment), MEMF_PUBLIC))) {
+        error = "not enough memory";
+    }
+    if (!error) {
+        stream->buffers[1] = stream->buffers[0] + buffer_bytes;
+        stream->done_mask = 1L << stream->done_signal;
+        segment->size = sizeof(struct FakeSegment);
+        segment->next = 0;
+        segment->jmp = JMP_ABS_L;
+        segment->code = (APTR) stream_process;
+        starting_stream = stream;
+        SetSignal(0, stream->done_mask);
+        if (!CreateProc((CONST_STRPTR) "ratr0_stream", STREAM_PROCESS_PRI,
+                        MKBADDR(&segment->next), STREAM_STACK_SIZE)) {
+            error = "can't create the refill process";
+        } else {
+            // wait for the process to pick up starting_stream
+            Wait(stream->done_mask);
+            if (!stream->refill_mask) {
+                stream->process = NULL;
+                error = "no free signal in the refill process";
+            }
+        }
+    }
+    if (error) {
+        printf("ratr0_init_stream() error: '%s': %s\n", filename, error);
+        ratr0_free_stream(stream);
+        return FALSE;
+    }
+    stream->interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    stream->interrupt.is_Node.ln_Pri = 0;
+    stream->interrupt.is_Node.ln_Name = "ratr0 stream";
+    stream->interrupt.is_Data = (APTR) stream;
+    stream->interrupt.is_Code = (void (*)(void)) audio_int_handler;
+    stream->old_intena = custom.intenar;
+    custom.intena = AUDIO_INTF[channel];
+    custom.dmacon = AUDIO_DMAF[channel];
+    stream->old_interrupt = SetIntVector(INTB_AUD0 + channel, &stream->interrupt);
+    return TRUE;
+}
+
+/**
+ * Plays a sample from the stream's file, a playing sample is stopped.
+ * The first buffer is read before this returns.
+ *
+ * @param stream the stream
+ * @param offset position of the signed 8 bit sample data in the file
+ * @param size size of the sample data in bytes
+ * @param period sample period
+ * @param volume 0-64
+ * @return FALSE if the file can't be read
+ */
+BOOL ratr0_play_stream(struct Ratr0Stream *stream, ULONG offset, ULONG size,
+                       UWORD period, UWORD volume)
+{
+    UWORD channel = stream->channel;
+    ratr0_stop_stream(stream);
+    if (Seek(stream->fh, offset, OFFSET_BEGINNING) == -1) {
+        puts("ratr0_play_stream() error: seek failed");
+        return FALSE;
+    }
+    stream->remaining = size;
+    fill_buffer(stream, 0);
+    if (!stream->filled[0]) return FALSE;
+    // if the second buffer isn't filled in time, it plays what it contains
+    stream->filled[1] = stream->buffer_bytes;
+
+    stream->queued = 0;
+    custom.intreq = AUDIO_INTF[channel];
+    custom.aud[channel].ac_ptr = (UWORD *) stream->buffers[0];
+    custom.aud[channel].ac_len = stream->buffer_bytes / 2;
+    custom.aud[channel].ac_per = period;
+    custom.aud[channel].ac_vol = volume;
+    stream->playing = TRUE;
+    // the interrupt of the first buffer queues and fills the second one
+    custom.intena = INTF_SETCLR | AUDIO_INTF[channel];
+    custom.dmacon = DMAF_SETCLR | AUDIO_DMAF[channel];
+    return TRUE;
+}
+
+/**
+ * Stops the channel and waits until the refill process is idle, so the
+ * file can be used again.
+ *
+ * @param stream the stream
+ */
+void ratr0_stop_stream(struct Ratr0Stream *stream)
+{
+    custom.intena = AUDIO_INTF[stream->channel];
+    custom.dmacon = AUDIO_DMAF[stream->channel];
+    custom.aud[stream->channel].ac_vol = 0;
+    stream->playing = FALSE;
+    SetSignal(0, stream->done_mask);
+    while (stream->refill_pending || stream->refill_busy) Wait(stream->done_mask);
+}
+
+void ratr0_free_stream(struct Ratr0Stream *stream)
+{
+    if (stream->process) {
+        ratr0_stop_stream(stream);
+        SetIntVector(INTB_AUD0 + stream->channel, stream->old_interrupt);
+        custom.intena = INTF_SETCLR | (stream->old_intena & AUDIO_INTF[stream->channel]);
+        SetSignal(0, stream->done_mask);
+        Signal(stream->process, SIGBREAKF_CTRL_C);
+        Wait(stream->done_mask);
+        stream->process = NULL;
+    }
+    // the segment list stays with the process until it has ended
+    if (stream->segment) FreeMem(stream->segment, sizeof(struct FakeSegment));
+    if (stream->done_signal != -1) FreeSignal(stream->done_signal);
+    if (stream->buffers[0]) FreeMem(stream->buffers[0], stream->buffer_bytes * 2);
+    if (stream->fh) Close(stream->fh);
+    stream->segment = NULL;
+    stream->done_signal = -1;
+    stream->buffers[0] = NULL;
+    stream->fh = 0;
+}
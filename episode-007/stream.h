@@ -0,0 +1,63 @@
+#pragma once
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#include <exec/types.h>
+#include <exec/interrupts.h>
+#include <exec/tasks.h>
+#include <dos/dos.h>
+
+/*
+ * Streaming voice: plays a sample from a file on one hardware channel
+ * through 2 small buffers in chip memory, so long samples don't need to
+ * be loaded into chip memory at all.
+ *
+ * The audio interrupt of the channel signals that the hardware has
+ * latched one buffer. The handler queues the other buffer, which has
+ * just finished playing, and signals the stream's refill process to read
+ * the next part of the sample into it while the latched buffer plays.
+ * A buffer that has no data left stops the channel when it is latched.
+ *
+ * The refill process is a DOS process, because tasks can't call
+ * dos.library. If a refill isn't done in time the old buffer contents
+ * are played again and the underrun is counted.
+ */
+#define STREAM_PROCESS_PRI (10)    // above the main program, below input.device
+#define STREAM_STACK_SIZE  (4000)
+
+struct Ratr0Stream {
+    BPTR fh;                 // own handle, only used by one process at a time
+    UWORD channel;
+    UWORD buffer_bytes;      // even
+    BYTE *buffers[2];        // chip memory
+    UWORD filled[2];         // bytes of sample data in the buffers
+    UWORD queued;            // buffer in the location registers
+    ULONG remaining;         // bytes left in the file
+
+    // refill requests from the interrupt to the process
+    UWORD refill;
+    volatile BOOL refill_pending, refill_busy;
+    struct Task *process;
+    APTR segment;            // segment list of the process, see stream.c
+    ULONG refill_mask;
+
+    // the task that owns the stream, signalled when a refill is done
+    struct Task *owner;
+    BYTE done_signal;
+    ULONG done_mask;
+
+    struct Interrupt interrupt;
+    struct Interrupt *old_interrupt;
+    UWORD old_intena;
+    volatile BOOL playing;
+    UWORD underruns;
+};
+
+extern BOOL ratr0_init_stream(struct Ratr0Stream *stream, const char *filename,
+                              UWORD channel, UWORD buffer_bytes);
+extern BOOL ratr0_play_stream(struct Ratr0Stream *stream, ULONG offset, ULONG size,
+                              UWORD period, UWORD volume);
+extern void ratr0_stop_stream(struct Ratr0Stream *stream);
+extern void ratr0_free_stream(struct Ratr0Stream *stream);
+
+#endif /* __STREAM_H__ */
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""pack_assets.py - packs asset files into a RATR0 archive (see archive.h)
+
+Entries are named after the file name without the directory. The type and
+the memory type are derived from the file extension, samples go to chip
+memory. Entries are stored in the order given on the command line, which
+should be the order they are loaded in.
+
+usage: pack_assets.py <output.pak> <file> [<file> ...]
+"""
+import argparse
+import os
+import struct
+
+ARCHIVE_ID = b'RATR0PAK'
+ARCHIVE_VERSION = 1
+NAME_LEN = 24
+HEADER_FORMAT = '>8sBBH'
+ENTRY_FORMAT = '>%dsLLBB' % NAME_LEN
+
+MEM_ANY, MEM_CHIP = 0, 1
+# extension -> (type, memory type)
+TYPES = {
+    '.ts': (1, MEM_CHIP),
+    '.lvl': (2, MEM_ANY),
+    '.spr': (3, MEM_CHIP),
+    '.raw8': (4, MEM_CHIP),
+}
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='pack assets into a RATR0 archive')
+    parser.add_argument('outfile')
+    parser.add_argument('files', nargs='+')
+    args = parser.parse_args()
+
+    entries = []
+    for path in args.files:
+        name = os.path.basename(path)
+        if len(name) >= NAME_LEN:
+            raise SystemExit('name too long: %s' % name)
+        with open(path, 'rb') as infile:
+            data = infile.read()
+        entry_type, mem_type = TYPES.get(os.path.splitext(name)[1], (0, MEM_ANY))
+        entries.append((name, data, entry_type, mem_type))
+
+    offset = struct.calcsize(HEADER_FORMAT) + len(entries) * struct.calcsize(ENTRY_FORMAT)
+    index = bytearray()
+    for name, data, entry_type, mem_type in entries:
+        index.extend(struct.pack(ENTRY_FORMAT, name.encode('ascii'), offset, len(data),
+                                 entry_type, mem_type))
+        # keep the entries word aligned
+        offset += (len(data) + 1) & ~1
+
+    with open(args.outfile, 'wb') as outfile:
+        outfile.write(struct.pack(HEADER_FORMAT, ARCHIVE_ID, ARCHIVE_VERSION, 0, len(entries)))
+        outfile.write(index)
+        for name, data, entry_type, mem_type in entries:
+            outfile.write(data)
+            if len(data) & 1:
+                outfile.write(b'\0')
+    print('%s: %d entries, %d bytes' % (args.outfile, len(entries), offset))
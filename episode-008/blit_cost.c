@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include "blit_cost.h"
+
+// DMA cycles per word, indexed by the USEA-USED bits of BLTCON0
+static UBYTE cycles_per_word[16] = {
+    2, 2, 2, 3,  // -, D, C, CD
+    2, 3, 3, 4,  // B, BD, BC, BCD
+    1, 2, 2, 3,  // A, AD, AC, ACD
+    3, 3, 3, 4   // AB, ABD, ABC, ABCD
+};
+
+#define USEC (0x0200)
+#define BLTCON1_LINE (0x0001)
+#define BLTCON1_FILL (0x0018)
+#define LINE_CYCLES_PER_PIXEL (4)
+
+static struct Ratr0BlitBudget *current_budget;
+
+/**
+ * Returns the number of DMA cycles a blit takes.
+ *
+ * @param bltcon0 the BLTCON0 value of the blit
+ * @param bltcon1 the BLTCON1 value of the blit
+ * @param bltsize the BLTSIZE value of the blit
+ * @return the number of DMA cycles
+ */
+ULONG ratr0_blit_cycles(UWORD bltcon0, UWORD bltcon1, UWORD bltsize)
+{
+    ULONG height = bltsize >> 6, width = bltsize & 0x3f;
+    if (height == 0) height = 1024;
+    if (width == 0) width = 64;
+
+    if (bltcon1 & BLTCON1_LINE) return height * LINE_CYCLES_PER_PIXEL;
+
+    ULONG per_word = cycles_per_word[(bltcon0 >> 8) & 0x0f];
+    if ((bltcon1 & BLTCON1_FILL) && !(bltcon0 & USEC)) per_word++;
+    return height * width * per_word;
+}
+
+/**
+ * Computes the blitter cycles that are available per frame for a lores
+ * display.
+ *
+ * @param budget the budget to initialize
+ * @param is_pal TRUE for PAL, FALSE for NTSC
+ * @param num_planes number of bitplanes
+ * @param display_width display width in pixels
+ * @param display_height number of displayed lines
+ */
+void ratr0_init_blit_budget(struct Ratr0BlitBudget *budget, BOOL is_pal,
+                            UWORD num_planes, UWORD display_width,
+                            UWORD display_height)
+{
+    ULONG lines = is_pal ? PAL_LINES_PER_FRAME : NTSC_LINES_PER_FRAME;
+    ULONG bitplane_cycles = (ULONG) (display_width / 16) * num_planes * display_height;
+
+    budget->available = lines * (DMA_CYCLES_PER_LINE - FIXED_DMA_CYCLES_PER_LINE) -
+        bitplane_cycles;
+    budget->frame_cycles = budget->frame_blits = 0;
+    budget->num_frames = budget->frames_over = 0;
+    budget->max_cycles = budget->max_blits = 0;
+    budget->total_cycles = 0;
+}
+
+void ratr0_begin_blit_frame(struct Ratr0BlitBudget *budget)
+{
+    budget->frame_cycles = 0;
+    budget->frame_blits = 0;
+}
+
+void ratr0_end_blit_frame(struct Ratr0BlitBudget *budget)
+{
+    budget->num_frames++;
+    budget->total_cycles += budget->frame_cycles;
+    if (budget->frame_cycles > budget->available) budget->frames_over++;
+    if (budget->frame_cycles > budget->max_cycles) budget->max_cycles = budget->frame_cycles;
+    if (budget->frame_blits > budget->max_blits) budget->max_blits = budget->frame_blits;
+}
+
+void ratr0_print_blit_budget(struct Ratr0BlitBudget *budget)
+{
+    ULONG avg = budget->num_frames ? budget->total_cycles / budget->num_frames : 0;
+    printf("Blitter budget: %lu cycles per frame\n", budget->available);
+    printf("frames: %lu, over budget: %lu\n", budget->num_frames, budget->frames_over);
+    printf("average: %lu cycles (%lu%%)\n", avg, avg * 100 / budget->available);
+    printf("peak: %lu cycles (%lu%%), max. blits per frame: %lu\n",
+           budget->max_cycles, budget->max_cycles * 100 / budget->available,
+           budget->max_blits);
+}
+
+void ratr0_set_blit_budget(struct Ratr0BlitBudget *budget)
+{
+    current_budget = budget;
+}
+
+void ratr0_account_blit(UWORD bltcon0, UWORD bltcon1, UWORD bltsize)
+{
+    if (current_budget) {
+        current_budget->frame_cycles += ratr0_blit_cycles(bltcon0, bltcon1, bltsize);
+        current_budget->frame_blits++;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef __BLIT_COST_H__
+#define __BLIT_COST_H__
+
+#include <exec/types.h>
+
+/*
+ * Blitter DMA cost model and per frame budget.
+ *
+ * The cost of a blit is counted in DMA cycles (one cycle = 2 lores pixels,
+ * 227 per scan line) and follows the cycle sequences of the Hardware
+ * Reference Manual: the number of cycles per word depends on the channels
+ * enabled in BLTCON0, fill mode adds a cycle per word if channel C is not
+ * used, and line mode takes 4 cycles per pixel.
+ *
+ * The budget is the number of cycles per frame that is left for the
+ * blitter after refresh, disk, audio, sprite and bitplane DMA. It is an
+ * upper bound: CPU accesses to chip memory are not taken into account.
+ */
+#define DMA_CYCLES_PER_LINE (227)
+#define PAL_LINES_PER_FRAME (313)
+#define NTSC_LINES_PER_FRAME (263)
+// refresh (4), disk (3), audio (4) and sprite (16) slots
+#define FIXED_DMA_CYCLES_PER_LINE (27)
+
+extern ULONG ratr0_blit_cycles(UWORD bltcon0, UWORD bltcon1, UWORD bltsize);
+
+struct Ratr0BlitBudget {
+    ULONG available;  // blitter cycles per frame
+    ULONG frame_cycles, frame_blits;  // current frame
+
+    // statistics over all frames
+    ULONG num_frames, frames_over;
+    ULONG max_cycles, max_blits;
+    ULONG total_cycles;
+};
+
+extern void ratr0_init_blit_budget(struct Ratr0BlitBudget *budget, BOOL is_pal,
+                                   UWORD num_planes, UWORD display_width,
+                                   UWORD display_height);
+extern void ratr0_begin_blit_frame(struct Ratr0BlitBudget *budget);
+extern void ratr0_end_blit_frame(struct Ratr0BlitBudget *budget);
+extern void ratr0_print_blit_budget(struct Ratr0BlitBudget *budget);
+
+/*
+ * Blit functions report every blit they issue with ratr0_account_blit().
+ * The cost is added to the budget that was set with ratr0_set_blit_budget(),
+ * with no budget set (the default), accounting is switched off.
+ */
+extern void ratr0_set_blit_budget(struct Ratr0BlitBudget *budget);
+extern void ratr0_account_blit(UWORD bltcon0, UWORD bltcon1, UWORD bltsize);
+
+#endif /* __BLIT_COST_H__ */
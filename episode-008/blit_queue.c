@@ -0,0 +1,269 @@
+#include <hardware/custom.h>
+#include <hardware/intbits.h>
+#include <clib/exec_protos.h>
+#include <clib/graphics_protos.h>
+
+#include "blit_queue.h"
+#include "blit_cost.h"
+
+extern struct Custom custom;
+
+#define BLIT_QUEUE_MASK (BLIT_QUEUE_SIZE - 1)
+
+static struct Ratr0BlitCommand queue[BLIT_QUEUE_SIZE];
+// head is only written by the enqueueing task, tail only by the interrupt
+static volatile UWORD queue_head, queue_tail;
+static volatile BOOL blitter_busy;
+
+// last values written to the blitter registers
+static struct Ratr0BlitState shadow;
+static BOOL shadow_valid;
+
+// state of the current batch
+static struct Ratr0BlitState batch_state;
+static BOOL batch_started;
+
+// control words of the last enqueued blit for the cost accounting
+static UWORD last_bltcon0, last_bltcon1;
+
+static struct Interrupt blit_interrupt;
+static struct Interrupt *old_blit_interrupt;
+static UWORD old_intena;
+
+static void apply_state(struct Ratr0BlitState *state)
+{
+    if (!shadow_valid) {
+        custom.bltcon0 = shadow.bltcon0 = state->bltcon0;
+        custom.bltcon1 = shadow.bltcon1 = state->bltcon1;
+        custom.bltafwm = shadow.bltafwm = state->bltafwm;
+        custom.bltalwm = shadow.bltalwm = state->bltalwm;
+        custom.bltamod = shadow.bltamod = state->bltamod;
+        custom.bltdmod = shadow.bltdmod = state->bltdmod;
+        shadow_valid = TRUE;
+        return;
+    }
+    if (state->bltcon0 != shadow.bltcon0) custom.bltcon0 = shadow.bltcon0 = state->bltcon0;
+    if (state->bltcon1 != shadow.bltcon1) custom.bltcon1 = shadow.bltcon1 = state->bltcon1;
+    if (state->bltafwm != shadow.bltafwm) custom.bltafwm = shadow.bltafwm = state->bltafwm;
+    if (state->bltalwm != shadow.bltalwm) custom.bltalwm = shadow.bltalwm = state->bltalwm;
+    if (state->bltamod != shadow.bltamod) custom.bltamod = shadow.bltamod = state->bltamod;
+    if (state->bltdmod != shadow.bltdmod) custom.bltdmod = shadow.bltdmod = state->bltdmod;
+}
+
+static void start_blit(struct Ratr0BlitCommand *cmd)
+{
+    if (!(cmd->flags & BLIT_CMD_SAME_STATE)) apply_state(&cmd->state);
+    custom.bltapt = cmd->bltapt;
+    custom.bltdpt = cmd->bltdpt;
+    // writing bltsize starts the blit
+    custom.bltsize = cmd->bltsize;
+}
+
+/*
+ * Blitter finished interrupt: start the next queued blit or mark the
+ * blitter as idle if there is nothing left to do.
+ */
+void blit_int_handler(void)
+{
+    // clear the request first, the next blit will raise it again
+    custom.intreq = INTF_BLIT;
+    if (queue_tail != queue_head) {
+        start_blit(&queue[queue_tail]);
+        queue_tail = (queue_tail + 1) & BLIT_QUEUE_MASK;
+    } else {
+        blitter_busy = FALSE;
+    }
+}
+
+/**
+ * Installs the blitter interrupt handler. The caller is expected to own the
+ * blitter (OwnBlitter()) while the queue is installed.
+ */
+void ratr0_blit_queue_install(void)
+{
+    queue_head = queue_tail = 0;
+    blitter_busy = FALSE;
+    ratr0_blit_queue_invalidate();
+
+    old_intena = custom.intenar;
+    // disable and clear outstanding blitter interrupts
+    custom.intena = INTF_BLIT;
+    custom.intreq = INTF_BLIT;
+
+    blit_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    blit_interrupt.is_Node.ln_Pri = 0;
+    blit_interrupt.is_Node.ln_Name = "ratr0_blit_queue";
+    blit_interrupt.is_Data = 0;
+    blit_interrupt.is_Code = (APTR) blit_int_handler;
+    old_blit_interrupt = SetIntVector(INTB_BLIT, &blit_interrupt);
+
+    custom.intena = INTF_SETCLR | INTF_BLIT;
+}
+
+/**
+ * Waits for all outstanding blits and restores the previous blitter
+ * interrupt handler.
+ */
+void ratr0_blit_queue_uninstall(void)
+{
+    ratr0_blit_queue_flush();
+    custom.intena = INTF_BLIT;
+    custom.intreq = INTF_BLIT;
+    SetIntVector(INTB_BLIT, old_blit_interrupt);
+    if (old_intena & INTF_BLIT) custom.intena = INTF_SETCLR | INTF_BLIT;
+}
+
+/**
+ * Forget the shadowed register values. Needs to be called after the
+ * blitter registers were written by anything else than the queue, e.g.
+ * a blit that was issued directly. Only call this when the queue is empty.
+ */
+void ratr0_blit_queue_invalidate(void)
+{
+    shadow_valid = FALSE;
+    batch_started = FALSE;
+}
+
+/**
+ * Adds a blit to the queue. If the blitter is idle, the blit is started
+ * right away, otherwise it will be started by the interrupt handler.
+ * Only waits if the queue is full.
+ *
+ * @param cmd the blit to perform, it is copied into the queue
+ */
+void ratr0_blit_queue_enqueue(struct Ratr0BlitCommand *cmd)
+{
+    UWORD next_head = (queue_head + 1) & BLIT_QUEUE_MASK;
+
+    // a blit with its own state ends the current batch, the next blit of
+    // the batch has to set up the registers again
+    if (!(cmd->flags & BLIT_CMD_SAME_STATE)) {
+        batch_started = FALSE;
+        last_bltcon0 = cmd->state.bltcon0;
+        last_bltcon1 = cmd->state.bltcon1;
+    }
+    ratr0_account_blit(last_bltcon0, last_bltcon1, cmd->bltsize);
+
+    // queue full, wait for the blitter to catch up
+    while (next_head == queue_tail) ;
+
+    Disable();
+    if (!blitter_busy) {
+        // the blitter might still be busy with a blit that was not queued
+        WaitBlit();
+        // and its interrupt would be taken for the end of this one
+        custom.intreq = INTF_BLIT;
+        blitter_busy = TRUE;
+        start_blit(cmd);
+    } else {
+        queue[queue_head] = *cmd;
+        queue_head = next_head;
+    }
+    Enable();
+}
+
+/**
+ * Fence: returns after all queued blits were performed.
+ */
+void ratr0_blit_queue_flush(void)
+{
+    while (blitter_busy) ;
+}
+
+/**
+ * Starts a batch of blits that share the same register state.
+ *
+ * @param state the invariant register values, they are copied
+ */
+void ratr0_blit_batch_begin(struct Ratr0BlitState *state)
+{
+    batch_state = *state;
+    batch_started = FALSE;
+}
+
+/**
+ * Adds a blit to the current batch. Only the first blit of a batch
+ * sets up the invariant registers.
+ */
+void ratr0_blit_batch_add(UBYTE *bltapt, UBYTE *bltdpt, UWORD bltsize)
+{
+    struct Ratr0BlitCommand cmd;
+    if (batch_started) {
+        cmd.flags = BLIT_CMD_SAME_STATE;
+    } else {
+        cmd.state = batch_state;
+        cmd.flags = 0;
+    }
+    cmd.bltapt = bltapt;
+    cmd.bltdpt = bltdpt;
+    cmd.bltsize = bltsize;
+    ratr0_blit_queue_enqueue(&cmd);
+    batch_started = TRUE;
+}
+
+// Tile blits: enable channels A and D, LF => D = A, ascending
+static void init_tile_state(struct Ratr0BlitState *state, int dmod, struct Ratr0TileSheet *tileset)
+{
+    state->bltcon0 = 0x9f0;
+    state->bltcon1 = 0;
+    state->bltafwm = 0xffff;
+    state->bltalwm = 0xffff;
+    state->bltamod = (tileset->header.num_tiles_h - 1) * 2;
+    state->bltdmod = dmod;
+}
+
+static UBYTE *tile_src(struct Ratr0TileSheet *tileset, int tx, int ty)
+{
+    // map tilenum to offset
+    int tile_row_bytes = tileset->header.num_tiles_h * 2 * tileset->header.tile_width * tileset->header.bmdepth;
+    return tileset->imgdata + ty * tile_row_bytes + tx * 2;
+}
+
+static UWORD tile_bltsize(struct Ratr0TileSheet *tileset)
+{
+    int height = tileset->header.tile_height * tileset->header.bmdepth;
+    int num_words = 1;
+    return (UWORD) (height << 6) | (num_words & 0x3f);
+}
+
+/**
+ * Queued version of ratr0_blit_tile(), tx, ty are tileset coordinates
+ */
+void ratr0_queue_blit_tile(UBYTE *dst, int dmod, struct Ratr0TileSheet *tileset, int tx, int ty)
+{
+    struct Ratr0BlitCommand cmd;
+    init_tile_state(&cmd.state, dmod, tileset);
+    cmd.bltapt = tile_src(tileset, tx, ty);
+    cmd.bltdpt = dst;
+    cmd.bltsize = tile_bltsize(tileset);
+    cmd.flags = 0;
+    ratr0_blit_queue_enqueue(&cmd);
+}
+
+/**
+ * Starts a batch of tile blits into a destination with modulo dmod.
+ */
+void ratr0_begin_tile_batch(int dmod, struct Ratr0TileSheet *tileset)
+{
+    struct Ratr0BlitState state;
+    init_tile_state(&state, dmod, tileset);
+    ratr0_blit_batch_begin(&state);
+}
+
+/**
+ * Adds a tile to the batch started with ratr0_begin_tile_batch(), tx, ty are
+ * tileset coordinates
+ */
+void ratr0_batch_blit_tile(UBYTE *dst, struct Ratr0TileSheet *tileset, int tx, int ty)
+{
+    ratr0_blit_batch_add(tile_src(tileset, tx, ty), dst, tile_bltsize(tileset));
+}
+
+/**
+ * Adds a tile to the batch started with ratr0_begin_tile_batch(), index is
+ * the tile number + 1 as stored in the level data
+ */
+void ratr0_batch_blit_tile_by_index(UBYTE *dst, struct Ratr0TileSheet *tileset, UBYTE index)
+{
+    ratr0_blit_batch_add(tileset->tile_src[index], dst, tileset->tile_bltsize);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef __BLIT_QUEUE_H__
+#define __BLIT_QUEUE_H__
+
+#include "tilesheet.h"
+
+/*
+ * Asynchronous blitter command queue.
+ *
+ * Instead of busy-waiting on WaitBlit() before every blit, callers put
+ * their blits into a ring buffer and return immediately. The blitter
+ * finished interrupt (INTB_BLIT) starts the next queued blit, so the CPU
+ * is free while the blitter works through the queue.
+ * Before the frame is flipped, ratr0_blit_queue_flush() needs to be called
+ * to make sure that all queued blits have completed.
+ *
+ * The queue keeps a shadow copy of the blitter registers that usually
+ * stay the same between blits and only writes the ones that changed.
+ * Pointers and bltsize are always written, because the blitter modifies the
+ * pointer registers and bltsize starts the blit.
+ */
+
+// register values that typically stay the same over a series of blits
+struct Ratr0BlitState {
+    UWORD bltcon0, bltcon1;
+    UWORD bltafwm, bltalwm;
+    UWORD bltamod, bltdmod;
+};
+
+// the blit uses the same state as the blit before, no need to compare
+#define BLIT_CMD_SAME_STATE (1)
+
+// a single queued blit
+struct Ratr0BlitCommand {
+    struct Ratr0BlitState state;
+    UBYTE *bltapt, *bltdpt;
+    UWORD bltsize;
+    UWORD flags;
+};
+
+// must be a power of 2
+#define BLIT_QUEUE_SIZE (64)
+
+extern void ratr0_blit_queue_install(void);
+extern void ratr0_blit_queue_uninstall(void);
+extern void ratr0_blit_queue_invalidate(void);
+extern void ratr0_blit_queue_enqueue(struct Ratr0BlitCommand *cmd);
+extern void ratr0_blit_queue_flush(void);
+
+/*
+ * Batch API: set up the invariant state once with ratr0_blit_batch_begin()
+ * and then only stream source pointer, destination pointer and size.
+ */
+extern void ratr0_blit_batch_begin(struct Ratr0BlitState *state);
+extern void ratr0_blit_batch_add(UBYTE *bltapt, UBYTE *bltdpt, UWORD bltsize);
+
+extern void ratr0_queue_blit_tile(UBYTE *dst, int dmod, struct Ratr0TileSheet *tileset, int tx, int ty);
+extern void ratr0_begin_tile_batch(int dmod, struct Ratr0TileSheet *tileset);
+extern void ratr0_batch_blit_tile(UBYTE *dst, struct Ratr0TileSheet *tileset, int tx, int ty);
+extern void ratr0_batch_blit_tile_by_index(UBYTE *dst, struct Ratr0TileSheet *tileset, UBYTE index);
+
+#endif /* __BLIT_QUEUE_H__ */
@@ -0,0 +1,192 @@
+#include <ahpc_registers.h>
+#include "copper_builder.h"
+
+// value slots of dropped instructions point here, large enough for
+// 32 color slots
+#define SCRATCH_WORDS (64)
+static UWORD scratch[SCRATCH_WORDS];
+
+#define COPPER_WAIT_MASK (0xfffe)
+#define COPPER_SKIP_MASK (0xffff)
+// end of line 255, the last position before the vertical counter wraps
+// to 0 in its low 8 bits
+#define COPPER_WRAP_VPOS (255)
+#define COPPER_WRAP_HPOS (0xde)
+
+static UWORD *emit(struct Ratr0CopperBuilder *builder, UWORD w0, UWORD w1)
+{
+    if (builder->overflow || builder->num_words + 2 > builder->max_words) {
+        builder->overflow = TRUE;
+        return scratch;
+    }
+    UWORD *instr = &builder->list[builder->num_words];
+    instr[0] = w0;
+    instr[1] = w1;
+    builder->num_words += 2;
+    return instr;
+}
+
+/**
+ * Starts a new copper list.
+ *
+ * @param builder the builder
+ * @param list chip memory buffer
+ * @param max_words size of the buffer in words
+ */
+void ratr0_copper_begin(struct Ratr0CopperBuilder *builder, UWORD *list,
+                        UWORD max_words)
+{
+    builder->list = list;
+    builder->num_words = 0;
+    builder->max_words = max_words;
+    builder->overflow = FALSE;
+    builder->wrapped = FALSE;
+}
+
+/**
+ * Emits a MOVE instruction.
+ *
+ * @param builder the builder
+ * @param reg custom chip register offset, e.g. BPLCON1
+ * @param value the value to write
+ * @return slot of the value
+ */
+UWORD *ratr0_copper_move(struct Ratr0CopperBuilder *builder, UWORD reg, UWORD value)
+{
+    return emit(builder, reg, value) + 1;
+}
+
+/*
+ * The copper compares only the low 8 bits of the line, so lines past 255
+ * need a WAIT for the end of line 255 first.
+ */
+static void wrap_lines(struct Ratr0CopperBuilder *builder, UWORD vpos)
+{
+    if (vpos > COPPER_WRAP_VPOS && !builder->wrapped) {
+        emit(builder, (COPPER_WRAP_VPOS << 8) | COPPER_WRAP_HPOS | 1, COPPER_WAIT_MASK);
+        builder->wrapped = TRUE;
+    }
+}
+
+/**
+ * Emits a WAIT instruction for a beam position. Lines are counted from
+ * the top of the frame and can be larger than 255.
+ *
+ * @param builder the builder
+ * @param vpos the line
+ * @param hpos the horizontal position, bit 0 is ignored
+ */
+void ratr0_copper_wait(struct Ratr0CopperBuilder *builder, UWORD vpos, UWORD hpos)
+{
+    wrap_lines(builder, vpos);
+    emit(builder, ((vpos & 0xff) << 8) | (hpos & 0xfe) | 1, COPPER_WAIT_MASK);
+}
+
+/**
+ * Emits a SKIP instruction: the next instruction is skipped if the beam
+ * is at or past the position.
+ */
+void ratr0_copper_skip(struct Ratr0CopperBuilder *builder, UWORD vpos, UWORD hpos)
+{
+    wrap_lines(builder, vpos);
+    emit(builder, ((vpos & 0xff) << 8) | (hpos & 0xfe) | 1, COPPER_SKIP_MASK);
+}
+
+/**
+ * Terminates the list with a WAIT for an impossible position.
+ *
+ * @return FALSE if the buffer was too small
+ */
+BOOL ratr0_copper_end(struct Ratr0CopperBuilder *builder)
+{
+    emit(builder, 0xffff, 0xfffe);
+    return !builder->overflow;
+}
+
+/**
+ * Emits the two MOVEs of a pointer register pair.
+ *
+ * @param builder the builder
+ * @param reg_high offset of the high word register, e.g. BPL1PTH
+ * @param addr initial pointer value
+ * @return the pointer slot
+ */
+Ratr0CopperPtrSlot ratr0_copper_ptr(struct Ratr0CopperBuilder *builder,
+                                    UWORD reg_high, APTR addr)
+{
+    UWORD *slot = ratr0_copper_move(builder, reg_high, ((ULONG) addr >> 16) & 0xffff);
+    ratr0_copper_move(builder, reg_high + 2, (ULONG) addr & 0xffff);
+    // a dropped low word would leave the slot without its second half
+    return builder->overflow ? scratch + 1 : slot;
+}
+
+/**
+ * Emits MOVEs for a range of color registers.
+ *
+ * @param builder the builder
+ * @param first first color register number
+ * @param num_colors number of colors
+ * @param colors initial values, can be NULL for black
+ * @return slot of the first color, the next colors are every 2 words
+ */
+UWORD *ratr0_copper_colors(struct Ratr0CopperBuilder *builder, UWORD first,
+                           UWORD num_colors, UWORD *colors)
+{
+    UWORD *slot = scratch;
+    for (int i = 0; i < num_colors; i++) {
+        UWORD *s = ratr0_copper_move(builder, COLOR00 + ((first + i) << 1),
+                                     colors ? colors[i] : 0);
+        if (i == 0) slot = s;
+    }
+    return builder->overflow ? scratch : slot;
+}
+
+/**
+ * Emits the bitplane pointers BPL1PT to BPLnPT, initially 0.
+ */
+void ratr0_copper_bitplanes(struct Ratr0CopperBuilder *builder,
+                            struct Ratr0CopperBitplanes *slots,
+                            UWORD num_planes)
+{
+    slots->num_planes = num_planes;
+    for (int i = 0; i < num_planes; i++) {
+        slots->planes[i] = ratr0_copper_ptr(builder, BPL1PTH + (i << 2), NULL);
+    }
+}
+
+/**
+ * Emits the 8 sprite pointers.
+ *
+ * @param builder the builder
+ * @param slots receives COPPER_NUM_SPRITES pointer slots
+ * @param sprite_data initial sprite data pointers
+ */
+void ratr0_copper_sprites(struct Ratr0CopperBuilder *builder,
+                          Ratr0CopperPtrSlot *slots, APTR *sprite_data)
+{
+    for (int i = 0; i < COPPER_NUM_SPRITES; i++) {
+        slots[i] = ratr0_copper_ptr(builder, SPR0PTH + (i << 2), sprite_data[i]);
+    }
+}
+
+/**
+ * Points the bitplane slots to consecutive planes.
+ *
+ * @param slots the bitplane slots
+ * @param first_plane address of the first plane
+ * @param plane_offset distance between the planes in bytes, the row size for
+ *        interleaved bitmaps
+ */
+void ratr0_set_copper_bitplanes(struct Ratr0CopperBitplanes *slots,
+                                UBYTE *first_plane, ULONG plane_offset)
+{
+    for (int i = 0; i < slots->num_planes; i++) {
+        RATR0_SET_COPPER_PTR(slots->planes[i], first_plane);
+        first_plane += plane_offset;
+    }
+}
+
+void ratr0_set_copper_colors(UWORD *slot, UWORD num_colors, UWORD *colors)
+{
+    for (int i = 0; i < num_colors; i++) slot[i << 1] = colors[i];
+}
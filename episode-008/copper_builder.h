@@ -0,0 +1,66 @@
+#pragma once
+#ifndef __COPPER_BUILDER_H__
+#define __COPPER_BUILDER_H__
+
+#include <exec/types.h>
+
+/*
+ * Copper list builder.
+ *
+ * Emits MOVE, WAIT and SKIP instructions into a chip memory buffer. The
+ * functions that emit instructions with values that change at runtime
+ * return slots: pointers to the value words in the list, so updating the
+ * list is a store through the slot instead of an index computation.
+ *
+ * Running out of buffer space sets the overflow flag, further
+ * instructions are dropped and their slots point to a scratch area.
+ * ratr0_copper_end() reports the overflow.
+ */
+struct Ratr0CopperBuilder {
+    UWORD *list;
+    UWORD num_words, max_words;
+    BOOL overflow;
+    BOOL wrapped;  // a WAIT for a line past 255 was emitted
+};
+
+// Slot of a pointer register pair (BPLxPTH/BPLxPTL, SPRxPTH/SPRxPTL):
+// points to the high word value, the low word value is 2 words further
+typedef UWORD *Ratr0CopperPtrSlot;
+
+#define RATR0_SET_COPPER_PTR(slot, addr) \
+    do { \
+        (slot)[0] = ((ULONG) (addr) >> 16) & 0xffff; \
+        (slot)[2] = (ULONG) (addr) & 0xffff; \
+    } while (0)
+
+#define COPPER_MAX_BITPLANES (6)
+#define COPPER_NUM_SPRITES (8)
+
+struct Ratr0CopperBitplanes {
+    Ratr0CopperPtrSlot planes[COPPER_MAX_BITPLANES];
+    UWORD num_planes;
+};
+
+extern void ratr0_copper_begin(struct Ratr0CopperBuilder *builder, UWORD *list,
+                               UWORD max_words);
+extern UWORD *ratr0_copper_move(struct Ratr0CopperBuilder *builder, UWORD reg,
+                                UWORD value);
+extern void ratr0_copper_wait(struct Ratr0CopperBuilder *builder, UWORD vpos, UWORD hpos);
+extern void ratr0_copper_skip(struct Ratr0CopperBuilder *builder, UWORD vpos, UWORD hpos);
+extern BOOL ratr0_copper_end(struct Ratr0CopperBuilder *builder);
+
+extern Ratr0CopperPtrSlot ratr0_copper_ptr(struct Ratr0CopperBuilder *builder,
+                                           UWORD reg_high, APTR addr);
+extern UWORD *ratr0_copper_colors(struct Ratr0CopperBuilder *builder, UWORD first,
+                                  UWORD num_colors, UWORD *colors);
+extern void ratr0_copper_bitplanes(struct Ratr0CopperBuilder *builder,
+                                   struct Ratr0CopperBitplanes *slots,
+                                   UWORD num_planes);
+extern void ratr0_copper_sprites(struct Ratr0CopperBuilder *builder,
+                                 Ratr0CopperPtrSlot *slots, APTR *sprite_data);
+
+extern void ratr0_set_copper_bitplanes(struct Ratr0CopperBitplanes *slots,
+                                       UBYTE *first_plane, ULONG plane_offset);
+extern void ratr0_set_copper_colors(UWORD *slot, UWORD num_colors, UWORD *colors);
+
+#endif /* __COPPER_BUILDER_H__ */
@@ -0,0 +1,86 @@
+#include <hardware/custom.h>
+#include <hardware/intbits.h>
+#include <exec/memory.h>
+#include <clib/exec_protos.h>
+
+#include "copper_lists.h"
+
+extern struct Custom custom;
+
+// VPOSR and VHPOSR read as a single long word, V8 is in bit 16
+static volatile ULONG *custom_vposr = (volatile ULONG *) 0xdff004;
+
+// lines after the COP1LC reload at line 0 in which the VERTB server might
+// not have counted the vertical blank yet
+#define SWAP_WINDOW_LINES (20)
+
+/**
+ * Allocates both lists in chip memory as copies of a template. The first
+ * ratr0_swap_copper_lists() starts the copper on the first list.
+ *
+ * @param copper the copper lists
+ * @param template complete copper list, including the end marker, or NULL
+ *        if the lists are built in place (see copper_builder.h)
+ * @param num_words size of a list in words
+ * @param sched frame scheduler that counts the vertical blanks
+ * @return FALSE if there is not enough chip memory
+ */
+BOOL ratr0_init_copper_lists(struct Ratr0CopperLists *copper,
+                             UWORD *template, UWORD num_words,
+                             struct Ratr0FrameScheduler *sched)
+{
+    copper->size = num_words * sizeof(UWORD);
+    copper->lists[0] = AllocMem(copper->size, MEMF_CHIP);
+    copper->lists[1] = AllocMem(copper->size, MEMF_CHIP);
+    if (!copper->lists[0] || !copper->lists[1]) {
+        ratr0_free_copper_lists(copper);
+        return FALSE;
+    }
+    if (template) {
+        CopyMem(template, copper->lists[0], copper->size);
+        CopyMem(template, copper->lists[1], copper->size);
+    }
+    copper->back = 0;
+    copper->sched = sched;
+    copper->swap_vblank = sched->vblanks;
+    return TRUE;
+}
+
+/**
+ * Frees the lists. The copper needs to be pointed to a different list
+ * before.
+ */
+void ratr0_free_copper_lists(struct Ratr0CopperLists *copper)
+{
+    for (int i = 0; i < 2; i++) {
+        if (copper->lists[i]) FreeMem(copper->lists[i], copper->size);
+        copper->lists[i] = NULL;
+    }
+}
+
+/**
+ * Returns the list to write the next frame into. Sleeps on the frame
+ * scheduler's signal if the copper has not switched to the list of the
+ * last swap yet.
+ */
+UWORD *ratr0_copper_back_list(struct Ratr0CopperLists *copper)
+{
+    struct Ratr0FrameScheduler *sched = copper->sched;
+    while ((LONG) (sched->vblanks - copper->swap_vblank) <= 0) Wait(sched->signal_mask);
+    return copper->lists[copper->back];
+}
+
+/**
+ * Makes the back list the front list at the next vertical blank.
+ */
+void ratr0_swap_copper_lists(struct Ratr0CopperLists *copper)
+{
+    custom.cop1lc = (ULONG) copper->lists[copper->back];
+    // Shortly after line 0 the copper has already reloaded COP1LC for this
+    // frame, but the VERTB server might not have counted the vertical blank
+    // yet. The new list then only starts at the vertical blank after that.
+    UWORD line = ((*custom_vposr) >> 8) & 0x1ff;
+    BOOL uncounted = line < SWAP_WINDOW_LINES && (custom.intreqr & INTF_VERTB);
+    copper->swap_vblank = copper->sched->vblanks + (uncounted ? 1 : 0);
+    copper->back ^= 1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef __COPPER_LISTS_H__
+#define __COPPER_LISTS_H__
+
+#include <exec/types.h>
+#include "frame_scheduler.h"
+
+/*
+ * Double buffered copper lists.
+ *
+ * Two chip memory copies of a copper list: the copper executes the front
+ * list while the CPU writes the next frame into the back list.
+ * ratr0_swap_copper_lists() points COP1LC to the back list. The copper
+ * reloads COP1LC at the start of every vertical blank, so the new list
+ * takes effect at the next vertical blank and never in the middle of a
+ * frame.
+ * After a swap, the new back list is still executed until that vertical
+ * blank has passed. ratr0_copper_back_list() checks the vertical blank
+ * counter of the frame scheduler and only sleeps if the frame was late
+ * and the vertical blank has not happened yet. A swap right after line 0,
+ * before the scheduler has counted that vertical blank, waits for the
+ * following one.
+ */
+struct Ratr0CopperLists {
+    UWORD *lists[2];  // chip memory
+    ULONG size;       // size of a list in bytes
+    int back;         // index of the list the CPU writes to
+    struct Ratr0FrameScheduler *sched;  // counts the vertical blanks
+    ULONG swap_vblank;  // the back list is free once the counter is past this
+};
+
+extern BOOL ratr0_init_copper_lists(struct Ratr0CopperLists *copper,
+                                    UWORD *template, UWORD num_words,
+                                    struct Ratr0FrameScheduler *sched);
+extern void ratr0_free_copper_lists(struct Ratr0CopperLists *copper);
+extern UWORD *ratr0_copper_back_list(struct Ratr0CopperLists *copper);
+extern void ratr0_swap_copper_lists(struct Ratr0CopperLists *copper);
+
+#endif /* __COPPER_LISTS_H__ */
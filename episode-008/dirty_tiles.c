@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <string.h>
+#include <clib/exec_protos.h>
+
+#include "dirty_tiles.h"
+#include "blit_queue.h"
+
+// maximum height of a blit in lines
+#define MAX_BLIT_LINES (1024)
+
+/**
+ * Initializes an empty dirty map for a display area of the specified size.
+ *
+ * @param map the dirty map
+ * @param width width in tiles
+ * @param height height in tiles
+ * @return FALSE if the area is larger than the supported maximum
+ */
+BOOL ratr0_init_dirty_map(struct Ratr0DirtyMap *map, UWORD width, UWORD height)
+{
+    if (width > MAX_DIRTY_COLUMNS || height > MAX_DIRTY_ROWS) {
+        printf("ratr0_init_dirty_map() error: %dx%d tiles is too large\n", width, height);
+        return FALSE;
+    }
+    memset(map, 0, sizeof(struct Ratr0DirtyMap));
+    map->width = width;
+    map->height = height;
+    return TRUE;
+}
+
+/**
+ * Marks a single tile as dirty, coordinates outside of the map are ignored.
+ */
+void ratr0_mark_dirty_tile(struct Ratr0DirtyMap *map, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) return;
+    map->bits[y][x >> 4] |= 0x8000 >> (x & 15);
+    map->row_dirty[y] = TRUE;
+}
+
+/**
+ * Marks a rectangle of tiles as dirty, it is clipped to the map.
+ *
+ * @param map the dirty map
+ * @param x left tile column
+ * @param y top tile row
+ * @param width width in tiles
+ * @param height height in tiles
+ */
+void ratr0_mark_dirty_tiles(struct Ratr0DirtyMap *map, int x, int y, int width, int height)
+{
+    int x1 = x + width, y1 = y + height;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 > map->width) x1 = map->width;
+    if (y1 > map->height) y1 = map->height;
+    if (x >= x1 || y >= y1) return;
+
+    for (int row = y; row < y1; row++) {
+        UWORD *bits = map->bits[row];
+        // set whole words where possible
+        for (int col = x; col < x1; ) {
+            if ((col & 15) == 0 && col + 16 <= x1) {
+                bits[col >> 4] = 0xffff;
+                col += 16;
+            } else {
+                bits[col >> 4] |= 0x8000 >> (col & 15);
+                col++;
+            }
+        }
+        map->row_dirty[row] = TRUE;
+    }
+}
+
+/**
+ * Marks all tiles that are touched by a rectangle in pixel coordinates as
+ * dirty, e.g. the area below a bob.
+ */
+void ratr0_mark_dirty_area(struct Ratr0DirtyMap *map, int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0) return;
+    // shifts instead of divisions to round negative coordinates down
+    int tx0 = x >> DIRTY_TILE_SHIFT, ty0 = y >> DIRTY_TILE_SHIFT;
+    int tx1 = (x + width - 1) >> DIRTY_TILE_SHIFT;
+    int ty1 = (y + height - 1) >> DIRTY_TILE_SHIFT;
+    ratr0_mark_dirty_tiles(map, tx0, ty0, tx1 - tx0 + 1, ty1 - ty0 + 1);
+}
+
+void ratr0_mark_all_dirty(struct Ratr0DirtyMap *map)
+{
+    ratr0_mark_dirty_tiles(map, 0, 0, map->width, map->height);
+}
+
+// index + 1 of the rectangle that starts at a column, 0 if none
+static UBYTE open_rects[MAX_DIRTY_COLUMNS];
+
+static void add_span(struct Ratr0DirtyMap *map, int x, int y, int width)
+{
+    struct Ratr0DirtyRect *rect;
+    int idx = open_rects[x] - 1;
+
+    // the span continues a rectangle that ended in the row above
+    if (idx >= 0) {
+        rect = &map->rects[idx];
+        if (rect->x == x && rect->width == width && rect->y + rect->height == y) {
+            rect->height++;
+            return;
+        }
+    }
+    if (map->num_rects < MAX_DIRTY_RECTS) {
+        rect = &map->rects[map->num_rects++];
+        rect->x = x;
+        rect->y = y;
+        rect->width = width;
+        rect->height = 1;
+        open_rects[x] = map->num_rects;
+    } else {
+        // out of rectangles: grow the last one to include the span,
+        // redrawing a clean tile is harmless
+        rect = &map->rects[MAX_DIRTY_RECTS - 1];
+        int x1 = rect->x + rect->width;
+        if (x < rect->x) rect->x = x;
+        if (x + width > x1) x1 = x + width;
+        rect->width = x1 - rect->x;
+        rect->height = y - rect->y + 1;
+    }
+}
+
+/**
+ * Coalesces the dirty tiles into the map's rectangle list and clears the
+ * dirty tiles. The rectangles stay valid until the next call.
+ *
+ * @param map the dirty map
+ * @return the number of rectangles
+ */
+UWORD ratr0_coalesce_dirty_tiles(struct Ratr0DirtyMap *map)
+{
+    map->num_rects = 0;
+    memset(open_rects, 0, sizeof(open_rects));
+
+    for (int y = 0; y < map->height; y++) {
+        if (!map->row_dirty[y]) continue;
+        UWORD *bits = map->bits[y];
+        for (int x = 0; x < map->width; ) {
+            // skip the rest of the word if it is empty
+            if (!(UWORD) (bits[x >> 4] << (x & 15))) {
+                x = (x | 15) + 1;
+                continue;
+            }
+            if (!(bits[x >> 4] & (0x8000 >> (x & 15)))) {
+                x++;
+                continue;
+            }
+            int x0 = x;
+            while (x < map->width && (bits[x >> 4] & (0x8000 >> (x & 15)))) x++;
+            add_span(map, x0, y, x - x0);
+        }
+        memset(bits, 0, sizeof(map->bits[y]));
+        map->row_dirty[y] = FALSE;
+    }
+    return map->num_rects;
+}
+
+/**
+ * Redraws the tiles in the dirty rectangles from the level map. All tiles
+ * are blitted in a single batch through the blit queue.
+ *
+ * @param map the dirty map, ratr0_coalesce_dirty_tiles() has to be called first
+ * @param dst interleaved display buffer, the top left tile of the map
+ * @param row_bytes bytes per row in a single plane of the display
+ * @param level the level map
+ * @param level_x level column of the map's left tile column
+ * @param level_y level row of the map's top tile row
+ * @param tileset the tile set
+ */
+void ratr0_redraw_dirty_tiles(struct Ratr0DirtyMap *map, UBYTE *dst, int row_bytes,
+                              struct Ratr0Level *level, int level_x, int level_y,
+                              struct Ratr0TileSheet *tileset)
+{
+    if (map->num_rects == 0) return;
+    int tile_row_bytes = row_bytes * tileset->header.bmdepth * tileset->header.tile_height;
+
+    ratr0_begin_tile_batch(row_bytes - 2, tileset);
+    for (int i = 0; i < map->num_rects; i++) {
+        struct Ratr0DirtyRect *rect = &map->rects[i];
+        for (int y = rect->y; y < rect->y + rect->height; y++) {
+            UBYTE *tiles = level->lvldata + (level_y + y) * level->header.width + level_x;
+            UBYTE *curr_dst = dst + y * tile_row_bytes + rect->x * 2;
+            for (int x = rect->x; x < rect->x + rect->width; x++) {
+                ratr0_batch_blit_tile_by_index(curr_dst, tileset, tiles[x]);
+                curr_dst += 2;
+            }
+        }
+    }
+}
+
+/**
+ * Copies the dirty rectangles from a clean background with one blit per
+ * rectangle. Source and destination are interleaved and have the same layout.
+ *
+ * @param map the dirty map, ratr0_coalesce_dirty_tiles() has to be called first
+ * @param src the clean background
+ * @param dst the display buffer
+ * @param row_bytes bytes per row in a single plane
+ * @param bmdepth number of planes
+ */
+void ratr0_copy_dirty_rects(struct Ratr0DirtyMap *map, UBYTE *src, UBYTE *dst,
+                            int row_bytes, int bmdepth)
+{
+    struct Ratr0BlitCommand cmd;
+    int lines_per_tile = bmdepth << DIRTY_TILE_SHIFT;
+    int tile_row_bytes = row_bytes * lines_per_tile;
+    int max_rows = MAX_BLIT_LINES / lines_per_tile;
+
+    cmd.state.bltcon0 = 0x9f0;  // enable channels A and D, LF => D = A
+    cmd.state.bltcon1 = 0;
+    cmd.state.bltafwm = 0xffff;
+    cmd.state.bltalwm = 0xffff;
+    cmd.flags = 0;
+
+    for (int i = 0; i < map->num_rects; i++) {
+        struct Ratr0DirtyRect *rect = &map->rects[i];
+        int offset = rect->y * tile_row_bytes + rect->x * 2;
+        cmd.state.bltamod = cmd.state.bltdmod = row_bytes - rect->width * 2;
+
+        // split rectangles that exceed the maximum blit height
+        for (int y = 0; y < rect->height; y += max_rows) {
+            int rows = rect->height - y;
+            if (rows > max_rows) rows = max_rows;
+            cmd.bltapt = src + offset + y * tile_row_bytes;
+            cmd.bltdpt = dst + offset + y * tile_row_bytes;
+            // a height of 0 means 1024 lines
+            cmd.bltsize = (((rows * lines_per_tile) & 0x3ff) << 6) | (rect->width & 0x3f);
+            ratr0_blit_queue_enqueue(&cmd);
+        }
+    }
+}
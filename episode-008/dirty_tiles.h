@@ -0,0 +1,52 @@
+#pragma once
+#ifndef __DIRTY_TILES_H__
+#define __DIRTY_TILES_H__
+
+#include "tilesheet.h"
+
+/*
+ * Dirty rectangle tracking for tile map displays.
+ *
+ * Instead of redrawing whole rows or columns, the tiles that changed during
+ * a frame (destroyed blocks, animated tiles, areas below bobs) are marked
+ * in a bit map. Once per frame, the marked tiles are coalesced into
+ * rectangles: runs of dirty tiles within a tile row become spans and spans
+ * with the same position and width in consecutive tile rows are merged.
+ * Tiles are 16 pixels wide, so all rectangles are word aligned.
+ *
+ * The rectangles can then either be redrawn tile by tile from the level
+ * map or copied with a single blit each from a clean background buffer.
+ */
+#define DIRTY_TILE_SHIFT    (4)  // tiles are 16x16 pixels
+#define MAX_DIRTY_COLUMNS   (64)
+#define MAX_DIRTY_ROWS      (64)
+#define DIRTY_WORDS_PER_ROW (MAX_DIRTY_COLUMNS / 16)
+#define MAX_DIRTY_RECTS     (64)
+
+// rectangle in tile coordinates
+struct Ratr0DirtyRect {
+    UWORD x, y, width, height;
+};
+
+struct Ratr0DirtyMap {
+    UWORD width, height;  // in tiles
+    UBYTE row_dirty[MAX_DIRTY_ROWS];  // TRUE if the tile row has a dirty tile
+    UWORD bits[MAX_DIRTY_ROWS][DIRTY_WORDS_PER_ROW];  // one bit per tile, MSB first
+    UWORD num_rects;
+    struct Ratr0DirtyRect rects[MAX_DIRTY_RECTS];
+};
+
+extern BOOL ratr0_init_dirty_map(struct Ratr0DirtyMap *map, UWORD width, UWORD height);
+extern void ratr0_mark_dirty_tile(struct Ratr0DirtyMap *map, int x, int y);
+extern void ratr0_mark_dirty_tiles(struct Ratr0DirtyMap *map, int x, int y, int width, int height);
+extern void ratr0_mark_dirty_area(struct Ratr0DirtyMap *map, int x, int y, int width, int height);
+extern void ratr0_mark_all_dirty(struct Ratr0DirtyMap *map);
+extern UWORD ratr0_coalesce_dirty_tiles(struct Ratr0DirtyMap *map);
+
+extern void ratr0_redraw_dirty_tiles(struct Ratr0DirtyMap *map, UBYTE *dst, int row_bytes,
+                                     struct Ratr0Level *level, int level_x, int level_y,
+                                     struct Ratr0TileSheet *tileset);
+extern void ratr0_copy_dirty_rects(struct Ratr0DirtyMap *map, UBYTE *src, UBYTE *dst,
+                                   int row_bytes, int bmdepth);
+
+#endif /* __DIRTY_TILES_H__ */
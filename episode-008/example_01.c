@@ -35,7 +35,7 @@ extern struct Custom custom;
 #define DDFSTOP_VALUE      0x00d0
 
 // Settings for non-interleaved, 640 pixel wide image
-#define IMG_FILENAME "graphics/rocknroll_map.ts"
+#define IMG_FILENAME "graphics/rocknroll_map_lz.ts"
 #define BPLMOD_VALUE (40 + 80 * 4)
 
 // playfield control
@@ -35,7 +35,7 @@ extern struct Custom custom;
 #define DDFSTRT_VALUE      0x0030
 #define DDFSTOP_VALUE      0x00d0
 
-#define IMG_FILENAME "graphics/rocknroll_map.ts"
+#define IMG_FILENAME "graphics/rocknroll_map_lz.ts"
 
 // modulo is 1 word less
 #define BPLMOD_VALUE (40 + 80 * 4 - 2)
@@ -17,6 +17,8 @@
 #include <ahpc_registers.h>
 
 #include "tilesheet.h"
+#include "blit_queue.h"
+#include "dirty_tiles.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -141,6 +143,7 @@ static UBYTE __chip *display_buffer;
 //static struct Ratr0TileSheet background;
 static struct Ratr0TileSheet tileset;
 static struct Ratr0Level level;
+static struct Ratr0DirtyMap dirty_map;
 
 // To handle input
 static struct MsgPort *input_mp;
@@ -213,14 +216,11 @@ static void cleanup(void)
 void blit_row(UBYTE *dst, int row)
 {
     UBYTE *curr_dst = dst;
-    int tilenum, tx, ty;
-    int ly = row;
+    UBYTE *tiles = &level.lvldata[row * level.header.width];
 
+    ratr0_begin_tile_batch(DMOD, &tileset);
     for (int lx = 0; lx < HTILES; lx++) {
-        tilenum = level.lvldata[ly * level.header.width + lx] - 1;
-        tx = tilenum % tileset.header.num_tiles_h;
-        ty = tilenum / tileset.header.num_tiles_h;
-        ratr0_blit_tile(curr_dst, DMOD, &tileset, tx, ty);
+        ratr0_batch_blit_tile_by_index(curr_dst, &tileset, tiles[lx]);
         curr_dst += 2;
     }
 }
@@ -229,6 +229,26 @@ void blit_row(UBYTE *dst, int row)
 #define MAX_Y_POS    (832)
 #define SPEED (1)
 
+// a random visible tile is destroyed every DESTROY_FRAMES frames
+#define DESTROY_FRAMES (50)
+#define DESTROYED_TILE (1)  // level index of the first tile of the set
+
+/*
+ * Replaces a random tile in the visible tile rows with DESTROYED_TILE in
+ * the level and marks it as dirty. The tile is redrawn by the dirty tile
+ * renderer in the same frame and by blit_row() when it scrolls in again.
+ */
+static void destroy_tile(int level_row, int screen_row, int num_visible_rows)
+{
+    static ULONG seed = 1;
+    seed = seed * 1103515245 + 12345;
+    // the first and last visible tile rows can be partially displayed
+    int row = 1 + (seed >> 16) % (num_visible_rows - 2);
+    int col = (seed >> 8) % HTILES;
+    level.lvldata[(level_row + row) * level.header.width + col] = DESTROYED_TILE;
+    ratr0_mark_dirty_tile(&dirty_map, col, screen_row + row);
+}
+
 int main(int argc, char **argv)
 {
     if (!setup_input_handler()) {
@@ -253,6 +273,11 @@ int main(int argc, char **argv)
         cleanup();
         return 1;
     }
+    // the dirty map covers the whole display buffer
+    if (!ratr0_init_dirty_map(&dirty_map, HTILES, num_vtiles_total)) {
+        cleanup();
+        return 1;
+    }
 
     if (is_pal) {
         coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
@@ -281,22 +306,26 @@ int main(int argc, char **argv)
         addr += BYTES_PER_ROW;
     }
     OwnBlitter();
+    ratr0_blit_queue_install();
 
     // just as a reminder, the map is 68 tiles high
     int tx = 0, ty = 0, tilenum;
     int dest_offset;
+    // The initial screen goes through the dirty tile renderer: all tiles of
+    // the top half are dirty, which coalesces into a single rectangle
+    ratr0_mark_dirty_tiles(&dirty_map, 0, 0, HTILES, num_vtiles_per_half);
+    ratr0_coalesce_dirty_tiles(&dirty_map);
+
     /* Blit top half */
-    for (int ly = 0; ly < num_vtiles_per_half; ly++) {
-        dest_offset = ly * BYTES_PER_ROW * tileset.header.bmdepth * tileset.header.tile_height;
-        blit_row(display_buffer + dest_offset, ly);
-    }
+    ratr0_redraw_dirty_tiles(&dirty_map, display_buffer, BYTES_PER_ROW, &level, 0, 0, &tileset);
 
     /* Blit bottom half, which is the same as the top half */
-    for (int ly = 0; ly < num_vtiles_per_half; ly++) {
-        dest_offset = (ly + num_vtiles_per_half) * BYTES_PER_ROW * tileset.header.bmdepth
-            * tileset.header.tile_height;
-        blit_row(display_buffer + dest_offset, ly);
-    }
+    dest_offset = num_vtiles_per_half * BYTES_PER_ROW * tileset.header.bmdepth
+        * tileset.header.tile_height;
+    ratr0_redraw_dirty_tiles(&dirty_map, display_buffer + dest_offset, BYTES_PER_ROW,
+                             &level, 0, 0, &tileset);
+
+    ratr0_blit_queue_flush();
 
     // no sprite DMA
     custom.dmacon  = 0x0020;
@@ -307,8 +336,11 @@ int main(int argc, char **argv)
     int ypos = 0;  // logical y position (within the level)
     int y_offset = 0;  // y position within the display buffer
     int y_inc = SPEED;
+    int frame = 0;
 
     while (!should_exit) {
+        // make sure the incoming tiles are complete before the display is updated
+        ratr0_blit_queue_flush();
         wait_vblank();
 
         // update bitmap pointer: -> means update the display
@@ -365,7 +397,21 @@ int main(int argc, char **argv)
                 blit_row(display_buffer + dest_offset, level_row);
             }
         }
+
+        // destroyed tiles: only the dirty tiles are redrawn. The visible
+        // tile rows start at the display offset, so the map rows and the
+        // level rows differ by the same amount.
+        int top_level_row = ypos / 16, top_screen_row = y_offset / 16;
+        if (++frame == DESTROY_FRAMES) {
+            frame = 0;
+            destroy_tile(top_level_row, top_screen_row, num_vtiles_per_half - 2);
+        }
+        if (ratr0_coalesce_dirty_tiles(&dirty_map)) {
+            ratr0_redraw_dirty_tiles(&dirty_map, display_buffer, BYTES_PER_ROW, &level,
+                                     0, top_level_row - top_screen_row, &tileset);
+        }
     }
+    ratr0_blit_queue_uninstall();
     DisownBlitter();
     FreeMem(display_buffer, display_buffer_size);
     cleanup();
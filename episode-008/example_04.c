@@ -1,6 +1,12 @@
 /**
  * example_04.c - horizontal scrolling example (advanced)
  * Horizontal scrolling with a tile map
+ * The blitter DMA cycles used per frame and the time of each stage of the
+ * main loop are reported on exit
+ * The main loop is paced by a vertical blank interrupt instead of polling
+ * the beam position
+ * The copper list is double buffered, the scroll registers are written to
+ * the list that the copper is not executing
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +23,12 @@
 #include <ahpc_registers.h>
 
 #include "tilesheet.h"
+#include "blit_queue.h"
+#include "blit_cost.h"
+#include "profiler.h"
+#include "frame_scheduler.h"
+#include "copper_lists.h"
+#include "copper_builder.h"
 
 extern struct GfxBase *GfxBase;
 extern struct Custom custom;
@@ -39,18 +51,13 @@ extern struct Custom custom;
 // 5-3 and we need to set the playfield 2 priority bit (bit 6)
 #define BPLCON2_VALUE (0x0048)
 
-// copper instruction macros
-#define COP_MOVE(addr, data) addr, data
-#define COP_WAIT_END  0xffff, 0xfffe
-
-// copper list indexes
-#define COPLIST_IDX_DIWSTOP_VALUE (9)
-#define COPLIST_IDX_BPLCON1_VALUE (COPLIST_IDX_DIWSTOP_VALUE + 4)
-#define COPLIST_IDX_BPL1MOD_VALUE (COPLIST_IDX_DIWSTOP_VALUE + 8)
-#define COPLIST_IDX_BPL2MOD_VALUE (COPLIST_IDX_BPL1MOD_VALUE + 2)
-#define COPLIST_IDX_COLOR00_VALUE (COPLIST_IDX_BPL2MOD_VALUE + 2)
-#define COPLIST_IDX_BPL1PTH_VALUE (COPLIST_IDX_COLOR00_VALUE + 64)
+// fetched pixels per line (1 extra word for scrolling) and displayed lines
+#define FETCH_WIDTH        (336)
+#define DISPLAY_HEIGHT_PAL  (256)
+#define DISPLAY_HEIGHT_NTSC (200)
 
+// set to TRUE to show the main loop stages as COLOR00 raster bars
+#define PROFILE_RASTER_BARS (FALSE)
 
 // Interleaved playfield values
 #define NUM_BITPLANES     (5)
@@ -65,57 +72,15 @@ extern struct Custom custom;
 #define DMOD              (BYTES_PER_ROW -  2)
 #define PLANE_SIZE        (BYTES_PER_ROW * NUM_ROWS)
 
-static UWORD __chip coplist[] = {
-    COP_MOVE(FMODE,   0), // set fetch mode = 0
-
-    COP_MOVE(DDFSTRT, DDFSTRT_VALUE),
-    COP_MOVE(DDFSTOP, DDFSTOP_VALUE),
-    COP_MOVE(DIWSTRT, DIWSTRT_VALUE),
-    COP_MOVE(DIWSTOP, DIWSTOP_VALUE_PAL),
-    COP_MOVE(BPLCON0, BPLCON0_VALUE),
-    COP_MOVE(BPLCON1, 0),
-    COP_MOVE(BPLCON2, BPLCON2_VALUE),
-    COP_MOVE(BPL1MOD, BPL_MODULO),
-    COP_MOVE(BPL2MOD, BPL_MODULO),
-
-    // set up the display colors
-    COP_MOVE(COLOR00, 0x000), COP_MOVE(COLOR01, 0x000),
-    COP_MOVE(COLOR02, 0x000), COP_MOVE(COLOR03, 0x000),
-    COP_MOVE(COLOR04, 0x000), COP_MOVE(COLOR05, 0x000),
-    COP_MOVE(COLOR06, 0x000), COP_MOVE(COLOR07, 0x000),
-    COP_MOVE(COLOR08, 0x000), COP_MOVE(COLOR09, 0x000),
-    COP_MOVE(COLOR10, 0x000), COP_MOVE(COLOR11, 0x000),
-    COP_MOVE(COLOR12, 0x000), COP_MOVE(COLOR13, 0x000),
-    COP_MOVE(COLOR14, 0x000), COP_MOVE(COLOR15, 0x000),
-    COP_MOVE(COLOR16, 0x000), COP_MOVE(COLOR17, 0x000),
-    COP_MOVE(COLOR18, 0x000), COP_MOVE(COLOR19, 0x000),
-    COP_MOVE(COLOR20, 0x000), COP_MOVE(COLOR21, 0x000),
-    COP_MOVE(COLOR22, 0x000), COP_MOVE(COLOR23, 0x000),
-    COP_MOVE(COLOR24, 0x000), COP_MOVE(COLOR25, 0x000),
-    COP_MOVE(COLOR26, 0x000), COP_MOVE(COLOR27, 0x000),
-    COP_MOVE(COLOR28, 0x000), COP_MOVE(COLOR29, 0x000),
-    COP_MOVE(COLOR30, 0x000), COP_MOVE(COLOR31, 0x000),
-
-    COP_MOVE(BPL1PTH, 0), COP_MOVE(BPL1PTL, 0),
-    COP_MOVE(BPL2PTH, 0), COP_MOVE(BPL2PTL, 0),
-    COP_MOVE(BPL3PTH, 0), COP_MOVE(BPL3PTL, 0),
-    COP_MOVE(BPL4PTH, 0), COP_MOVE(BPL4PTL, 0),
-    COP_MOVE(BPL5PTH, 0), COP_MOVE(BPL5PTL, 0),
-
-    COP_WAIT_END,
-    COP_WAIT_END
-};
-
-static volatile ULONG *custom_vposr = (volatile ULONG *) 0xdff004;
-
-// Wait for this position for vertical blank
-// translated from http://eab.abime.net/showthread.php?t=51928
-static vb_waitpos;
+// size of a copper list: 52 MOVEs and the end marker
+#define COPLIST_WORDS (106)
 
-static void wait_vblank()
-{
-    while (((*custom_vposr) & 0x1ff00) != (vb_waitpos<<8)) ;
-}
+// the values that change every frame, one set per copper list
+struct CopperSlots {
+    UWORD *bplcon1;
+    struct Ratr0CopperBitplanes bitplanes;
+};
+static struct CopperSlots copper_slots[2];
 
 static BOOL init_display(void)
 {
@@ -211,15 +176,15 @@ static void cleanup(void)
 void blit_column(UBYTE *dst, int column)
 {
     UBYTE *curr_dst = dst;
-    int tilenum, tx, ty;
-    int lx = column;
+    UBYTE *tiles = &level.lvldata[column];
+    int level_width = level.header.width;
+    int dst_inc = BYTES_PER_ROW * tileset.header.tile_height * tileset.header.bmdepth;
 
+    ratr0_begin_tile_batch(DMOD, &tileset);
     for (int ly = 0; ly < VTILES; ly++) {
-        tilenum = level.lvldata[ly * level.header.width + lx] - 1;
-        tx = tilenum % tileset.header.num_tiles_h;
-        ty = tilenum / tileset.header.num_tiles_h;
-        ratr0_blit_tile(curr_dst, DMOD, &tileset, tx, ty);
-        curr_dst += BYTES_PER_ROW * tileset.header.tile_height * tileset.header.bmdepth;
+        ratr0_batch_blit_tile_by_index(curr_dst, &tileset, *tiles);
+        tiles += level_width;
+        curr_dst += dst_inc;
     }
 }
 
@@ -227,6 +192,35 @@ void blit_column(UBYTE *dst, int column)
 #define MIN_X_POS    (0)
 #define MAX_X_POS    (544)
 #define SPEED (1)
+// scroll by SPEED pixels every vertical blank, catch up at most 4 steps
+#define VBLANKS_PER_STEP (1)
+#define MAX_STEPS_PER_FRAME (4)
+
+static struct Ratr0FrameScheduler scheduler;
+static struct Ratr0CopperLists copper;
+
+static BOOL build_coplist(UWORD *list, struct CopperSlots *slots, BOOL is_pal)
+{
+    struct Ratr0CopperBuilder builder;
+    ratr0_copper_begin(&builder, list, COPLIST_WORDS);
+
+    ratr0_copper_move(&builder, FMODE, 0);  // set fetch mode = 0
+    ratr0_copper_move(&builder, DDFSTRT, DDFSTRT_VALUE);
+    ratr0_copper_move(&builder, DDFSTOP, DDFSTOP_VALUE);
+    ratr0_copper_move(&builder, DIWSTRT, DIWSTRT_VALUE);
+    ratr0_copper_move(&builder, DIWSTOP, is_pal ? DIWSTOP_VALUE_PAL : DIWSTOP_VALUE_NTSC);
+    ratr0_copper_move(&builder, BPLCON0, BPLCON0_VALUE);
+    slots->bplcon1 = ratr0_copper_move(&builder, BPLCON1, 0);
+    ratr0_copper_move(&builder, BPLCON2, BPLCON2_VALUE);
+    ratr0_copper_move(&builder, BPL1MOD, BPL_MODULO);
+    ratr0_copper_move(&builder, BPL2MOD, BPL_MODULO);
+
+    // the background palette and bitplanes, the data is non-interleaved
+    ratr0_copper_colors(&builder, 0, 1 << tileset.header.bmdepth, tileset.palette);
+    ratr0_copper_bitplanes(&builder, &slots->bitplanes, NUM_BITPLANES);
+    ratr0_set_copper_bitplanes(&slots->bitplanes, display_buffer, BYTES_PER_ROW);
+    return ratr0_copper_end(&builder);
+}
 
 int main(int argc, char **argv)
 {
@@ -251,34 +245,23 @@ int main(int argc, char **argv)
         cleanup();
         return 1;
     }
-
-    if (is_pal) {
-        coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_PAL;
-        vb_waitpos = 303;
-    } else {
-        coplist[COPLIST_IDX_DIWSTOP_VALUE] = DIWSTOP_VALUE_NTSC;
-        vb_waitpos = 262;
-    }
-
-    UBYTE num_colors = 1 << tileset.header.bmdepth;
-
-    // 1. copy the background palette to the copper list
-    for (int i = 0; i < num_colors; i++) {
-        coplist[COPLIST_IDX_COLOR00_VALUE + (i << 1)] = tileset.palette[i];
+    if (!ratr0_init_frame_scheduler(&scheduler, VBLANKS_PER_STEP, MAX_STEPS_PER_FRAME)) {
+        puts("Could not install vertical blank server");
+        cleanup();
+        return 1;
     }
 
-    // 2. prepare background bitplanes and point the copper list entries
-    // to the bitplanes. The data is non-interleaved.
-    int coplist_idx = COPLIST_IDX_BPL1PTH_VALUE;
-
-    ULONG addr = (ULONG) display_buffer;
-    for (int i = 0; i < 5; i++) {
-        coplist[coplist_idx] = (addr >> 16) & 0xffff;
-        coplist[coplist_idx + 2] = addr & 0xffff;
-        coplist_idx += 4; // next bitplane
-        addr += BYTES_PER_ROW;
+    if (!ratr0_init_copper_lists(&copper, NULL, COPLIST_WORDS, &scheduler) ||
+        !build_coplist(copper.lists[0], &copper_slots[0], is_pal) ||
+        !build_coplist(copper.lists[1], &copper_slots[1], is_pal)) {
+        puts("Could not allocate copper lists");
+        ratr0_free_copper_lists(&copper);
+        ratr0_free_frame_scheduler(&scheduler);
+        cleanup();
+        return 1;
     }
     OwnBlitter();
+    ratr0_blit_queue_install();
 
     // Blit left half
     for (int lx = 0; lx < HTILES_PER_HALF; lx++) {
@@ -290,10 +273,12 @@ int main(int argc, char **argv)
         blit_column(display_buffer + (HTILES_PER_HALF + lx) * 2, lx);
     }
 
+    ratr0_blit_queue_flush();
+
     // no sprite DMA
     custom.dmacon  = 0x0020;
-    // initialize and activate the copper list
-    custom.cop1lc = (ULONG) coplist;
+    // activate the first copper list
+    ratr0_swap_copper_lists(&copper);
 
     // the event loop
     int xpos = MIN_X_POS;  // logical x position (relative to the level)
@@ -301,12 +286,29 @@ int main(int argc, char **argv)
     int x_inc = SPEED;
 
     int num_pixels_shift, num_words_skip, blit_left, blit_right;
-    UWORD delay_mask = 0;
+    UWORD delay_mask = 0, steps;
 
-    while (!should_exit) {
-        wait_vblank();
+    struct Ratr0BlitBudget blit_budget;
+    ratr0_init_blit_budget(&blit_budget, is_pal, NUM_BITPLANES, FETCH_WIDTH,
+                           is_pal ? DISPLAY_HEIGHT_PAL : DISPLAY_HEIGHT_NTSC);
+    ratr0_set_blit_budget(&blit_budget);
 
-        blit_left = blit_right = 0;
+    struct Ratr0Profiler profiler;
+    ratr0_init_profiler(&profiler, is_pal, PROFILE_RASTER_BARS, tileset.palette[0]);
+    int stage_flush = ratr0_add_profile_stage(&profiler, "blit flush", 0xf00);
+    int stage_copper = ratr0_add_profile_stage(&profiler, "copper update", 0x0f0);
+    int stage_refill = ratr0_add_profile_stage(&profiler, "scroll refill", 0x00f);
+
+    while (!should_exit) {
+        // make sure the incoming tiles are complete before the display is updated
+        ratr0_profile_begin(&profiler, stage_flush);
+        ratr0_blit_queue_flush();
+        ratr0_profile_end(&profiler, stage_flush);
+        steps = ratr0_wait_frame(&scheduler);
+        ratr0_begin_blit_frame(&blit_budget);
+        ratr0_profile_begin(&profiler, stage_copper);
+        ratr0_copper_back_list(&copper);
+        struct CopperSlots *slots = &copper_slots[copper.back];
 
         // calculate the current pointers and delay values
         num_words_skip = x_offset / 16;
@@ -314,62 +316,73 @@ int main(int argc, char **argv)
         if (num_pixels_shift == 16) {
             num_words_skip--;
             num_pixels_shift = 0;
-            blit_left = 1;
-        } else if (num_pixels_shift == 8) {
-            blit_right = 1;
         }
         delay_mask = (num_pixels_shift << 4) | num_pixels_shift;
-        coplist[COPLIST_IDX_BPLCON1_VALUE] = delay_mask;
+        *slots->bplcon1 = delay_mask;
 
         // update bitmap pointer
-        coplist_idx = COPLIST_IDX_BPL1PTH_VALUE;
-        addr = (ULONG) display_buffer + num_words_skip * 2;
-        for (int i = 0; i < NUM_BITPLANES; i++) {
-            coplist[coplist_idx] = (addr >> 16) & 0xffff;
-            coplist[coplist_idx + 2] = addr & 0xffff;
-            coplist_idx += 4;
-            addr += BYTES_PER_ROW;
-        }
-
-        xpos += x_inc;
-        if (xpos <= MIN_X_POS) {
-            xpos = MIN_X_POS;
-            x_inc = SPEED;
-        } else if (xpos >= MAX_X_POS) {
-            xpos = MAX_X_POS;
-            x_inc = -SPEED;
-        }
-
-        // display buffer position, adjusted to the size
-        x_offset = xpos % SCREEN_WIDTH_PER_HALF;
-
-        if (blit_left || blit_right) {
-            // blit incoming column
-            int curr_level_col = xpos / 16;
-            int curr_screen_col = x_offset / 16;
-            int left_col_offset = -1;
-            int right_col_offset = HTILES_PER_HALF - 1;
-            int level_col = x_inc > 0 ? curr_level_col + right_col_offset  // scroll left -> add from the right
-                : curr_level_col + left_col_offset;  // scroll right -> add from the left
-
-            if (blit_left) {
-                // if the display window is all the way to the right, we blit the right column at
-                // the left of the display buffer
-                int left_col = curr_screen_col + left_col_offset;
-                if (left_col < 0) left_col = HTILES_TOTAL + left_col;
-                blit_column(display_buffer + left_col * 2, level_col);
+        ratr0_set_copper_bitplanes(&slots->bitplanes, display_buffer + num_words_skip * 2,
+                                   BYTES_PER_ROW);
+        // displayed from the next frame on
+        ratr0_swap_copper_lists(&copper);
+        ratr0_profile_end(&profiler, stage_copper);
+
+        // logic steps: every position we scroll over needs its column refill,
+        // even if it was not displayed because a frame was skipped
+        for (int step = 0; step < steps; step++) {
+            blit_left = (x_offset % 16) == 0;
+            blit_right = (x_offset % 16) == 8;
+
+            xpos += x_inc;
+            if (xpos <= MIN_X_POS) {
+                xpos = MIN_X_POS;
+                x_inc = SPEED;
+            } else if (xpos >= MAX_X_POS) {
+                xpos = MAX_X_POS;
+                x_inc = -SPEED;
             }
-            if (blit_right) {
-                // if the display window is all the way to the left, we blit the left column at the
-                // right side of the display buffer
-                int right_col = curr_screen_col + right_col_offset;
-                if (right_col >= HTILES_TOTAL) right_col = right_col - HTILES_TOTAL + 1;
-                blit_column(display_buffer + right_col * 2, level_col);
+
+            // display buffer position, adjusted to the size
+            x_offset = xpos % SCREEN_WIDTH_PER_HALF;
+
+            if (blit_left || blit_right) {
+                ratr0_profile_begin(&profiler, stage_refill);
+                // blit incoming column
+                int curr_level_col = xpos / 16;
+                int curr_screen_col = x_offset / 16;
+                int left_col_offset = -1;
+                int right_col_offset = HTILES_PER_HALF - 1;
+                int level_col = x_inc > 0 ? curr_level_col + right_col_offset  // scroll left -> add from the right
+                    : curr_level_col + left_col_offset;  // scroll right -> add from the left
+
+                if (blit_left) {
+                    // if the display window is all the way to the right, we blit the right column at
+                    // the left of the display buffer
+                    int left_col = curr_screen_col + left_col_offset;
+                    if (left_col < 0) left_col = HTILES_TOTAL + left_col;
+                    blit_column(display_buffer + left_col * 2, level_col);
+                }
+                if (blit_right) {
+                    // if the display window is all the way to the left, we blit the left column at the
+                    // right side of the display buffer
+                    int right_col = curr_screen_col + right_col_offset;
+                    if (right_col >= HTILES_TOTAL) right_col = right_col - HTILES_TOTAL + 1;
+                    blit_column(display_buffer + right_col * 2, level_col);
+                }
+                ratr0_profile_end(&profiler, stage_refill);
             }
         }
+        ratr0_end_blit_frame(&blit_budget);
     }
+    ratr0_set_blit_budget(NULL);
+    ratr0_blit_queue_uninstall();
     DisownBlitter();
+    ratr0_free_frame_scheduler(&scheduler);
     FreeMem(display_buffer, display_buffer_size);
     cleanup();
+    ratr0_free_copper_lists(&copper);
+    ratr0_print_blit_budget(&blit_budget);
+    ratr0_print_profile(&profiler);
+    ratr0_print_frame_stats(&scheduler);
     return 0;
 }
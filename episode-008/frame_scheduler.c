@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <exec/interrupts.h>
+#include <hardware/intbits.h>
+#include <clib/exec_protos.h>
+
+#include "frame_scheduler.h"
+
+static struct Ratr0FrameScheduler *scheduler;
+static struct Interrupt vertb_interrupt;
+
+/*
+ * VERTB interrupt server: counts the vertical blank and wakes up the
+ * main task. Returns 0 so the servers after it in the chain are called.
+ */
+ULONG vertb_server(void)
+{
+    scheduler->vblanks++;
+    Signal(scheduler->task, scheduler->signal_mask);
+    return 0;
+}
+
+/**
+ * Installs the vertical blank interrupt server for the calling task.
+ *
+ * @param sched the scheduler
+ * @param vblanks_per_step length of a logic step in vertical blanks
+ * @param max_steps maximum number of logic steps per frame
+ * @return FALSE if there is no free signal bit
+ */
+BOOL ratr0_init_frame_scheduler(struct Ratr0FrameScheduler *sched,
+                                UWORD vblanks_per_step, UWORD max_steps)
+{
+    sched->signal_bit = AllocSignal(-1);
+    if (sched->signal_bit == -1) return FALSE;
+    sched->signal_mask = 1L << sched->signal_bit;
+    sched->task = FindTask(NULL);
+    sched->vblanks = 0;
+    sched->vblanks_per_step = vblanks_per_step;
+    sched->max_steps = max_steps;
+    sched->last_vblank = 0;
+    sched->pending = 0;
+    sched->frames = sched->steps = 0;
+    sched->missed_frames = sched->dropped_steps = 0;
+    scheduler = sched;
+
+    vertb_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    vertb_interrupt.is_Node.ln_Pri = 0;
+    vertb_interrupt.is_Node.ln_Name = "ratr0_frame_scheduler";
+    vertb_interrupt.is_Data = 0;
+    vertb_interrupt.is_Code = (APTR) vertb_server;
+    AddIntServer(INTB_VERTB, &vertb_interrupt);
+    return TRUE;
+}
+
+void ratr0_free_frame_scheduler(struct Ratr0FrameScheduler *sched)
+{
+    RemIntServer(INTB_VERTB, &vertb_interrupt);
+    FreeSignal(sched->signal_bit);
+    scheduler = NULL;
+}
+
+/**
+ * Sleeps until the next vertical blank, unless one has already passed
+ * since the last frame.
+ *
+ * @param sched the scheduler
+ * @return the number of logic steps to run before rendering the frame,
+ *         can be 0 if a logic step is longer than a frame
+ */
+UWORD ratr0_wait_frame(struct Ratr0FrameScheduler *sched)
+{
+    ULONG now;
+    while ((now = sched->vblanks) == sched->last_vblank) Wait(sched->signal_mask);
+
+    ULONG elapsed = now - sched->last_vblank;
+    sched->last_vblank = now;
+    sched->frames++;
+    sched->missed_frames += elapsed - 1;
+
+    sched->pending += elapsed;
+    UWORD steps = 0;
+    while (sched->pending >= sched->vblanks_per_step) {
+        sched->pending -= sched->vblanks_per_step;
+        steps++;
+    }
+    if (steps > sched->max_steps) {
+        sched->dropped_steps += steps - sched->max_steps;
+        steps = sched->max_steps;
+    }
+    sched->steps += steps;
+    return steps;
+}
+
+void ratr0_print_frame_stats(struct Ratr0FrameScheduler *sched)
+{
+    printf("vblanks: %lu, frames: %lu, missed: %lu\n",
+           sched->vblanks, sched->frames, sched->missed_frames);
+    printf("logic steps: %lu, dropped: %lu\n", sched->steps, sched->dropped_steps);
+}
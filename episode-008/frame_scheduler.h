@@ -0,0 +1,44 @@
+#pragma once
+#ifndef __FRAME_SCHEDULER_H__
+#define __FRAME_SCHEDULER_H__
+
+#include <exec/types.h>
+#include <exec/tasks.h>
+
+/*
+ * Vertical blank frame scheduler.
+ *
+ * A VERTB interrupt server counts the vertical blanks and signals the
+ * main task, which sleeps in ratr0_wait_frame() instead of polling the
+ * beam position. The game logic runs at a fixed time step of
+ * vblanks_per_step vertical blanks: ratr0_wait_frame() returns how many
+ * logic steps are due since the last frame. If rendering took longer
+ * than a frame, several steps are due and the skipped frames are not
+ * rendered. The steps per frame are limited to max_steps, so a long
+ * stall doesn't trigger a burst of catch-up work.
+ *
+ * There can only be one scheduler at a time.
+ */
+struct Ratr0FrameScheduler {
+    struct Task *task;
+    BYTE signal_bit;
+    ULONG signal_mask;
+    volatile ULONG vblanks;  // counted by the interrupt server
+
+    UWORD vblanks_per_step, max_steps;
+    ULONG last_vblank;  // vblank count at the last frame
+    UWORD pending;      // vblanks that were not turned into steps yet
+
+    // statistics
+    ULONG frames, steps;
+    ULONG missed_frames;   // vblanks that passed without a frame
+    ULONG dropped_steps;   // steps over max_steps
+};
+
+extern BOOL ratr0_init_frame_scheduler(struct Ratr0FrameScheduler *sched,
+                                       UWORD vblanks_per_step, UWORD max_steps);
+extern void ratr0_free_frame_scheduler(struct Ratr0FrameScheduler *sched);
+extern UWORD ratr0_wait_frame(struct Ratr0FrameScheduler *sched);
+extern void ratr0_print_frame_stats(struct Ratr0FrameScheduler *sched);
+
+#endif /* __FRAME_SCHEDULER_H__ */
@@ -0,0 +1,40 @@
+#include <exec/types.h>
+#include "lz.h"
+
+/**
+ * Decompresses an LZ stream. All input is checked, so corrupt data can not
+ * write outside of the destination buffer.
+ *
+ * @param src compressed data
+ * @param src_size size of the compressed data in bytes
+ * @param dst destination buffer
+ * @param dst_size size of the destination buffer in bytes
+ * @return number of bytes written, 0 if the data is corrupt
+ */
+ULONG ratr0_lz_decompress(UBYTE *src, ULONG src_size, UBYTE *dst, ULONG dst_size)
+{
+    UBYTE *src_end = src + src_size;
+    UBYTE *dst_start = dst, *dst_end = dst + dst_size;
+    UBYTE *from;
+    UWORD c, n, offset;
+
+    while (src < src_end) {
+        c = *src++;
+        if (c < 0x80) {
+            // literal run
+            n = c + 1;
+            if (n > src_end - src || n > dst_end - dst) return 0;
+            do { *dst++ = *src++; } while (--n);
+        } else {
+            // match, the source can overlap the destination
+            if (src_end - src < 2) return 0;
+            n = (c & 0x7f) + LZ_MIN_MATCH;
+            offset = (src[0] << 8) | src[1];
+            src += 2;
+            if (offset == 0 || offset > dst - dst_start || n > dst_end - dst) return 0;
+            from = dst - offset;
+            do { *dst++ = *from++; } while (--n);
+        }
+    }
+    return dst - dst_start;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef __LZ_H__
+#define __LZ_H__
+
+/*
+ * Byte oriented LZ77 codec for compressed asset data.
+ *
+ * The compressed stream is a sequence of tokens, each starting with a
+ * control byte c:
+ *   c < 0x80:  literal run, the next c + 1 bytes are copied
+ *   c >= 0x80: match of (c & 0x7f) + LZ_MIN_MATCH bytes, followed by a
+ *              big endian 16 bit offset (1-65535) back into the output
+ *
+ * Bitplane data mostly consists of runs (offset 1 or 2) and repeated
+ * lines (offset = line or plane size), both are matches, so there is no
+ * separate run length token. Everything is byte aligned, so the
+ * decompressor does not need any bit shifting on the 68000.
+ * The compressor is tools/lz_compress.py.
+ */
+#define LZ_MIN_MATCH   (3)
+#define LZ_MAX_MATCH   (0x7f + LZ_MIN_MATCH)
+#define LZ_MAX_LITERAL (0x80)
+
+extern ULONG ratr0_lz_decompress(UBYTE *src, ULONG src_size, UBYTE *dst, ULONG dst_size);
+
+#endif /* __LZ_H__ */
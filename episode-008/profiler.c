@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <hardware/custom.h>
+
+#include "profiler.h"
+
+extern struct Custom custom;
+
+#define PAL_LINES_PER_FRAME (313)
+#define NTSC_LINES_PER_FRAME (263)
+
+// VPOSR and VHPOSR read as a single long word, V8 is in bit 16
+static volatile ULONG *custom_vposr = (volatile ULONG *) 0xdff004;
+
+static UWORD beam_line(void)
+{
+    return ((*custom_vposr) >> 8) & 0x1ff;
+}
+
+/**
+ * Initializes the profiler without any stages.
+ *
+ * @param profiler the profiler
+ * @param is_pal TRUE for PAL, FALSE for NTSC, determines the wrap around
+ *        of the beam position
+ * @param raster_bars if TRUE, show the stages as COLOR00 raster bars
+ * @param background_color COLOR00 value that is restored after each stage
+ */
+void ratr0_init_profiler(struct Ratr0Profiler *profiler, BOOL is_pal,
+                         BOOL raster_bars, UWORD background_color)
+{
+    profiler->num_stages = 0;
+    profiler->lines_per_frame = is_pal ? PAL_LINES_PER_FRAME : NTSC_LINES_PER_FRAME;
+    profiler->raster_bars = raster_bars;
+    profiler->background_color = background_color;
+}
+
+/**
+ * Adds a stage to the profiler.
+ *
+ * @param profiler the profiler
+ * @param name stage name for the report, not copied
+ * @param color COLOR00 value for raster bar mode
+ * @return the stage number or -1 if there are already MAX_PROFILE_STAGES
+ */
+int ratr0_add_profile_stage(struct Ratr0Profiler *profiler, const char *name,
+                            UWORD color)
+{
+    if (profiler->num_stages == MAX_PROFILE_STAGES) return -1;
+    struct Ratr0ProfileStage *stage = &profiler->stages[profiler->num_stages];
+    stage->name = name;
+    stage->color = color;
+    stage->start_line = 0;
+    stage->count = stage->total_lines = 0;
+    stage->min_lines = 0xffff;
+    stage->max_lines = 0;
+    for (int i = 0; i < PROFILE_NUM_BUCKETS; i++) stage->histogram[i] = 0;
+    return profiler->num_stages++;
+}
+
+void ratr0_profile_begin(struct Ratr0Profiler *profiler, int stage)
+{
+    if (profiler->raster_bars) custom.color[0] = profiler->stages[stage].color;
+    profiler->stages[stage].start_line = beam_line();
+}
+
+void ratr0_profile_end(struct Ratr0Profiler *profiler, int stage)
+{
+    UWORD end_line = beam_line();
+    struct Ratr0ProfileStage *s = &profiler->stages[stage];
+    if (profiler->raster_bars) custom.color[0] = profiler->background_color;
+
+    // the beam wrapped around at the end of the frame
+    if (end_line < s->start_line) end_line += profiler->lines_per_frame;
+    UWORD lines = end_line - s->start_line;
+
+    s->count++;
+    s->total_lines += lines;
+    if (lines < s->min_lines) s->min_lines = lines;
+    if (lines > s->max_lines) s->max_lines = lines;
+    UWORD bucket = lines >> PROFILE_BUCKET_SHIFT;
+    if (bucket >= PROFILE_NUM_BUCKETS) bucket = PROFILE_NUM_BUCKETS - 1;
+    s->histogram[bucket]++;
+}
+
+void ratr0_print_profile(struct Ratr0Profiler *profiler)
+{
+    for (int i = 0; i < profiler->num_stages; i++) {
+        struct Ratr0ProfileStage *s = &profiler->stages[i];
+        if (!s->count) {
+            printf("%s: not run\n", s->name);
+            continue;
+        }
+        printf("%s: %lu runs, lines min %u avg %lu max %u\n", s->name, s->count,
+               s->min_lines, s->total_lines / s->count, s->max_lines);
+        for (int b = 0; b < PROFILE_NUM_BUCKETS; b++) {
+            if (!s->histogram[b]) continue;
+            printf("  %3d-%3d lines: %lu\n", b * PROFILE_BUCKET_LINES,
+                   (b + 1) * PROFILE_BUCKET_LINES - 1, s->histogram[b]);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <exec/types.h>
+
+/*
+ * Raster beam profiler.
+ *
+ * The time a stage of the main loop takes is measured in scan lines by
+ * sampling the beam position (VPOSR/VHPOSR) at ratr0_profile_begin() and
+ * ratr0_profile_end(). The line counts are accumulated per stage into
+ * histograms with PROFILE_BUCKET_LINES lines per bucket, that
+ * ratr0_print_profile() dumps on exit.
+ * In raster bar mode, COLOR00 is set to the stage color while a stage
+ * runs, so the stages can also be watched on screen.
+ *
+ * A stage is expected to take less than a frame, the beam position
+ * can't tell how many frames have passed.
+ */
+#define MAX_PROFILE_STAGES (8)
+#define PROFILE_BUCKET_SHIFT (4)
+#define PROFILE_BUCKET_LINES (1 << PROFILE_BUCKET_SHIFT)
+#define PROFILE_NUM_BUCKETS (20)  // 320 lines
+
+struct Ratr0ProfileStage {
+    const char *name;
+    UWORD color;       // raster bar color
+    UWORD start_line;  // beam position at ratr0_profile_begin()
+    ULONG count, total_lines;
+    UWORD min_lines, max_lines;
+    ULONG histogram[PROFILE_NUM_BUCKETS];
+};
+
+struct Ratr0Profiler {
+    struct Ratr0ProfileStage stages[MAX_PROFILE_STAGES];
+    UWORD num_stages;
+    UWORD lines_per_frame;
+    BOOL raster_bars;
+    UWORD background_color;  // COLOR00 value outside of the stages
+};
+
+extern void ratr0_init_profiler(struct Ratr0Profiler *profiler, BOOL is_pal,
+                                BOOL raster_bars, UWORD background_color);
+extern int ratr0_add_profile_stage(struct Ratr0Profiler *profiler, const char *name,
+                                   UWORD color);
+extern void ratr0_profile_begin(struct Ratr0Profiler *profiler, int stage);
+extern void ratr0_profile_end(struct Ratr0Profiler *profiler, int stage);
+extern void ratr0_print_profile(struct Ratr0Profiler *profiler);
+
+#endif /* __PROFILER_H__ */
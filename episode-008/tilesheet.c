@@ -1,35 +1,146 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <hardware/custom.h>
+#include <dos/dos.h>
 #include <clib/exec_protos.h>
+#include <clib/dos_protos.h>
 #include <clib/graphics_protos.h>
 #include "tilesheet.h"
+#include "lz.h"
+#include "blit_cost.h"
+
+/*
+ * Builds the tile lookup table, so blitting a tile from a level byte
+ * does not need any division or multiplication. Tiles are 1 word wide
+ * and the data is interleaved.
+ */
+static BOOL build_tile_table(struct Ratr0TileSheet *sheet)
+{
+    int num_tiles_h = sheet->header.num_tiles_h;
+    int num_tiles = num_tiles_h * sheet->header.num_tiles_v;
+    int tile_row_bytes = num_tiles_h * 2 * sheet->header.tile_height * sheet->header.bmdepth;
+    UBYTE *src = sheet->imgdata;
+
+    sheet->tile_src = AllocMem(TILE_TABLE_SIZE * sizeof(UBYTE *), MEMF_CLEAR);
+    if (!sheet->tile_src) return FALSE;
+
+    // level byte 0 is not a valid tile, let it point to the first tile
+    sheet->tile_src[0] = src;
+    for (int i = 0; i < num_tiles && i < TILE_TABLE_SIZE - 1; i++) {
+        int tx = i % num_tiles_h;
+        int ty = i / num_tiles_h;
+        sheet->tile_src[i + 1] = src + ty * tile_row_bytes + tx * 2;
+    }
+    sheet->tile_amod = (num_tiles_h - 1) * 2;
+    sheet->tile_bltsize = (UWORD) ((sheet->header.tile_height * sheet->header.bmdepth) << 6) | 1;
+    return TRUE;
+}
+
+/*
+ * Reads exactly size bytes with a single unbuffered dos.library Read().
+ * A short read means that the file is truncated.
+ */
+static BOOL read_fully(BPTR fh, APTR buffer, LONG size)
+{
+    return size == 0 || Read(fh, buffer, size) == size;
+}
+
+/**
+ * Computes the checksum that is stored in the asset file headers: the 16 bit
+ * sum of the data words. A checksum of 0 in a header means "not set".
+ *
+ * @param data pointer to the data
+ * @param size size of the data in bytes, a trailing odd byte is the high byte
+ * @return checksum
+ */
+UWORD ratr0_checksum(UBYTE *data, ULONG size)
+{
+    UWORD sum = 0;
+    UWORD *words = (UWORD *) data;
+    for (ULONG i = 0; i < size / 2; i++) sum += words[i];
+    if (size & 1) sum += data[size - 1] << 8;
+    return sum;
+}
+
+/*
+ * Reads the compressed image data into a temporary buffer and decompresses
+ * it into the chip memory image data.
+ * Returns an error message or NULL on success.
+ */
+static const char *read_compressed_imgdata(BPTR fh, struct Ratr0TileSheet *sheet)
+{
+    ULONG packed_size;
+    UBYTE *packed;
+    const char *error = NULL;
+
+    if (!read_fully(fh, &packed_size, sizeof(ULONG))) return "truncated image data";
+    if (!(packed = AllocMem(packed_size, MEMF_ANY))) return "not enough memory";
+    if (!read_fully(fh, packed, packed_size)) {
+        error = "truncated image data";
+    } else if (ratr0_lz_decompress(packed, packed_size, sheet->imgdata,
+                                   sheet->header.imgdata_size) != sheet->header.imgdata_size) {
+        error = "corrupt compressed data";
+    }
+    FreeMem(packed, packed_size);
+    return error;
+}
 
 /**
  * Reads the image information from specified RATR0 tile sheet file.
+ * The header is read and validated first, then the palette and the image
+ * data is read directly into chip memory. Compressed image data
+ * (TSFLAGS_COMPRESSED) is decompressed into chip memory.
  *
  * @param filename path to the tile sheet file
  * @param sheet pointer to a Ratr0TileSheet structure
+ * @return 1 on success, 0 on error
  */
 ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
 {
-    int elems_read;
-    ULONG retval = 0;
-
-    FILE *fp = fopen(filename, "rb");
-
-    if (fp) {
-        int num_img_bytes;
-        elems_read = fread(&sheet->header, sizeof(struct Ratr0TileSheetHeader), 1, fp);
-        elems_read = fread(&sheet->palette, sizeof(UWORD), sheet->header.palette_size, fp);
-        sheet->imgdata = AllocMem(sheet->header.imgdata_size, MEMF_CHIP|MEMF_CLEAR);
-        elems_read = fread(sheet->imgdata, sizeof(unsigned char), sheet->header.imgdata_size, fp);
-        fclose(fp);
-        return 1;
-    } else {
+    struct Ratr0TileSheetHeader *header = &sheet->header;
+    const char *error = NULL;
+
+    sheet->imgdata = NULL;
+    sheet->tile_src = NULL;
+    BPTR fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!fh) {
         printf("ratr0_read_tilesheet() error: file '%s' not found\n", filename);
         return 0;
     }
+    if (!read_fully(fh, header, sizeof(struct Ratr0TileSheetHeader))) {
+        error = "truncated header";
+    } else if (memcmp(header->id, TILESHEET_ID, FILE_ID_LEN)) {
+        error = "not a tile sheet";
+    } else if (header->version != TILESHEET_VERSION) {
+        error = "unsupported version";
+    } else if (header->palette_size > MAX_PALETTE_SIZE) {
+        error = "palette too large";
+    } else if (header->imgdata_size < (ULONG) header->width / 8 * header->height * header->bmdepth) {
+        error = "image data too small";
+    } else if (!read_fully(fh, sheet->palette, header->palette_size * sizeof(UWORD))) {
+        error = "truncated palette";
+    } else if (!(sheet->imgdata = AllocMem(header->imgdata_size, MEMF_CHIP))) {
+        error = "not enough chip memory";
+    } else if (header->flags & TSFLAGS_COMPRESSED) {
+        error = read_compressed_imgdata(fh, sheet);
+    } else if (!read_fully(fh, sheet->imgdata, header->imgdata_size)) {
+        error = "truncated image data";
+    }
+    Close(fh);
+
+    if (!error && header->checksum &&
+        ratr0_checksum(sheet->imgdata, header->imgdata_size) != header->checksum) {
+        error = "checksum mismatch";
+    }
+    if (!error && !build_tile_table(sheet)) error = "could not allocate tile table";
+
+    if (error) {
+        printf("ratr0_read_tilesheet() error: '%s': %s\n", filename, error);
+        ratr0_free_tilesheet_data(sheet);
+        return 0;
+    }
+    return 1;
 }
 
 /**
@@ -37,7 +148,11 @@ ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet)
  */
 void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet)
 {
-    if (sheet && sheet->imgdata) FreeMem(sheet->imgdata, sheet->header.imgdata_size);
+    if (!sheet) return;
+    if (sheet->imgdata) FreeMem(sheet->imgdata, sheet->header.imgdata_size);
+    if (sheet->tile_src) FreeMem(sheet->tile_src, TILE_TABLE_SIZE * sizeof(UBYTE *));
+    sheet->imgdata = NULL;
+    sheet->tile_src = NULL;
 }
 
 /**
@@ -45,26 +160,43 @@ void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet)
  *
  * @param filename path to the level file
  * @param level pointer to a Ratr0Level structure
+ * @return TRUE on success
  */
 BOOL ratr0_read_level(const char *filename, struct Ratr0Level *level)
 {
-    int elems_read;
-    BOOL retval;
-
-    FILE *fp = fopen(filename, "rb");
-
-    if (fp) {
-        int num_img_bytes, data_size;
-        elems_read = fread(&level->header, sizeof(struct Ratr0LevelHeader), 1, fp);
-        data_size = sizeof(UBYTE) * level->header.width * level->header.height;
-        level->lvldata = malloc(data_size);
-        elems_read = fread(level->lvldata, sizeof(unsigned char), data_size, fp);
-        fclose(fp);
-        return TRUE;
-    } else {
+    struct Ratr0LevelHeader *header = &level->header;
+    const char *error = NULL;
+    ULONG data_size = 0;
+
+    level->lvldata = NULL;
+    BPTR fh = Open((CONST_STRPTR) filename, MODE_OLDFILE);
+    if (!fh) {
         printf("ratr0_read_level() error: file '%s' not found\n", filename);
         return FALSE;
     }
+    if (!read_fully(fh, header, sizeof(struct Ratr0LevelHeader))) {
+        error = "truncated header";
+    } else if (memcmp(header->id, LEVEL_ID, FILE_ID_LEN)) {
+        error = "not a level";
+    } else if (header->version != LEVEL_VERSION) {
+        error = "unsupported version";
+    } else if ((data_size = (ULONG) header->width * header->height) == 0) {
+        error = "empty level";
+    } else if (!(level->lvldata = malloc(data_size))) {
+        error = "out of memory";
+    } else if (!read_fully(fh, level->lvldata, data_size)) {
+        error = "truncated level data";
+    } else if (header->checksum && ratr0_checksum(level->lvldata, data_size) != header->checksum) {
+        error = "checksum mismatch";
+    }
+    Close(fh);
+
+    if (error) {
+        printf("ratr0_read_level() error: '%s': %s\n", filename, error);
+        ratr0_free_level_data(level);
+        return FALSE;
+    }
+    return TRUE;
 }
 
 /**
@@ -73,6 +205,7 @@ BOOL ratr0_read_level(const char *filename, struct Ratr0Level *level)
 void ratr0_free_level_data(struct Ratr0Level *level)
 {
     if (level && level->lvldata) free(level->lvldata);
+    if (level) level->lvldata = NULL;
 }
 
 
@@ -105,4 +238,24 @@ void ratr0_blit_tile(UBYTE *dst, int dmod, struct Ratr0TileSheet *tileset, int t
     custom.bltcdat = 0xffff;
 
     custom.bltsize = (UWORD) (height << 6) | (num_words & 0x3f);
+    ratr0_account_blit(0x9f0, 0, (UWORD) (height << 6) | (num_words & 0x3f));
+}
+
+/**
+ * Same as ratr0_blit_tile(), but takes the tile number + 1 as it is stored in
+ * the level data and looks up the source in the tile table.
+ */
+void ratr0_blit_tile_by_index(UBYTE *dst, int dmod, struct Ratr0TileSheet *tileset, UBYTE index)
+{
+    WaitBlit();
+    custom.bltcon0 = 0x9f0;       // enable channels A and D, LF => D = A
+    custom.bltcon1 = 0;            // copy direction: asc
+    custom.bltapt = tileset->tile_src[index];
+    custom.bltdpt = dst;
+    custom.bltamod = tileset->tile_amod;
+    custom.bltdmod = dmod;
+    custom.bltafwm = 0xffff;
+    custom.bltalwm = 0xffff;
+    custom.bltsize = tileset->tile_bltsize;
+    ratr0_account_blit(0x9f0, 0, tileset->tile_bltsize);
 }
@@ -4,6 +4,10 @@
 
 // information about a tile sheet
 #define FILE_ID_LEN (8)
+#define TILESHEET_ID "RATR0TIL"
+#define TILESHEET_VERSION (2)
+#define LEVEL_ID "RATR0LVL"
+#define LEVEL_VERSION (1)
 
 // information about a tile sheet
 // File format version 2
@@ -22,16 +26,31 @@ struct Ratr0TileSheetHeader {
     UWORD checksum;
 };
 
+// header flags
+// the image data is compressed (see lz.h), imgdata_size is the uncompressed size
+// and the compressed size is stored as a ULONG before the image data
+#define TSFLAGS_COMPRESSED (0x10)
+
 #define MAX_PALETTE_SIZE (32)
+// number of entries in the tile lookup table, indexed by a level byte
+#define TILE_TABLE_SIZE (256)
+
 struct Ratr0TileSheet {
     struct Ratr0TileSheetHeader header;
     UWORD palette[MAX_PALETTE_SIZE];
     UBYTE *imgdata;
+
+    // built at load time: source pointer for every level byte value
+    // (tile number + 1), blit modulo and size for a single tile
+    UBYTE **tile_src;
+    UWORD tile_amod, tile_bltsize;
 };
 
+extern UWORD ratr0_checksum(UBYTE *data, ULONG size);
 extern ULONG ratr0_read_tilesheet(const char *filename, struct Ratr0TileSheet *sheet);
 extern void ratr0_free_tilesheet_data(struct Ratr0TileSheet *sheet);
 extern void ratr0_blit_tile(UBYTE *dst, int dmod, struct Ratr0TileSheet *tileset, int tx, int ty);
+extern void ratr0_blit_tile_by_index(UBYTE *dst, int dmod, struct Ratr0TileSheet *tileset, UBYTE index);
 
 
 struct Ratr0LevelHeader {
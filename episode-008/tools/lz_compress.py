@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""lz_compress.py - compresses RATR0 tile sheets for ratr0_read_tilesheet()
+
+The image data is compressed with the LZ codec described in lz.h, the
+header gets the TSFLAGS_COMPRESSED flag and the compressed data size is
+stored as a big endian 32 bit value between the palette and the data.
+imgdata_size and the checksum always refer to the uncompressed data.
+
+usage: lz_compress.py <input.ts> <output.ts>
+"""
+import argparse
+import struct
+
+HEADER_FORMAT = '>8sBBBBHHHHHHHLH'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+TSFLAGS_COMPRESSED = 0x10
+
+MIN_MATCH = 3
+MAX_MATCH = 0x7f + MIN_MATCH
+MAX_LITERAL = 0x80
+MAX_OFFSET = 0xffff
+MAX_CHAIN = 128
+
+
+def find_match(data, pos, chains):
+    """longest match for the data at pos, returns (length, offset)"""
+    best_len, best_offset = 0, 0
+    max_len = min(MAX_MATCH, len(data) - pos)
+    if max_len < MIN_MATCH:
+        return 0, 0
+    candidates = chains.get(data[pos:pos + MIN_MATCH], [])
+    for cand in reversed(candidates[-MAX_CHAIN:]):
+        offset = pos - cand
+        if offset > MAX_OFFSET:
+            break
+        length = MIN_MATCH
+        while length < max_len and data[cand + length] == data[pos + length]:
+            length += 1
+        if length > best_len:
+            best_len, best_offset = length, offset
+            if length == max_len:
+                break
+    return best_len, best_offset
+
+
+def insert(data, pos, chains):
+    if pos + MIN_MATCH <= len(data):
+        chains.setdefault(data[pos:pos + MIN_MATCH], []).append(pos)
+
+
+def compress(data):
+    out = bytearray()
+    literals = bytearray()
+    chains = {}
+
+    def flush_literals():
+        for i in range(0, len(literals), MAX_LITERAL):
+            chunk = literals[i:i + MAX_LITERAL]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+        literals.clear()
+
+    pos = 0
+    while pos < len(data):
+        length, offset = find_match(data, pos, chains)
+        # lazy matching: prefer a longer match that starts at the next byte
+        if length >= MIN_MATCH and pos + 1 < len(data):
+            insert(data, pos, chains)
+            next_length, _ = find_match(data, pos + 1, chains)
+            if next_length > length + 1:
+                literals.append(data[pos])
+                pos += 1
+                continue
+            chains[data[pos:pos + MIN_MATCH]].pop()
+        if length >= MIN_MATCH:
+            flush_literals()
+            out.append(0x80 | (length - MIN_MATCH))
+            out.extend(struct.pack('>H', offset))
+            for i in range(length):
+                insert(data, pos + i, chains)
+            pos += length
+        else:
+            insert(data, pos, chains)
+            literals.append(data[pos])
+            pos += 1
+    flush_literals()
+    return bytes(out)
+
+
+def decompress(data):
+    """reference decompressor, used to verify the output"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        c = data[pos]
+        pos += 1
+        if c < 0x80:
+            out.extend(data[pos:pos + c + 1])
+            pos += c + 1
+        else:
+            offset = (data[pos] << 8) | data[pos + 1]
+            pos += 2
+            for i in range((c & 0x7f) + MIN_MATCH):
+                out.append(out[-offset])
+    return bytes(out)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='compress a RATR0 tile sheet')
+    parser.add_argument('infile')
+    parser.add_argument('outfile')
+    args = parser.parse_args()
+
+    with open(args.infile, 'rb') as infile:
+        sheet = infile.read()
+    header = list(struct.unpack(HEADER_FORMAT, sheet[:HEADER_SIZE]))
+    flags, palette_size, imgdata_size = header[2], header[11], header[12]
+    if flags & TSFLAGS_COMPRESSED:
+        raise SystemExit('%s is already compressed' % args.infile)
+    imgdata_offset = HEADER_SIZE + palette_size * 2
+    imgdata = sheet[imgdata_offset:imgdata_offset + imgdata_size]
+    packed = compress(imgdata)
+    assert decompress(packed) == imgdata
+
+    header[2] = flags | TSFLAGS_COMPRESSED
+    with open(args.outfile, 'wb') as outfile:
+        outfile.write(struct.pack(HEADER_FORMAT, *header))
+        outfile.write(sheet[HEADER_SIZE:imgdata_offset])
+        outfile.write(struct.pack('>L', len(packed)))
+        outfile.write(packed)
+    print('%s: %d -> %d bytes' % (args.outfile, imgdata_size, len(packed)))